@@ -0,0 +1,180 @@
+/*--------------------------------------------------------------------*/
+/* buffer.c                                                           */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "buffer.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The minimum capacity of a Buffer object. */
+
+enum {MIN_CAPACITY = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* A Buffer consists of an array of characters, along with the number
+   of characters in use and the number that fit before growing. */
+
+struct Buffer
+{
+   /* The number of characters in the Buffer. */
+   size_t uLength;
+
+   /* The number of characters that the array can hold, not counting
+      the terminating null character. */
+   size_t uCapacity;
+
+   /* The array that underlies the Buffer. */
+   char *pcChars;
+};
+
+/*--------------------------------------------------------------------*/
+
+#ifndef NDEBUG
+
+/* Check the invariants of oBuffer.  Return 1 (TRUE) iff oBuffer is in
+   a valid state. */
+
+static int Buffer_isValid(Buffer_T oBuffer)
+{
+   if (oBuffer->uCapacity < MIN_CAPACITY) return 0;
+   if (oBuffer->uLength > oBuffer->uCapacity) return 0;
+   if (oBuffer->pcChars == NULL) return 0;
+   if (oBuffer->pcChars[oBuffer->uLength] != '\0') return 0;
+   return 1;
+}
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Increase the capacity of oBuffer so that it can hold at least
+   uMinCapacity characters.  Return 1 (TRUE) if successful and
+   0 (FALSE) if insufficient memory is available. */
+
+static int Buffer_grow(Buffer_T oBuffer, size_t uMinCapacity)
+{
+   enum {GROWTH_FACTOR = 2};
+
+   size_t uNewCapacity;
+   char *pcNewChars;
+
+   assert(oBuffer != NULL);
+
+   /* Grow geometrically, so that appending n characters one piece at
+      a time costs O(n) in total. */
+   uNewCapacity = oBuffer->uCapacity;
+   while (uNewCapacity < uMinCapacity)
+      uNewCapacity *= GROWTH_FACTOR;
+
+   pcNewChars = (char*)realloc(oBuffer->pcChars, uNewCapacity + 1);
+   if (pcNewChars == NULL)
+      return 0;
+
+   oBuffer->uCapacity = uNewCapacity;
+   oBuffer->pcChars = pcNewChars;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+Buffer_T Buffer_new(size_t uCapacity)
+{
+   Buffer_T oBuffer;
+
+   oBuffer = (struct Buffer*)malloc(sizeof(struct Buffer));
+   if (oBuffer == NULL)
+      return NULL;
+
+   if (uCapacity < MIN_CAPACITY)
+      uCapacity = MIN_CAPACITY;
+
+   oBuffer->pcChars = (char*)malloc(uCapacity + 1);
+   if (oBuffer->pcChars == NULL)
+   {
+      free(oBuffer);
+      return NULL;
+   }
+   oBuffer->pcChars[0] = '\0';
+   oBuffer->uLength = 0;
+   oBuffer->uCapacity = uCapacity;
+
+   return oBuffer;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Buffer_free(Buffer_T oBuffer)
+{
+   assert(oBuffer != NULL);
+   assert(Buffer_isValid(oBuffer));
+
+   free(oBuffer->pcChars);
+   free(oBuffer);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Buffer_getLength(Buffer_T oBuffer)
+{
+   assert(oBuffer != NULL);
+   assert(Buffer_isValid(oBuffer));
+
+   return oBuffer->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+char *Buffer_getData(Buffer_T oBuffer)
+{
+   assert(oBuffer != NULL);
+   assert(Buffer_isValid(oBuffer));
+
+   return oBuffer->pcChars;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Buffer_clear(Buffer_T oBuffer)
+{
+   assert(oBuffer != NULL);
+   assert(Buffer_isValid(oBuffer));
+
+   oBuffer->uLength = 0;
+   oBuffer->pcChars[0] = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
+int Buffer_append(Buffer_T oBuffer, const char *pcChars,
+                  size_t uLength)
+{
+   assert(oBuffer != NULL);
+   assert(pcChars != NULL || uLength == 0);
+   assert(Buffer_isValid(oBuffer));
+
+   if (oBuffer->uLength + uLength > oBuffer->uCapacity)
+      if (! Buffer_grow(oBuffer, oBuffer->uLength + uLength))
+         return 0;
+
+   memcpy(oBuffer->pcChars + oBuffer->uLength, pcChars, uLength);
+   oBuffer->uLength += uLength;
+   oBuffer->pcChars[oBuffer->uLength] = '\0';
+
+   assert(Buffer_isValid(oBuffer));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Buffer_appendString(Buffer_T oBuffer, const char *pcString)
+{
+   assert(pcString != NULL);
+
+   return Buffer_append(oBuffer, pcString, strlen(pcString));
+}
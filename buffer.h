@@ -0,0 +1,66 @@
+/*--------------------------------------------------------------------*/
+/* buffer.h                                                           */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef BUFFER_INCLUDED
+#define BUFFER_INCLUDED
+
+#include <stddef.h>
+
+/* A Buffer_T object is a sequence of characters whose length can
+   expand dynamically.  Its contents are always followed by a null
+   character. */
+
+typedef struct Buffer *Buffer_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new empty Buffer_T object that can hold uCapacity
+   characters before growing, or NULL if insufficient memory is
+   available. */
+
+Buffer_T Buffer_new(size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBuffer. */
+
+void Buffer_free(Buffer_T oBuffer);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of characters in oBuffer. */
+
+size_t Buffer_getLength(Buffer_T oBuffer);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the characters of oBuffer.  The pointer is invalidated by
+   any operation that adds characters to oBuffer. */
+
+char *Buffer_getData(Buffer_T oBuffer);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove all characters from oBuffer, keeping its capacity. */
+
+void Buffer_clear(Buffer_T oBuffer);
+
+/*--------------------------------------------------------------------*/
+
+/* Add the uLength characters at pcChars to the end of oBuffer.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available. */
+
+int Buffer_append(Buffer_T oBuffer, const char *pcChars,
+                  size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Add string pcString to the end of oBuffer.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+int Buffer_appendString(Buffer_T oBuffer, const char *pcString);
+
+#endif
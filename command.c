@@ -4,6 +4,7 @@
 /*--------------------------------------------------------------------*/
 
 #include "command.h"
+#include "dynarrayt.h"
 #include "ish.h"
 #include <stdlib.h>
 #include <assert.h>
@@ -12,21 +13,40 @@
 
 /*--------------------------------------------------------------------*/
 
+/* The number of arguments that a command stores within itself, which
+   is enough for most commands that a user types. */
+
+enum {COMMAND_INLINE_ARGS = 6};
+
+/* An array of argument strings that a command stores by value, so
+   that a command with few arguments needs no separate array. */
+
+DYNARRAY_DEFINE(Command_Args, char*, COMMAND_INLINE_ARGS)
+
+/*--------------------------------------------------------------------*/
+
 /* A command consists of a name, possibly-multiple arguments, a 
-   standard input file, and a standard output file. */
+   standard input file, and a standard output file.  Commands that a
+   line joins with ";", "&&" or "||" form a list. */
 struct Command
 {
    /* Command name. */
    char* pcName;
 
-   /* A dynamic array of arguments. */
-   DynArray_T oArgs;
+   /* The arguments, each a string that the command owns. */
+   Command_Args sArgs;
 
    /* Standard input file. */
    char* pcStdIn;
 
    /* Standard output file. */
    char* pcStdOut;
+
+   /* How the command is joined to the next command of its list. */
+   enum CommandJoin eJoin;
+
+   /* The next command of the list, or NULL. */
+   Command_T oNext;
 };
 
 /*--------------------------------------------------------------------*/
@@ -39,9 +59,14 @@ struct Command
 static int Command_isValid(Command_T oCommand)
 {
    if (oCommand == NULL) return 0;
-   if (oCommand->pcName == NULL && oCommand->oArgs == NULL &&
+   if (! Command_Args_isValid(&oCommand->sArgs)) return 0;
+   if (oCommand->pcName == NULL &&
+       Command_Args_getLength(&oCommand->sArgs) == 0 &&
        oCommand->pcStdIn == NULL && oCommand->pcStdOut == NULL)
       return 0;
+   if ((oCommand->eJoin == COMMAND_JOIN_NONE) !=
+       (oCommand->oNext == NULL))
+      return 0;
    return 1;
 }
 
@@ -76,21 +101,24 @@ Command_T Command_new(char* pcName, DynArray_T oArgs,
    strcpy(oCommand->pcName, pcName);
    
 
+   Command_Args_init(&oCommand->sArgs);
    if (oArgs != NULL)
    {
       size_t ulInd;
       size_t ulLen = DynArray_getLength(oArgs);
-      oCommand->oArgs = DynArray_new(ulLen);
+      if (! Command_Args_reserve(&oCommand->sArgs, ulLen))
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
       for (ulInd = 0; ulInd < ulLen; ulInd++)
       {
          char* inputStr = DynArray_get(oArgs, ulInd);
          char* copyStr =
             (char*)malloc(sizeof(char) * (strlen(inputStr)+1));
+         if (copyStr == NULL)
+         {perror(getPgmName()); exit(EXIT_FAILURE);}
          strcpy(copyStr, inputStr);
-         DynArray_set(oCommand->oArgs, ulInd, copyStr);
+         Command_Args_add(&oCommand->sArgs, copyStr);
       }
    }
-   else oCommand->oArgs = NULL;
 
    if (pcStdIn != NULL)
    {
@@ -118,68 +146,60 @@ Command_T Command_new(char* pcName, DynArray_T oArgs,
    }
    else oCommand->pcStdOut = NULL;
 
-   return oCommand;
-}
-
-/*--------------------------------------------------------------------*/
+   oCommand->eJoin = COMMAND_JOIN_NONE;
+   oCommand->oNext = NULL;
 
-/* Helper function for freeing one argument. */
-
-static void freeArg(void* arg, void* pvExtra)
-{
-   assert(arg != NULL);
-   free(arg);
+   return oCommand;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Free oCommand. */
+/* Free oCommand, and the commands that follow it in its list. */
 
 void Command_free(Command_T oCommand)
 {
-   if (oCommand != NULL)
+   Command_T oNext;
+   size_t ulInd;
+
+   while (oCommand != NULL)
    {
+      oNext = oCommand->oNext;
       free(oCommand->pcName);
       if (oCommand->pcStdIn != NULL) free(oCommand->pcStdIn);
       if (oCommand->pcStdOut != NULL) free(oCommand->pcStdOut);
-      if (oCommand->oArgs != NULL)
-      {
-         DynArray_map(oCommand->oArgs, freeArg, NULL);
-         DynArray_free(oCommand->oArgs);
-      }
+      for (ulInd = 0; ulInd < Command_Args_getLength(&oCommand->sArgs);
+           ulInd++)
+         free(Command_Args_get(&oCommand->sArgs, ulInd));
+      Command_Args_destroy(&oCommand->sArgs);
       free(oCommand);
+      oCommand = oNext;
    }
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Helper function for printing command objects. 
-   Excerpt from precept 10.  */
-
-static void printString(void *pvItem, void *pvFormat)
-{
-   assert(pvItem != NULL);
-   assert(pvFormat != NULL);
-   printf((char*)pvFormat, (char*)pvItem);
-}
-
-/*--------------------------------------------------------------------*/
-
-/* Print the content of oCommand. */
+/* Print the content of oCommand, and how it is joined to the command
+   that follows it, if any. */
 
 void Command_print(Command_T oCommand)
 {
+   size_t ulInd;
+
    assert(oCommand != NULL);
    assert(Command_isValid(oCommand));
 
    if (oCommand->pcName != NULL)
       printf("Command name: %s\n", oCommand->pcName);
-   if (oCommand->oArgs != NULL)
-      DynArray_map(oCommand->oArgs, printString, "Command arg: %s\n");
+   for (ulInd = 0; ulInd < Command_Args_getLength(&oCommand->sArgs);
+        ulInd++)
+      printf("Command arg: %s\n",
+             Command_Args_get(&oCommand->sArgs, ulInd));
    if (oCommand->pcStdIn != NULL)
       printf("Command stdin: %s\n", oCommand->pcStdIn);
    if (oCommand->pcStdOut != NULL)
       printf("Command stdout: %s\n", oCommand->pcStdOut);
+   if (oCommand->oNext != NULL)
+      printf("Command join: %s\n", Command_getJoinOperator(oCommand));
 }
 
 /*--------------------------------------------------------------------*/
@@ -201,20 +221,21 @@ char* Command_getName(Command_T oCommand)
 char** Command_getArgv(Command_T oCommand)
 {
    char** ppcArgv;
-   size_t i; /* Array iterator. */
    size_t uArgsLen;
    
    assert(oCommand != NULL);
    assert(Command_isValid(oCommand));
 
-   if (oCommand->oArgs == NULL) uArgsLen = 0;
-   else uArgsLen = DynArray_getLength(oCommand->oArgs);
+   uArgsLen = Command_Args_getLength(&oCommand->sArgs);
    
    ppcArgv = (char**)calloc(uArgsLen + 2, sizeof(char*));
+   if (ppcArgv == NULL)
+   {perror(getPgmName()); exit(EXIT_FAILURE);}
    ppcArgv[0] = oCommand->pcName;
-   for (i = 1; i < uArgsLen+1; i++)
-      ppcArgv[i] = DynArray_get(oCommand->oArgs, i-1);
-   ppcArgv[i] = NULL;
+   if (uArgsLen > 0)
+      memcpy(ppcArgv + 1, Command_Args_at(&oCommand->sArgs, 0),
+             sizeof(char*) * uArgsLen);
+   ppcArgv[uArgsLen + 1] = NULL;
    return ppcArgv;
 }
 
@@ -227,8 +248,7 @@ size_t Command_getArgsNum(Command_T oCommand)
    assert(oCommand != NULL);
    assert(Command_isValid(oCommand));
 
-   if (oCommand->oArgs == NULL) return 0;
-   return DynArray_getLength(oCommand->oArgs);
+   return Command_Args_getLength(&oCommand->sArgs);
 }
 
 /*--------------------------------------------------------------------*/
@@ -255,3 +275,81 @@ char* Command_getStdOut(Command_T oCommand)
    return oCommand->pcStdOut;
 }
 
+/*--------------------------------------------------------------------*/
+
+/* Make oNext, which oCommand then owns, the command that follows
+   oCommand, which must be the last of its list, joined to it by
+   eJoin. */
+
+void Command_setNext(Command_T oCommand, enum CommandJoin eJoin,
+                     Command_T oNext)
+{
+   assert(oCommand != NULL);
+   assert(Command_isValid(oCommand));
+   assert(oCommand->oNext == NULL);
+   assert(eJoin != COMMAND_JOIN_NONE);
+   assert(oNext != NULL);
+
+   oCommand->eJoin = eJoin;
+   oCommand->oNext = oNext;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the command that follows oCommand in its list, or NULL if
+   it is the last. */
+
+Command_T Command_getNext(Command_T oCommand)
+{
+   assert(oCommand != NULL);
+   assert(Command_isValid(oCommand));
+   return oCommand->oNext;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Returns how oCommand is joined to the command that follows it. */
+
+enum CommandJoin Command_getJoin(Command_T oCommand)
+{
+   assert(oCommand != NULL);
+   assert(Command_isValid(oCommand));
+   return oCommand->eJoin;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the operator that joins oCommand to the command that
+   follows it, such as "&&", or NULL if it is the last of its list. */
+
+const char* Command_getJoinOperator(Command_T oCommand)
+{
+   assert(oCommand != NULL);
+   assert(Command_isValid(oCommand));
+   switch (oCommand->eJoin)
+   {
+      case COMMAND_JOIN_SEQUENCE: return ";";
+      case COMMAND_JOIN_AND: return "&&";
+      case COMMAND_JOIN_OR: return "||";
+      default: return NULL;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the commands that follow oCommand from its list, which then
+   ends with oCommand, and return the first of them, which the caller
+   owns, or NULL if there are none. */
+
+Command_T Command_detachNext(Command_T oCommand)
+{
+   Command_T oNext;
+
+   assert(oCommand != NULL);
+   assert(Command_isValid(oCommand));
+
+   oNext = oCommand->oNext;
+   oCommand->eJoin = COMMAND_JOIN_NONE;
+   oCommand->oNext = NULL;
+   return oNext;
+}
@@ -10,6 +10,15 @@
 
 typedef struct Command* Command_T;
 
+/* Define how a command is joined to the command that follows it in a
+   list: by ";", which runs the next command in any case, by "&&",
+   which runs it only if the command exits with status 0, or by "||",
+   which runs it only if the command exits with another status.  The
+   last command of a list is joined by COMMAND_JOIN_NONE. */
+
+enum CommandJoin {COMMAND_JOIN_NONE, COMMAND_JOIN_SEQUENCE,
+                  COMMAND_JOIN_AND, COMMAND_JOIN_OR};
+
 /*--------------------------------------------------------------------*/
 
 /* Create and return a command object whose name is pcName, whose 
@@ -21,13 +30,14 @@ Command_T Command_new(char* pcName, DynArray_T oArgs,
 
 /*--------------------------------------------------------------------*/
 
-/* Free oCommand. */
+/* Free oCommand, and the commands that follow it in its list. */
 
 void Command_free(Command_T oCommand);
 
 /*--------------------------------------------------------------------*/
 
-/* Print the content of oCommand. */
+/* Print the content of oCommand, and how it is joined to the command
+   that follows it, if any. */
 
 void Command_print(Command_T oCommand);
 
@@ -61,4 +71,41 @@ char* Command_getStdIn(Command_T oCommand);
 
 char* Command_getStdOut(Command_T oCommand);
 
+/*--------------------------------------------------------------------*/
+
+/* Make oNext, which oCommand then owns, the command that follows
+   oCommand, which must be the last of its list, joined to it by
+   eJoin. */
+
+void Command_setNext(Command_T oCommand, enum CommandJoin eJoin,
+                     Command_T oNext);
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the command that follows oCommand in its list, or NULL if
+   it is the last. */
+
+Command_T Command_getNext(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Returns how oCommand is joined to the command that follows it. */
+
+enum CommandJoin Command_getJoin(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the operator that joins oCommand to the command that
+   follows it, such as "&&", or NULL if it is the last of its list. */
+
+const char* Command_getJoinOperator(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the commands that follow oCommand from its list, which then
+   ends with oCommand, and return the first of them, which the caller
+   owns, or NULL if there are none. */
+
+Command_T Command_detachNext(Command_T oCommand);
+
 #endif
@@ -0,0 +1,194 @@
+/*--------------------------------------------------------------------*/
+/* concArray.c                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "concArray.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Segment k of a ConcArray holds FIRST_LENGTH << k elements, so that
+   MAX_SEGMENTS segments cover every index that a size_t can hold. */
+
+enum {FIRST_BITS = 6, FIRST_LENGTH = 1 << FIRST_BITS,
+      MAX_SEGMENTS = sizeof(size_t) * CHAR_BIT - FIRST_BITS};
+
+/*--------------------------------------------------------------------*/
+
+/* A ConcArray consists of the number of slots reserved so far, and
+   the segments that hold them. */
+
+struct ConcArray
+{
+   /* The number of slots reserved by ConcArray_add. */
+   atomic_size_t uReserved;
+
+   /* 1 (TRUE) iff some add could not allocate its segment. */
+   atomic_int iFailed;
+
+   /* The segments, each NULL until some add needs it. */
+   const void **_Atomic appvSegments[MAX_SEGMENTS];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Assign to *puSegment and *puOffset the segment and the offset
+   within it of the slot at uIndex. */
+
+static void ConcArray_locate(size_t uIndex, size_t *puSegment,
+                             size_t *puOffset)
+{
+   size_t uBiased = uIndex + FIRST_LENGTH;
+   size_t uTop;
+
+   assert(uBiased > uIndex);
+
+#ifdef __GNUC__
+   uTop = sizeof(unsigned long) * CHAR_BIT - 1 -
+      (size_t)__builtin_clzl((unsigned long)uBiased);
+#else
+   for (uTop = FIRST_BITS; (uBiased >> uTop) > 1; uTop++)
+      ;
+#endif
+
+   *puSegment = uTop - FIRST_BITS;
+   *puOffset = uBiased - ((size_t)1 << uTop);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return segment uSegment of oConcArray, allocating it if no thread
+   has yet, or NULL if insufficient memory is available. */
+
+static const void **ConcArray_getSegment(ConcArray_T oConcArray,
+                                         size_t uSegment)
+{
+   const void **ppvSegment;
+   const void **ppvExpected = NULL;
+
+   ppvSegment = atomic_load_explicit(
+      &oConcArray->appvSegments[uSegment], memory_order_acquire);
+   if (ppvSegment != NULL)
+      return ppvSegment;
+
+   /* Race the other threads that need the segment, and keep the
+      winner's. */
+   ppvSegment = (const void**)malloc(
+      sizeof(void*) * ((size_t)FIRST_LENGTH << uSegment));
+   if (ppvSegment == NULL)
+      return NULL;
+   if (atomic_compare_exchange_strong_explicit(
+          &oConcArray->appvSegments[uSegment], &ppvExpected,
+          ppvSegment, memory_order_acq_rel, memory_order_acquire))
+      return ppvSegment;
+   free(ppvSegment);
+   return ppvExpected;
+}
+
+/*--------------------------------------------------------------------*/
+
+ConcArray_T ConcArray_new(void)
+{
+   ConcArray_T oConcArray;
+   size_t u;
+
+   oConcArray = (struct ConcArray*)malloc(sizeof(struct ConcArray));
+   if (oConcArray == NULL)
+      return NULL;
+   atomic_init(&oConcArray->uReserved, 0);
+   atomic_init(&oConcArray->iFailed, 0);
+   for (u = 0; u < MAX_SEGMENTS; u++)
+      atomic_init(&oConcArray->appvSegments[u], NULL);
+
+   if (ConcArray_getSegment(oConcArray, 0) == NULL)
+   {
+      free(oConcArray);
+      return NULL;
+   }
+   return oConcArray;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ConcArray_free(ConcArray_T oConcArray)
+{
+   size_t u;
+
+   assert(oConcArray != NULL);
+
+   for (u = 0; u < MAX_SEGMENTS; u++)
+      free((void*)atomic_load_explicit(&oConcArray->appvSegments[u],
+                                       memory_order_relaxed));
+   free(oConcArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+int ConcArray_add(ConcArray_T oConcArray, const void *pvElement)
+{
+   const void **ppvSegment;
+   size_t uSegment;
+   size_t uOffset;
+
+   assert(oConcArray != NULL);
+
+   ConcArray_locate(atomic_fetch_add_explicit(&oConcArray->uReserved, 1,
+                                              memory_order_relaxed),
+                    &uSegment, &uOffset);
+   ppvSegment = ConcArray_getSegment(oConcArray, uSegment);
+   if (ppvSegment == NULL)
+   {
+      atomic_store_explicit(&oConcArray->iFailed, 1,
+                            memory_order_relaxed);
+      return 0;
+   }
+   ppvSegment[uOffset] = pvElement;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t ConcArray_getLength(ConcArray_T oConcArray)
+{
+   assert(oConcArray != NULL);
+
+   return atomic_load_explicit(&oConcArray->uReserved,
+                               memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------*/
+
+DynArray_T ConcArray_freeze(ConcArray_T oConcArray)
+{
+   DynArray_T oDynArray = NULL;
+   const void **ppvSegment;
+   size_t uLength;
+   size_t uIndex = 0;
+   size_t uSegment;
+   size_t uOffset;
+
+   assert(oConcArray != NULL);
+
+   uLength = ConcArray_getLength(oConcArray);
+   if (! atomic_load_explicit(&oConcArray->iFailed,
+                              memory_order_relaxed))
+      oDynArray = DynArray_new(uLength);
+   if (oDynArray != NULL)
+   {
+      /* Copy the segments in order. */
+      for (uSegment = 0; uIndex < uLength; uSegment++)
+      {
+         ppvSegment = atomic_load_explicit(
+            &oConcArray->appvSegments[uSegment], memory_order_relaxed);
+         for (uOffset = 0; uOffset < ((size_t)FIRST_LENGTH << uSegment)
+                 && uIndex < uLength; uOffset++)
+            DynArray_set(oDynArray, uIndex++, ppvSegment[uOffset]);
+      }
+   }
+   ConcArray_free(oConcArray);
+   return oDynArray;
+}
@@ -0,0 +1,65 @@
+/*--------------------------------------------------------------------*/
+/* concArray.h                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef CONCARRAY_INCLUDED
+#define CONCARRAY_INCLUDED
+
+#include "dynarray.h"
+
+/* A ConcArray_T object is an array of elements to which many threads
+   can add at the same time, without locks.  Each add reserves a slot
+   with one atomic increment.  The array grows by adding segments, each
+   twice as long as the one before, so published elements never move.
+   Once the threads are done adding, ConcArray_freeze turns the array
+   into a DynArray_T object.
+
+   Because the order of the elements depends on timing, ConcArray_T
+   suits producers whose results form a set, such as matches that are
+   sorted afterwards.  The lexer does not use it: the tokens of a line
+   must stay in order, so each chunk fills its own DynArray_T object
+   and the chunks are joined in order. */
+
+typedef struct ConcArray *ConcArray_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new empty ConcArray_T object, or NULL if insufficient
+   memory is available. */
+
+ConcArray_T ConcArray_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oConcArray. */
+
+void ConcArray_free(ConcArray_T oConcArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to the end of oConcArray.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available.  Any
+   number of threads may call ConcArray_add with the same oConcArray
+   at the same time.  Elements that different threads add are ordered
+   by when they reserve their slots. */
+
+int ConcArray_add(ConcArray_T oConcArray, const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of elements that have been added to oConcArray,
+   including those whose adds are still in progress. */
+
+size_t ConcArray_getLength(ConcArray_T oConcArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oConcArray, and return a new DynArray_T object that holds its
+   elements in the same order, or NULL if an add to oConcArray failed
+   or insufficient memory is available.  No thread may be adding to
+   oConcArray. */
+
+DynArray_T ConcArray_freeze(ConcArray_T oConcArray);
+
+#endif
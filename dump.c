@@ -0,0 +1,442 @@
+/*--------------------------------------------------------------------*/
+/* dump.c                                                             */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "dump.h"
+#include "token.h"
+#include "ish.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The magic number with which every dump begins. */
+
+static const char acMagic[] = {'I', 'S', 'H', '1'};
+
+/* The sizes of the parts of records and fields. */
+
+enum {MAGIC_SIZE = 4, KIND_SIZE = 1, TAG_SIZE = 1, LENGTH_SIZE = 4};
+
+/*--------------------------------------------------------------------*/
+
+/* A DumpReader consists of the bytes of a dump, along with how they
+   were obtained and the position of the next record. */
+
+struct DumpReader
+{
+   /* The bytes of the dump. */
+   const char *pcDump;
+
+   /* The number of bytes in the dump. */
+   size_t uLength;
+
+   /* 1 (TRUE) iff pcDump was mapped with mmap rather than allocated
+      with malloc. */
+   int iMapped;
+
+   /* The offset of the next record. */
+   size_t uOffset;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append uValue to oBuffer as a 4-byte little-endian integer.  Return
+   1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Dump_appendLength(Buffer_T oBuffer, size_t uValue)
+{
+   char acBytes[LENGTH_SIZE];
+
+   assert(uValue <= 0xFFFFFFFFu);
+
+   acBytes[0] = (char)(uValue & 0xFF);
+   acBytes[1] = (char)((uValue >> 8) & 0xFF);
+   acBytes[2] = (char)((uValue >> 16) & 0xFF);
+   acBytes[3] = (char)((uValue >> 24) & 0xFF);
+   return Buffer_append(oBuffer, acBytes, LENGTH_SIZE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 4-byte little-endian integer at pcBytes. */
+
+static size_t Dump_readLength(const char *pcBytes)
+{
+   const unsigned char *pucBytes = (const unsigned char*)pcBytes;
+
+   return (size_t)pucBytes[0] | ((size_t)pucBytes[1] << 8) |
+      ((size_t)pucBytes[2] << 16) | ((size_t)pucBytes[3] << 24);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes that a field whose value is pcValue
+   occupies. */
+
+static size_t Dump_fieldSize(const char *pcValue)
+{
+   return TAG_SIZE + LENGTH_SIZE + strlen(pcValue) + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append to oBuffer a field whose tag is iTag and whose value is
+   pcValue.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+static int Dump_appendField(Buffer_T oBuffer, int iTag,
+                            const char *pcValue)
+{
+   char cTag = (char)iTag;
+   size_t uLength = strlen(pcValue);
+
+   return Buffer_append(oBuffer, &cTag, TAG_SIZE) &&
+      Dump_appendLength(oBuffer, uLength) &&
+      Buffer_append(oBuffer, pcValue, uLength + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append to oBuffer the kind and payload length of a record.  Return
+   1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Dump_appendRecordHeader(Buffer_T oBuffer,
+                                   enum DumpKind eKind,
+                                   size_t uPayloadLength)
+{
+   char cKind = (char)eKind;
+
+   return Buffer_append(oBuffer, &cKind, KIND_SIZE) &&
+      Dump_appendLength(oBuffer, uPayloadLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Dump_appendHeader(Buffer_T oBuffer)
+{
+   assert(oBuffer != NULL);
+
+   return Buffer_append(oBuffer, acMagic, MAGIC_SIZE);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Dump_appendString(Buffer_T oBuffer, enum DumpKind eKind,
+                      const char *pcString)
+{
+   assert(oBuffer != NULL);
+   assert(eKind == DUMP_LINE || eKind == DUMP_ERROR);
+   assert(pcString != NULL);
+
+   return Dump_appendRecordHeader(oBuffer, eKind,
+                                  Dump_fieldSize(pcString)) &&
+      Dump_appendField(oBuffer, 0, pcString);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Dump_appendTokens(Buffer_T oBuffer, DynArray_T oTokens)
+{
+   size_t u;
+   size_t uLength;
+   size_t uPayloadLength = 0;
+   Token_T oToken;
+
+   assert(oBuffer != NULL);
+   assert(oTokens != NULL);
+
+   uLength = DynArray_getLength(oTokens);
+   for (u = 0; u < uLength; u++)
+   {
+      oToken = DynArray_get(oTokens, u);
+      uPayloadLength += Dump_fieldSize(Token_getString(oToken));
+   }
+
+   if (! Dump_appendRecordHeader(oBuffer, DUMP_TOKENS, uPayloadLength))
+      return 0;
+   for (u = 0; u < uLength; u++)
+   {
+      oToken = DynArray_get(oTokens, u);
+      if (! Dump_appendField(oBuffer, (int)Token_getType(oToken),
+                             Token_getString(oToken)))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Dump_appendCommand(Buffer_T oBuffer, Command_T oCommand)
+{
+   char **ppcArgv;
+   size_t u;
+   size_t uArgc;
+   size_t uPayloadLength = 0;
+   char *pcStdIn;
+   char *pcStdOut;
+   const char *pcJoin;
+   int iSuccessful;
+
+   assert(oBuffer != NULL);
+   assert(oCommand != NULL);
+
+   /* ppcArgv[0] is the command name. */
+   ppcArgv = Command_getArgv(oCommand);
+   if (ppcArgv == NULL)
+      return 0;
+   uArgc = Command_getArgsNum(oCommand) + 1;
+   pcStdIn = Command_getStdIn(oCommand);
+   pcStdOut = Command_getStdOut(oCommand);
+   pcJoin = Command_getJoinOperator(oCommand);
+
+   for (u = 0; u < uArgc; u++)
+      uPayloadLength += Dump_fieldSize(ppcArgv[u]);
+   if (pcStdIn != NULL)
+      uPayloadLength += Dump_fieldSize(pcStdIn);
+   if (pcStdOut != NULL)
+      uPayloadLength += Dump_fieldSize(pcStdOut);
+   if (pcJoin != NULL)
+      uPayloadLength += Dump_fieldSize(pcJoin);
+
+   iSuccessful =
+      Dump_appendRecordHeader(oBuffer, DUMP_COMMAND, uPayloadLength);
+   for (u = 0; iSuccessful && u < uArgc; u++)
+      iSuccessful = Dump_appendField(
+         oBuffer, u == 0 ? DUMP_TAG_NAME : DUMP_TAG_ARG, ppcArgv[u]);
+   if (iSuccessful && pcStdIn != NULL)
+      iSuccessful = Dump_appendField(oBuffer, DUMP_TAG_STDIN, pcStdIn);
+   if (iSuccessful && pcStdOut != NULL)
+      iSuccessful = Dump_appendField(oBuffer, DUMP_TAG_STDOUT, pcStdOut);
+   if (iSuccessful && pcJoin != NULL)
+      iSuccessful = Dump_appendField(oBuffer, DUMP_TAG_JOIN, pcJoin);
+
+   free(ppcArgv);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the uLength bytes at pcPayload form a valid
+   sequence of fields. */
+
+static int Dump_isValidPayload(const char *pcPayload, size_t uLength)
+{
+   size_t uOffset = 0;
+   size_t uValueLength;
+
+   while (uOffset < uLength)
+   {
+      if (uLength - uOffset < TAG_SIZE + LENGTH_SIZE)
+         return 0;
+      uValueLength = Dump_readLength(pcPayload + uOffset + TAG_SIZE);
+      uOffset += TAG_SIZE + LENGTH_SIZE;
+      if (uLength - uOffset < uValueLength + 1)
+         return 0;
+      if (pcPayload[uOffset + uValueLength] != '\0')
+         return 0;
+      uOffset += uValueLength + 1;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the uLength bytes at pcDump form a valid
+   dump. */
+
+static int Dump_isValid(const char *pcDump, size_t uLength)
+{
+   size_t uOffset = MAGIC_SIZE;
+   size_t uPayloadLength;
+   char cKind;
+
+   if (uLength < MAGIC_SIZE || memcmp(pcDump, acMagic, MAGIC_SIZE) != 0)
+      return 0;
+
+   while (uOffset < uLength)
+   {
+      if (uLength - uOffset < KIND_SIZE + LENGTH_SIZE)
+         return 0;
+      cKind = pcDump[uOffset];
+      if (cKind != DUMP_LINE && cKind != DUMP_TOKENS &&
+          cKind != DUMP_ERROR && cKind != DUMP_COMMAND)
+         return 0;
+      uPayloadLength = Dump_readLength(pcDump + uOffset + KIND_SIZE);
+      uOffset += KIND_SIZE + LENGTH_SIZE;
+      if (uLength - uOffset < uPayloadLength)
+         return 0;
+      if (! Dump_isValidPayload(pcDump + uOffset, uPayloadLength))
+         return 0;
+      uOffset += uPayloadLength;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read all bytes from file descriptor iFd into memory allocated with
+   malloc.  Assign the number of bytes to *puLength and return the
+   memory, or return NULL and set errno if an error occurs. */
+
+static char *Dump_readAll(int iFd, size_t *puLength)
+{
+   enum {INITIAL_SIZE = 64 * 1024};
+   enum {GROWTH_FACTOR = 2};
+
+   char *pcBytes;
+   char *pcNewBytes;
+   size_t uLength = 0;
+   size_t uPhysLength = INITIAL_SIZE;
+   ssize_t iRead;
+
+   pcBytes = (char*)malloc(uPhysLength);
+   if (pcBytes == NULL)
+      return NULL;
+
+   for (;;)
+   {
+      if (uLength == uPhysLength)
+      {
+         uPhysLength *= GROWTH_FACTOR;
+         pcNewBytes = (char*)realloc(pcBytes, uPhysLength);
+         if (pcNewBytes == NULL)
+         {
+            free(pcBytes);
+            return NULL;
+         }
+         pcBytes = pcNewBytes;
+      }
+      iRead = read(iFd, pcBytes + uLength, uPhysLength - uLength);
+      if (iRead == 0)
+         break;
+      if (iRead == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         free(pcBytes);
+         return NULL;
+      }
+      uLength += (size_t)iRead;
+   }
+
+   *puLength = uLength;
+   return pcBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+DumpReader_T DumpReader_new(int iFd)
+{
+   DumpReader_T oDumpReader;
+   struct stat sStat;
+   void *pvMap;
+
+   oDumpReader = (struct DumpReader*)malloc(sizeof(struct DumpReader));
+   if (oDumpReader == NULL)
+      return NULL;
+   oDumpReader->pcDump = NULL;
+   oDumpReader->iMapped = 0;
+
+   /* Map a regular file, and read anything else, such as a pipe from
+      an earlier stage. */
+   if (fstat(iFd, &sStat) == 0 && S_ISREG(sStat.st_mode) &&
+       sStat.st_size > 0)
+   {
+      pvMap = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_PRIVATE,
+                   iFd, 0);
+      if (pvMap != MAP_FAILED)
+      {
+         oDumpReader->pcDump = (const char*)pvMap;
+         oDumpReader->uLength = (size_t)sStat.st_size;
+         oDumpReader->iMapped = 1;
+      }
+   }
+   if (oDumpReader->pcDump == NULL)
+   {
+      oDumpReader->pcDump = Dump_readAll(iFd, &oDumpReader->uLength);
+      if (oDumpReader->pcDump == NULL)
+      {
+         free(oDumpReader);
+         return NULL;
+      }
+   }
+
+   /* Validate once, so that iteration need not check bounds. */
+   if (! Dump_isValid(oDumpReader->pcDump, oDumpReader->uLength))
+   {
+      DumpReader_free(oDumpReader);
+      errno = EINVAL;
+      return NULL;
+   }
+
+   oDumpReader->uOffset = MAGIC_SIZE;
+   return oDumpReader;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DumpReader_free(DumpReader_T oDumpReader)
+{
+   assert(oDumpReader != NULL);
+
+   if (oDumpReader->iMapped)
+      munmap((void*)oDumpReader->pcDump, oDumpReader->uLength);
+   else
+      free((void*)oDumpReader->pcDump);
+   free(oDumpReader);
+}
+
+/*--------------------------------------------------------------------*/
+
+int DumpReader_next(DumpReader_T oDumpReader,
+                    struct DumpRecord *psRecord)
+{
+   const char *pcRecord;
+
+   assert(oDumpReader != NULL);
+   assert(psRecord != NULL);
+
+   if (oDumpReader->uOffset == oDumpReader->uLength)
+      return 0;
+
+   pcRecord = oDumpReader->pcDump + oDumpReader->uOffset;
+   psRecord->eKind = (enum DumpKind)pcRecord[0];
+   psRecord->uLength = Dump_readLength(pcRecord + KIND_SIZE);
+   psRecord->pcPayload = pcRecord + KIND_SIZE + LENGTH_SIZE;
+   psRecord->uOffset = 0;
+
+   oDumpReader->uOffset += KIND_SIZE + LENGTH_SIZE + psRecord->uLength;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int DumpRecord_nextField(struct DumpRecord *psRecord,
+                         struct DumpField *psField)
+{
+   const char *pcField;
+
+   assert(psRecord != NULL);
+   assert(psField != NULL);
+
+   if (psRecord->uOffset == psRecord->uLength)
+      return 0;
+
+   pcField = psRecord->pcPayload + psRecord->uOffset;
+   psField->iTag = (unsigned char)pcField[0];
+   psField->uLength = Dump_readLength(pcField + TAG_SIZE);
+   psField->pcValue = pcField + TAG_SIZE + LENGTH_SIZE;
+
+   psRecord->uOffset += TAG_SIZE + LENGTH_SIZE + psField->uLength + 1;
+   return 1;
+}
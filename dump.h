@@ -0,0 +1,143 @@
+/*--------------------------------------------------------------------*/
+/* dump.h                                                             */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef DUMP_INCLUDED
+#define DUMP_INCLUDED
+
+#include <stddef.h>
+#include "dynarray.h"
+#include "command.h"
+#include "buffer.h"
+
+/* A dump is a compact binary form of the output of ishlex and ishsyn.
+   It begins with the 4-byte magic number "ISH1" and continues with a
+   sequence of records.  A record is a 1-byte kind, a 4-byte
+   little-endian payload length, and a payload that is a sequence of
+   fields.  A field is a 1-byte tag, a 4-byte little-endian value
+   length, the value, and a null character, so that values can be used
+   in place as strings. */
+
+/* The kinds of records. */
+
+enum DumpKind {DUMP_LINE = 'L', DUMP_TOKENS = 'T', DUMP_ERROR = 'E',
+               DUMP_COMMAND = 'C'};
+
+/* The tags of the fields of DUMP_COMMAND records.  A command that is
+   joined to the next one of its list ends with a DUMP_TAG_JOIN field
+   holding the operator, such as "&&".  The fields of DUMP_TOKENS
+   records are tagged with their TokenType, and the single field of
+   DUMP_LINE and DUMP_ERROR records is tagged with 0. */
+
+enum DumpTag {DUMP_TAG_NAME, DUMP_TAG_ARG, DUMP_TAG_STDIN,
+              DUMP_TAG_STDOUT, DUMP_TAG_JOIN};
+
+/*--------------------------------------------------------------------*/
+
+/* A record within a dump.  Its payload points into the dump. */
+
+struct DumpRecord
+{
+   /* The kind of the record. */
+   enum DumpKind eKind;
+
+   /* The payload of the record. */
+   const char *pcPayload;
+
+   /* The number of bytes in the payload. */
+   size_t uLength;
+
+   /* The offset within the payload of the next field to iterate. */
+   size_t uOffset;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A field within a record.  Its value points into the dump. */
+
+struct DumpField
+{
+   /* The tag of the field. */
+   int iTag;
+
+   /* The value of the field, followed by a null character. */
+   const char *pcValue;
+
+   /* The number of bytes in the value. */
+   size_t uLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append the magic number of a dump to oBuffer.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+int Dump_appendHeader(Buffer_T oBuffer);
+
+/*--------------------------------------------------------------------*/
+
+/* Append to oBuffer a record of kind eKind (DUMP_LINE or DUMP_ERROR)
+   whose value is pcString.  Return 1 (TRUE) if successful, or
+   0 (FALSE) if insufficient memory is available. */
+
+int Dump_appendString(Buffer_T oBuffer, enum DumpKind eKind,
+                      const char *pcString);
+
+/*--------------------------------------------------------------------*/
+
+/* Append to oBuffer a DUMP_TOKENS record holding the tokens in
+   oTokens.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+int Dump_appendTokens(Buffer_T oBuffer, DynArray_T oTokens);
+
+/*--------------------------------------------------------------------*/
+
+/* Append to oBuffer a DUMP_COMMAND record holding oCommand, but not
+   the commands that follow it in its list.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+int Dump_appendCommand(Buffer_T oBuffer, Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* A DumpReader_T object iterates over the records of a dump without
+   allocating memory. */
+
+typedef struct DumpReader *DumpReader_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new DumpReader_T object over the dump read from file
+   descriptor iFd, which is mapped into memory if it is a regular
+   file.  Return NULL and set errno if the dump cannot be read or is
+   malformed. */
+
+DumpReader_T DumpReader_new(int iFd);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oDumpReader, invalidating the records and fields that it
+   returned. */
+
+void DumpReader_free(DumpReader_T oDumpReader);
+
+/*--------------------------------------------------------------------*/
+
+/* If no records remain in oDumpReader, then return 0 (FALSE).
+   Otherwise assign the next record to *psRecord and return
+   1 (TRUE). */
+
+int DumpReader_next(DumpReader_T oDumpReader,
+                    struct DumpRecord *psRecord);
+
+/*--------------------------------------------------------------------*/
+
+/* If no fields remain in *psRecord, then return 0 (FALSE).  Otherwise
+   assign the next field to *psField and return 1 (TRUE). */
+
+int DumpRecord_nextField(struct DumpRecord *psRecord,
+                         struct DumpField *psField);
+
+#endif
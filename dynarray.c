@@ -4,34 +4,51 @@
 /*--------------------------------------------------------------------*/
 
 #include "dynarray.h"
+#include "dynarrayt.h"
+#include "threadPool.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 /*--------------------------------------------------------------------*/
 
-/* The minimum physical length of a DynArray object. */
+/* The type-specialized array of pointers that underlies a DynArray.
+   Its functions are generated by DYNARRAY_DEFINE (see dynarrayt.h). */
 
-enum {MIN_PHYS_LENGTH = 2};
+DYNARRAY_DEFINE(DynArray_Ptrs, const void*, DYNARRAY_INLINE_LENGTH)
 
 /*--------------------------------------------------------------------*/
 
-/* A DynArray consists of an array, along with its logical and
-   physical lengths. */
+/* Compare the elements at *pxElement1 and *pxElement2 with
+   *pfCompare. */
 
-struct DynArray
-{
-   /* The number of elements in the DynArray from the client's
-      point of view. */
-   size_t uLength;
+#define DYNARRAY_COMPARE(pxElement1, pxElement2, pfCompare) \
+   ((*(pfCompare))(*(pxElement1), *(pxElement2)))
 
-   /* The number of elements in the array that underlies the
-      DynArray. */
-   size_t uPhysLength;
+/* The type of the comparison functions that clients pass. */
 
-   /* The array that underlies the DynArray. */
-   const void **ppvArray;
+typedef int (*DynArray_Compare)(const void *pvElement1,
+                                const void *pvElement2);
+
+DYNARRAY_DEFINE_SORT(DynArray_Ptrs, const void*, DynArray_Compare,
+                     DYNARRAY_COMPARE)
+
+/*--------------------------------------------------------------------*/
+
+/* A DynArray is a thin wrapper around a DynArray_Ptrs, which consists
+   of an array, along with its logical and physical lengths.  Short
+   arrays live within the DynArray itself. */
+
+struct DynArray
+{
+   /* The array of pointers. */
+   DynArray_Ptrs sPtrs;
 };
 
+_Static_assert(sizeof(struct DynArray) <= sizeof(DynArray_Storage),
+               "DynArray_Storage is too small");
+
 /*--------------------------------------------------------------------*/
 
 #ifndef NDEBUG
@@ -41,76 +58,110 @@ struct DynArray
 
 static int DynArray_isValid(DynArray_T oDynArray)
 {
-   if (oDynArray->uPhysLength < MIN_PHYS_LENGTH) return 0;
-   if (oDynArray->uLength > oDynArray->uPhysLength) return 0;
-   if (oDynArray->ppvArray == NULL) return 0;
-   return 1;
+   return DynArray_Ptrs_isValid(&oDynArray->sPtrs);
 }
 
 #endif
 
 /*--------------------------------------------------------------------*/
 
-/* Increase the physical length of oDynArray.  Return 1 (TRUE) if
-   successful and 0 (FALSE) if insufficient memory is available. */
+DynArray_T DynArray_new(size_t uLength)
+{
+   DynArray_T oDynArray;
+
+   oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
+   if (oDynArray == NULL)
+      return NULL;
+
+   DynArray_Ptrs_init(&oDynArray->sPtrs);
+   if (uLength > DYNARRAY_INLINE_LENGTH)
+      if (! DynArray_Ptrs_grow(&oDynArray->sPtrs, uLength))
+      {
+         free(oDynArray);
+         return NULL;
+      }
+   memset(oDynArray->sPtrs.pxArray, 0, sizeof(void*) * uLength);
+   oDynArray->sPtrs.uLength = uLength;
 
-static int DynArray_grow(DynArray_T oDynArray)
+   return oDynArray;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_free(DynArray_T oDynArray)
 {
-   enum {GROWTH_FACTOR = 2};
-   
-   size_t uNewLength;
-   const void **ppvNewArray;
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
 
+   DynArray_destroy(oDynArray);
+   free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+DynArray_T DynArray_init(DynArray_Storage *psStorage)
+{
+   DynArray_T oDynArray = (struct DynArray*)psStorage;
+
+   assert(psStorage != NULL);
+
+   DynArray_Ptrs_init(&oDynArray->sPtrs);
+
+   return oDynArray;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_destroy(DynArray_T oDynArray)
+{
    assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   DynArray_Ptrs_destroy(&oDynArray->sPtrs);
+}
 
-   uNewLength = GROWTH_FACTOR * oDynArray->uPhysLength;
+/*--------------------------------------------------------------------*/
 
-   ppvNewArray = (const void**)
-      realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
-   if (ppvNewArray == NULL)
-      return 0;
+int DynArray_reserve(DynArray_T oDynArray, size_t uLength)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
 
-   oDynArray->uPhysLength = uNewLength;
-   oDynArray->ppvArray = ppvNewArray;
-   return 1;
+   return DynArray_Ptrs_reserve(&oDynArray->sPtrs, uLength);
 }
 
 /*--------------------------------------------------------------------*/
 
-DynArray_T DynArray_new(size_t uLength)
+void DynArray_clear(DynArray_T oDynArray)
 {
-   DynArray_T oDynArray;
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
 
-   oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
-   if (oDynArray == NULL)
-      return NULL;
+   DynArray_Ptrs_clear(&oDynArray->sPtrs);
+}
 
-   oDynArray->uLength = uLength;
-   if (uLength > MIN_PHYS_LENGTH)
-      oDynArray->uPhysLength = uLength;
-   else
-      oDynArray->uPhysLength = MIN_PHYS_LENGTH;
+/*--------------------------------------------------------------------*/
 
-   oDynArray->ppvArray =
-      (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
-   if (oDynArray->ppvArray == NULL)
-   {
-      free(oDynArray);
-      return NULL;
-   }
+int DynArray_addAll(DynArray_T oDynArray, DynArray_T oOther)
+{
+   assert(oDynArray != NULL);
+   assert(oOther != NULL);
+   assert(oOther != oDynArray);
+   assert(DynArray_isValid(oDynArray));
+   assert(DynArray_isValid(oOther));
 
-   return oDynArray;
+   return DynArray_Ptrs_addAll(&oDynArray->sPtrs, oOther->sPtrs.pxArray,
+                               oOther->sPtrs.uLength);
 }
 
 /*--------------------------------------------------------------------*/
 
-void DynArray_free(DynArray_T oDynArray)
+void DynArray_shrinkToFit(DynArray_T oDynArray)
 {
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   free(oDynArray->ppvArray);
-   free(oDynArray);
+   DynArray_Ptrs_shrinkToFit(&oDynArray->sPtrs);
 }
 
 /*--------------------------------------------------------------------*/
@@ -120,7 +171,7 @@ size_t DynArray_getLength(DynArray_T oDynArray)
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   return oDynArray->uLength;
+   return DynArray_Ptrs_getLength(&oDynArray->sPtrs);
 }
 
 /*--------------------------------------------------------------------*/
@@ -128,10 +179,9 @@ size_t DynArray_getLength(DynArray_T oDynArray)
 void *DynArray_get(DynArray_T oDynArray, size_t uIndex)
 {
    assert(oDynArray != NULL);
-   assert(uIndex < oDynArray->uLength);
    assert(DynArray_isValid(oDynArray));
 
-   return (void*)(oDynArray->ppvArray)[uIndex];
+   return (void*)DynArray_Ptrs_get(&oDynArray->sPtrs, uIndex);
 }
 
 /*--------------------------------------------------------------------*/
@@ -139,174 +189,400 @@ void *DynArray_get(DynArray_T oDynArray, size_t uIndex)
 void *DynArray_set(DynArray_T oDynArray, size_t uIndex,
                    const void *pvElement)
 {
-   const void *pvOldElement;
-
    assert(oDynArray != NULL);
-   assert(uIndex < oDynArray->uLength);
    assert(DynArray_isValid(oDynArray));
 
-   pvOldElement = oDynArray->ppvArray[uIndex];
-   oDynArray->ppvArray[uIndex] = pvElement;
+   return (void*)DynArray_Ptrs_set(&oDynArray->sPtrs, uIndex,
+                                   pvElement);
+}
+
+/*--------------------------------------------------------------------*/
 
+int DynArray_add(DynArray_T oDynArray, const void *pvElement)
+{
+   assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   return (void*)pvOldElement;
+   return DynArray_Ptrs_add(&oDynArray->sPtrs, pvElement);
 }
 
 /*--------------------------------------------------------------------*/
 
-int DynArray_add(DynArray_T oDynArray, const void *pvElement)
+int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
+                   const void *pvElement)
 {
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   if (oDynArray->uLength == oDynArray->uPhysLength)
-      if (! DynArray_grow(oDynArray))
-         return 0;
+   return DynArray_Ptrs_addAt(&oDynArray->sPtrs, uIndex, pvElement);
+}
 
-   oDynArray->ppvArray[oDynArray->uLength] = pvElement;
-   oDynArray->uLength++;
+/*--------------------------------------------------------------------*/
 
+void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
+{
+   assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   return 1;
+   return (void*)DynArray_Ptrs_removeAt(&oDynArray->sPtrs, uIndex);
 }
 
 /*--------------------------------------------------------------------*/
 
-int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
-                   const void *pvElement)
+void DynArray_toArray(DynArray_T oDynArray, void **ppvArray)
 {
    size_t u;
 
    assert(oDynArray != NULL);
-   assert(uIndex <= oDynArray->uLength);
+   assert(ppvArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   if (oDynArray->uLength == oDynArray->uPhysLength)
-      if (! DynArray_grow(oDynArray))
-         return 0;
+   for (u = 0; u < oDynArray->sPtrs.uLength; u++)
+      ppvArray[u] = (void*)oDynArray->sPtrs.pxArray[u];
+}
 
-   for (u = oDynArray->uLength; u > uIndex; u--)
-      oDynArray->ppvArray[u] = oDynArray->ppvArray[u-1];
+/*--------------------------------------------------------------------*/
 
-   oDynArray->ppvArray[uIndex] = pvElement;
-   oDynArray->uLength++;
+void DynArray_map(DynArray_T oDynArray,
+                  void (*pfApply)(void *pvElement, void *pvExtra),
+                  const void *pvExtra)
+{
+   size_t u;
 
+   assert(oDynArray != NULL);
+   assert(pfApply != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   return 1;
+   for (u = 0; u < oDynArray->sPtrs.uLength; u++)
+      (*pfApply)((void*)oDynArray->sPtrs.pxArray[u], (void*)pvExtra);
 }
 
 /*--------------------------------------------------------------------*/
 
-void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
+/* A loop over the elements of a DynArray, or over chunks of them, that
+   DynArray_parallelMap or DynArray_parallelReduce runs in parallel. */
+
+struct ParallelLoop
 {
-   const void *pvOldElement;
-   size_t u;
+   /* The elements. */
+   const void **ppvArray;
 
-   assert(oDynArray != NULL);
-   assert(uIndex < oDynArray->uLength);
-   assert(DynArray_isValid(oDynArray));
+   /* The number of elements. */
+   size_t uLength;
 
-   pvOldElement = oDynArray->ppvArray[uIndex];
+   /* The number of elements per chunk. */
+   size_t uGrain;
 
-   oDynArray->uLength--;
+   /* The functions to apply, and their extra argument. */
+   void (*pfApply)(void *pvElement, void *pvExtra);
+   void *(*pfAccumulate)(void *pvAccumulator, void *pvElement,
+                         void *pvExtra);
+   void *pvExtra;
 
-   for (u = uIndex; u < oDynArray->uLength; u++)
-      oDynArray->ppvArray[u] = oDynArray->ppvArray[u+1];
+   /* The initial accumulator of each chunk. */
+   const void *pvInitial;
 
-   assert(DynArray_isValid(oDynArray));
+   /* The accumulators of the chunks. */
+   void **ppvResults;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the function of pvLoop, a struct ParallelLoop, to its elements
+   uLo...uHi-1. */
 
-   return (void*)pvOldElement;
+static void DynArray_mapRange(size_t uLo, size_t uHi, void *pvLoop)
+{
+   struct ParallelLoop *psLoop = (struct ParallelLoop*)pvLoop;
+   size_t u;
+
+   for (u = uLo; u < uHi; u++)
+      (*psLoop->pfApply)((void*)psLoop->ppvArray[u], psLoop->pvExtra);
 }
 
 /*--------------------------------------------------------------------*/
 
-void DynArray_toArray(DynArray_T oDynArray, void **ppvArray)
+/* Fold the elements of chunk uChunk of psLoop into its accumulator,
+   and return it. */
+
+static void *DynArray_reduceChunk(struct ParallelLoop *psLoop,
+                                  size_t uChunk)
+{
+   void *pvAccumulator = (void*)psLoop->pvInitial;
+   size_t uLo = uChunk * psLoop->uGrain;
+   size_t uHi = (psLoop->uLength - uLo > psLoop->uGrain) ?
+      uLo + psLoop->uGrain : psLoop->uLength;
+   size_t u;
+
+   for (u = uLo; u < uHi; u++)
+      pvAccumulator = (*psLoop->pfAccumulate)(
+         pvAccumulator, (void*)psLoop->ppvArray[u], psLoop->pvExtra);
+   return pvAccumulator;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Reduce the chunks uLo...uHi-1 of pvLoop, a struct ParallelLoop, into
+   its results. */
+
+static void DynArray_reduceChunks(size_t uLo, size_t uHi, void *pvLoop)
 {
+   struct ParallelLoop *psLoop = (struct ParallelLoop*)pvLoop;
    size_t u;
 
+   for (u = uLo; u < uHi; u++)
+      psLoop->ppvResults[u] = DynArray_reduceChunk(psLoop, u);
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_parallelMap(DynArray_T oDynArray,
+                          void (*pfApply)(void *pvElement,
+                                          void *pvExtra),
+                          const void *pvExtra,
+                          size_t uGrain)
+{
+   ThreadPool_T oThreadPool;
+   struct ParallelLoop sLoop;
+
    assert(oDynArray != NULL);
-   assert(ppvArray != NULL);
+   assert(pfApply != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   for (u = 0; u < oDynArray->uLength; u++)
-      ppvArray[u] = (void*)oDynArray->ppvArray[u];
+   if (oDynArray->sPtrs.uLength <= uGrain ||
+       (oThreadPool = ThreadPool_getShared()) == NULL)
+   {
+      DynArray_map(oDynArray, pfApply, pvExtra);
+      return;
+   }
+
+   sLoop.ppvArray = oDynArray->sPtrs.pxArray;
+   sLoop.pfApply = pfApply;
+   sLoop.pvExtra = (void*)pvExtra;
+   ThreadPool_run(oThreadPool, oDynArray->sPtrs.uLength, uGrain,
+                  DynArray_mapRange, &sLoop);
 }
 
 /*--------------------------------------------------------------------*/
 
-void DynArray_map(DynArray_T oDynArray,
-                  void (*pfApply)(void *pvElement, void *pvExtra),
-                  const void *pvExtra)
+void *DynArray_parallelReduce(
+   DynArray_T oDynArray,
+   const void *pvInitial,
+   void *(*pfAccumulate)(void *pvAccumulator, void *pvElement,
+                         void *pvExtra),
+   void *(*pfCombine)(void *pvLeft, void *pvRight, void *pvExtra),
+   const void *pvExtra,
+   size_t uGrain)
 {
+   ThreadPool_T oThreadPool = NULL;
+   struct ParallelLoop sLoop;
+   size_t uChunks;
+   void *pvResult;
    size_t u;
 
    assert(oDynArray != NULL);
-   assert(pfApply != NULL);
+   assert(pfAccumulate != NULL);
+   assert(pfCombine != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   for (u = 0; u < oDynArray->uLength; u++)
-      (*pfApply)((void*)oDynArray->ppvArray[u], (void*)pvExtra);
+   if (oDynArray->sPtrs.uLength == 0)
+      return (void*)pvInitial;
+   if (uGrain == 0)
+      uGrain = 1;
+
+   sLoop.ppvArray = oDynArray->sPtrs.pxArray;
+   sLoop.uLength = oDynArray->sPtrs.uLength;
+   sLoop.uGrain = uGrain;
+   sLoop.pfAccumulate = pfAccumulate;
+   sLoop.pvExtra = (void*)pvExtra;
+   sLoop.pvInitial = pvInitial;
+   uChunks = (sLoop.uLength - 1) / uGrain + 1;
+
+   sLoop.ppvResults = NULL;
+   if (uChunks > 1 && (oThreadPool = ThreadPool_getShared()) != NULL)
+      sLoop.ppvResults = (void**)malloc(sizeof(void*) * uChunks);
+
+   /* Without results to fill in parallel, reduce the same chunks here
+      and combine them in the same order. */
+   if (sLoop.ppvResults == NULL)
+   {
+      pvResult = DynArray_reduceChunk(&sLoop, 0);
+      for (u = 1; u < uChunks; u++)
+         pvResult = (*pfCombine)(pvResult,
+                                 DynArray_reduceChunk(&sLoop, u),
+                                 (void*)pvExtra);
+      return pvResult;
+   }
+
+   ThreadPool_run(oThreadPool, uChunks, 1, DynArray_reduceChunks,
+                  &sLoop);
+   pvResult = sLoop.ppvResults[0];
+   for (u = 1; u < uChunks; u++)
+      pvResult = (*pfCombine)(pvResult, sLoop.ppvResults[u],
+                              (void*)pvExtra);
+   free(sLoop.ppvResults);
+   return pvResult;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Sort the array of elements that resides in memory at
-   addresses ppvLo...ppvHi in ascending order, as determined
-   by *pfCompare.
-   *pfCompare must return <0, 0, or >0 depending upon whether
-   *pvElement1 is less than, equal to, or greater than *pvElement2,
-   respectively. */
+/* A slice of an array that one thread of DynArray_parallelSort sorts,
+   or a pair of adjacent sorted slices that one thread merges. */
 
-static void DynArray_qsort(
-   const void **ppvLo,
-   const void **ppvHi,
-   int (*pfCompare) (const void *pvElement1, const void *pvElement2))
+struct SortTask
 {
-   /* This function implements a variation of the quicksort algorithm
-      shown in the book "Algorithms + Data Structures = Programs" by 
-      Niklaus Wirth. */
-      
-   /* This function uses pointers instead of indices to avoid
-      complications with using unsigned integers as array indices. */
+   /* The elements to sort, or the two runs to merge. */
+   const void **ppvSource;
 
-   const void **ppvRight;
-   const void **ppvLeft;
-   const void *pvPivot;
-   const void *pvTemp;
+   /* Where to write the merged runs. */
+   const void **ppvDest;
+
+   /* The length of the first run and of both runs together. */
+   size_t uMid;
+   size_t uLength;
+
+   /* The comparison function. */
+   DynArray_Compare pfCompare;
+
+   /* The thread that performs the task. */
+   pthread_t sThread;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Sort the slice that pvTask, a struct SortTask, describes. */
+
+static void *DynArray_sortSlice(void *pvTask)
+{
+   struct SortTask *psTask = (struct SortTask*)pvTask;
+
+   DynArray_Ptrs_sortRange(psTask->ppvSource, psTask->uLength,
+                           psTask->pfCompare);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Merge the runs that pvTask, a struct SortTask, describes. */
+
+static void *DynArray_mergeRuns(void *pvTask)
+{
+   struct SortTask *psTask = (struct SortTask*)pvTask;
+
+   DynArray_Ptrs_merge(psTask->ppvSource, psTask->uMid,
+                       psTask->ppvSource + psTask->uMid,
+                       psTask->uLength - psTask->uMid,
+                       psTask->ppvDest, psTask->pfCompare);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Perform the uTasks tasks at psTasks by calling *pfRun, each in its
+   own thread.  A task whose thread cannot be created runs in the
+   calling thread instead. */
+
+static void DynArray_runTasks(struct SortTask *psTasks, size_t uTasks,
+                              void *(*pfRun)(void *pvTask))
+{
+   size_t u;
+   int *piStarted = (int*)calloc(uTasks, sizeof(int));
+
+   for (u = 1; u < uTasks; u++)
+      if (piStarted != NULL &&
+          pthread_create(&psTasks[u].sThread, NULL, pfRun,
+                         &psTasks[u]) == 0)
+         piStarted[u] = 1;
+   for (u = 0; u < uTasks; u++)
+      if (piStarted == NULL || ! piStarted[u])
+         (*pfRun)(&psTasks[u]);
+   for (u = 1; u < uTasks; u++)
+      if (piStarted != NULL && piStarted[u])
+         pthread_join(psTasks[u].sThread, NULL);
+   free(piStarted);
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_parallelSort(DynArray_T oDynArray,
+                           int (*pfCompare)(const void *pvElement1,
+                                            const void *pvElement2),
+                           size_t uThreads)
+{
+   struct SortTask asTasks[DYNARRAY_MAX_SORT_THREADS];
+   const void **ppvSource;
+   const void **ppvDest;
+   const void **ppvTemp;
+   size_t uLength;
+   size_t uRuns;
+   size_t uWidth;
+   size_t u;
 
-   assert(ppvLo != NULL);
-   assert(ppvHi != NULL);
+   assert(oDynArray != NULL);
    assert(pfCompare != NULL);
-         
-   ppvRight = ppvLo;
-   ppvLeft = ppvHi;
-   pvPivot = *(ppvLo + ((ppvHi - ppvLo) / 2));
-      
-   while (ppvRight <= ppvLeft)
+   assert(DynArray_isValid(oDynArray));
+
+   uLength = oDynArray->sPtrs.uLength;
+
+   /* Use a power of 2 number of runs, so that they merge evenly. */
+   for (uRuns = 1; uRuns * 2 <= uThreads &&
+           uRuns * 2 <= DYNARRAY_MAX_SORT_THREADS &&
+           uLength / (uRuns * 2) >= DYNARRAY_MIN_SORT_SLICE; uRuns *= 2)
+      ;
+
+   ppvTemp = NULL;
+   if (uRuns > 1)
+      ppvTemp = (const void**)malloc(sizeof(void*) * uLength);
+   if (ppvTemp == NULL)
    {
-      while ((*pfCompare)(*ppvRight, pvPivot) < 0)
-         ppvRight++;
-      while ((*pfCompare)(pvPivot, *ppvLeft) < 0)
-         ppvLeft--; 
-      if (ppvRight <= ppvLeft)
+      DynArray_Ptrs_sort(&oDynArray->sPtrs, pfCompare);
+      return;
+   }
+
+   /* Sort the runs. */
+   ppvSource = oDynArray->sPtrs.pxArray;
+   for (u = 0; u < uRuns; u++)
+   {
+      asTasks[u].ppvSource = ppvSource + uLength / uRuns * u;
+      asTasks[u].uLength = (u == uRuns - 1) ?
+         uLength - uLength / uRuns * u : uLength / uRuns;
+      asTasks[u].pfCompare = pfCompare;
+   }
+   DynArray_runTasks(asTasks, uRuns, DynArray_sortSlice);
+
+   /* Merge pairs of adjacent runs, doubling their width each pass and
+      alternating between the array and ppvTemp. */
+   ppvDest = ppvTemp;
+   for (uWidth = 1; uWidth < uRuns; uWidth *= 2)
+   {
+      for (u = 0; u < uRuns / (2 * uWidth); u++)
       {
-         /* Swap *ppvRight and *ppvLeft. */
-         pvTemp = *ppvRight;
-         *ppvRight = *ppvLeft;
-         *ppvLeft = pvTemp;
-         
-         ppvRight++;
-         ppvLeft--;
+         size_t uStart = uLength / uRuns * (2 * uWidth * u);
+         size_t uEnd = (u == uRuns / (2 * uWidth) - 1) ? uLength :
+            uLength / uRuns * (2 * uWidth * (u + 1));
+
+         asTasks[u].ppvSource = ppvSource + uStart;
+         asTasks[u].ppvDest = ppvDest + uStart;
+         asTasks[u].uMid = uLength / uRuns * uWidth;
+         asTasks[u].uLength = uEnd - uStart;
+         asTasks[u].pfCompare = pfCompare;
       }
+      DynArray_runTasks(asTasks, uRuns / (2 * uWidth),
+                        DynArray_mergeRuns);
+      ppvTemp = ppvSource;
+      ppvSource = ppvDest;
+      ppvDest = ppvTemp;
+   }
+
+   if (ppvSource != oDynArray->sPtrs.pxArray)
+   {
+      memcpy(oDynArray->sPtrs.pxArray, ppvSource,
+             sizeof(void*) * uLength);
+      free(ppvSource);
    }
-       
-   if (ppvLo < ppvLeft)
-      DynArray_qsort(ppvLo, ppvLeft, pfCompare);
-   if (ppvRight < ppvHi)
-      DynArray_qsort(ppvRight, ppvHi, pfCompare);
+   else free(ppvDest);
+
+   assert(DynArray_isValid(oDynArray));
 }
 
 /*--------------------------------------------------------------------*/
@@ -318,109 +594,101 @@ void DynArray_sort(DynArray_T oDynArray,
    assert(oDynArray != NULL);
    assert(pfCompare != NULL);
    assert(DynArray_isValid(oDynArray));
-   
-   if (oDynArray->uLength < 2)
-      return;
-   
-   DynArray_qsort( 
-      &oDynArray->ppvArray[0], 
-      &oDynArray->ppvArray[oDynArray->uLength-1],
-      pfCompare);
 
-   assert(DynArray_isValid(oDynArray));
+   DynArray_Ptrs_sort(&oDynArray->sPtrs, pfCompare);
 }
 
 /*--------------------------------------------------------------------*/
 
-int DynArray_search(DynArray_T oDynArray, 
+int DynArray_search(DynArray_T oDynArray,
                     void *pvSoughtElement,
                     size_t *puIndex,
                     int (*pfCompare)(const void *pvElement1,
                                      const void *pvElement2))
 {
-   size_t u;
+   const void *pvSought = pvSoughtElement;
 
    assert(oDynArray != NULL);
    assert(puIndex != NULL);
    assert(pfCompare != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   for (u = 0; u < oDynArray->uLength; u++)
-      if ((*pfCompare)(oDynArray->ppvArray[u], pvSoughtElement) == 0)
-      {
-         *puIndex = u;
-         return 1;
-      }
-   return 0;
+   return DynArray_Ptrs_search(&oDynArray->sPtrs, &pvSought, puIndex,
+                               pfCompare);
 }
 
+/*--------------------------------------------------------------------*/
+
+int DynArray_bsearch(DynArray_T oDynArray,
+                     void *pvSoughtElement,
+                     size_t *puIndex,
+                     int (*pfCompare)(const void *pvElement1,
+                                      const void *pvElement2))
+{
+   const void *pvSought = pvSoughtElement;
+
+   assert(oDynArray != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompare != NULL);
+   assert(DynArray_isValid(oDynArray));
 
+   return DynArray_Ptrs_bsearch(&oDynArray->sPtrs, &pvSought, puIndex,
+                                pfCompare);
+}
 
 /*--------------------------------------------------------------------*/
 
-/* Binary search the array of elements that resides in memory at
-   addresses ppvLo...ppvHi for pvSoughtElement.
-   *pfCompare must return <0, 0, or >0 depending upon whether
-   *pvElement1 is less than, equal to, or greater than *pvElement2,
-   respectively. */
-      
-static const void **DynArray_bsearchHelp(
-   void *pvSoughtElement,
-   const void **ppvLo,
-   const void **ppvHi,
-   int (*pfCompare)(const void *pvElement1, const void *pvElement2))
+size_t DynArray_lowerBound(DynArray_T oDynArray,
+                           void *pvSoughtElement,
+                           int (*pfCompare)(const void *pvElement1,
+                                            const void *pvElement2))
 {
-   /* This function uses pointers instead of indices to avoid
-      complications with using unsigned integers as array indices. */
+   const void *pvSought = pvSoughtElement;
 
-   const void **ppvMid;
-   int iCompare;
-
-   assert(ppvLo != NULL);
-   assert(ppvHi != NULL);
+   assert(oDynArray != NULL);
    assert(pfCompare != NULL);
-   
-   while (ppvLo <= ppvHi)
-   {
-      ppvMid = ppvLo + ((ppvHi - ppvLo) / 2);
-      iCompare = (*pfCompare)(pvSoughtElement, *ppvMid);
-      if (iCompare < 0)
-         ppvHi = ppvMid - 1;
-      else if (iCompare > 0)
-         ppvLo = ppvMid + 1;
-      else
-         return ppvMid;
-   }
-   return NULL;
+   assert(DynArray_isValid(oDynArray));
+
+   return DynArray_Ptrs_lowerBound(oDynArray->sPtrs.pxArray,
+                                   oDynArray->sPtrs.uLength, &pvSought,
+                                   pfCompare);
 }
-                     
+
 /*--------------------------------------------------------------------*/
 
-int DynArray_bsearch(DynArray_T oDynArray, 
-                     void *pvSoughtElement,
-                     size_t *puIndex,
-                     int (*pfCompare)(const void *pvElement1,
-                                      const void *pvElement2))
+size_t DynArray_bsearchBatch(DynArray_T oDynArray,
+                             void **ppvSoughtElements,
+                             size_t uCount,
+                             size_t *puIndices,
+                             int (*pfCompare)(const void *pvElement1,
+                                              const void *pvElement2))
 {
-   const void **ppvElement;
-   
+   const void **ppvArray;
+   size_t uLength;
+   size_t uFound = 0;
+   size_t u;
+
    assert(oDynArray != NULL);
-   assert(puIndex != NULL);
+   assert(ppvSoughtElements != NULL || uCount == 0);
+   assert(puIndices != NULL || uCount == 0);
    assert(pfCompare != NULL);
    assert(DynArray_isValid(oDynArray));
-   
-   if (oDynArray->uLength == 0)
-      return 0;
-   
-   ppvElement = DynArray_bsearchHelp(
-      pvSoughtElement,
-      &oDynArray->ppvArray[0], 
-      &oDynArray->ppvArray[oDynArray->uLength-1],
-      pfCompare);
-   
-   if (ppvElement == NULL)
-      return 0;
-   
-   *puIndex = (size_t)(ppvElement - &oDynArray->ppvArray[0]);
-   return 1;
+
+   ppvArray = oDynArray->sPtrs.pxArray;
+   uLength = oDynArray->sPtrs.uLength;
+   DynArray_Ptrs_lowerBoundBatch(ppvArray, uLength,
+                                 (const void**)ppvSoughtElements,
+                                 uCount, puIndices, pfCompare);
+
+   /* Keep only the exact matches. */
+   for (u = 0; u < uCount; u++)
+   {
+      if (puIndices[u] < uLength &&
+          (*pfCompare)(ppvSoughtElements[u],
+                       ppvArray[puIndices[u]]) == 0)
+         uFound++;
+      else
+         puIndices[u] = DYNARRAY_NOT_FOUND;
+   }
+   return uFound;
 }
@@ -15,6 +15,21 @@ typedef struct DynArray *DynArray_T;
 
 /*--------------------------------------------------------------------*/
 
+/* The number of elements that a DynArray_T object stores within
+   itself.  Only longer arrays allocate memory for their elements. */
+
+enum {DYNARRAY_INLINE_LENGTH = 8};
+
+/* Memory in which a client, for example on its stack, can hold a
+   DynArray_T object.  Clients must not access its contents. */
+
+typedef struct DynArray_Storage
+{
+   void *apvOpaque[DYNARRAY_INLINE_LENGTH + 4];
+} DynArray_Storage;
+
+/*--------------------------------------------------------------------*/
+
 /* Return a new DynArray_T object whose length is uLength, or
    NULL if insufficient memory is available. */
 
@@ -22,12 +37,57 @@ DynArray_T DynArray_new(size_t uLength);
 
 /*--------------------------------------------------------------------*/
 
-/* Free oDynArray. */
+/* Free oDynArray, which must have been created by DynArray_new. */
 
 void DynArray_free(DynArray_T oDynArray);
 
 /*--------------------------------------------------------------------*/
 
+/* Return a new DynArray_T object of length 0 that resides in
+   *psStorage.  It allocates no memory until it grows beyond
+   DYNARRAY_INLINE_LENGTH elements. */
+
+DynArray_T DynArray_init(DynArray_Storage *psStorage);
+
+/*--------------------------------------------------------------------*/
+
+/* Free the memory that oDynArray, which must have been created by
+   DynArray_init, allocated.  Its storage then can be reused. */
+
+void DynArray_destroy(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oDynArray for uLength elements, so that adding up to
+   that many allocates no memory.  Return 1 (TRUE) if successful, or
+   0 (FALSE) if insufficient memory is available. */
+
+int DynArray_reserve(DynArray_T oDynArray, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove all elements of oDynArray, keeping the memory that holds them
+   so that oDynArray can be refilled without allocating memory. */
+
+void DynArray_clear(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Add the elements of oOther to the end of oDynArray, in order.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available. */
+
+int DynArray_addAll(DynArray_T oDynArray, DynArray_T oOther);
+
+/*--------------------------------------------------------------------*/
+
+/* Free whatever memory oDynArray holds beyond what its elements
+   need. */
+
+void DynArray_shrinkToFit(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
 /* Return the length of oDynArray. */
 
 size_t DynArray_getLength(DynArray_T oDynArray);
@@ -58,14 +118,15 @@ int DynArray_add(DynArray_T oDynArray, const void *pvElement);
 
 /* Add pvElement to oDynArray such that it is the uIndex'th element.
    Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
-   is available. */
+   is available.  Adding at either end takes amortized O(1) time. */
 
 int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
                    const void *pvElement);
 
 /*--------------------------------------------------------------------*/
 
-/* Remove and return the uIndex'th element of oDynArray. */
+/* Remove and return the uIndex'th element of oDynArray.  Removing at
+   either end takes O(1) time. */
 
 void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex);
 
@@ -89,10 +150,49 @@ void DynArray_map(DynArray_T oDynArray,
 
 /*--------------------------------------------------------------------*/
 
-/* Sort oDynArray in the order determined by *pfCompare.
+/* Apply function *pfApply to each element of oDynArray like
+   DynArray_map, but in parallel on the threads of the shared
+   ThreadPool (see threadPool.h), uGrain elements at a time.  The calls
+   may run concurrently and in any order.  Arrays of at most uGrain
+   elements are mapped serially in the calling thread. */
+
+void DynArray_parallelMap(DynArray_T oDynArray,
+                          void (*pfApply)(void *pvElement,
+                                          void *pvExtra),
+                          const void *pvExtra,
+                          size_t uGrain);
+
+/*--------------------------------------------------------------------*/
+
+/* Reduce oDynArray to a single value in parallel, and return it.
+   oDynArray is divided into chunks of uGrain elements (uGrain 0 is
+   treated as 1).  Each chunk starts with pvInitial as its accumulator
+   and folds in its elements in order, replacing the accumulator with
+   (*pfAccumulate)(pvAccumulator, pvElement, pvExtra).  The results of
+   the chunks are then combined from left to right with
+   (*pfCombine)(pvLeft, pvRight, pvExtra).  Because the chunks and the
+   order of combination do not depend on how the chunks are scheduled,
+   the result is the same on every run.  Return pvInitial if oDynArray
+   is empty. */
+
+void *DynArray_parallelReduce(
+   DynArray_T oDynArray,
+   const void *pvInitial,
+   void *(*pfAccumulate)(void *pvAccumulator, void *pvElement,
+                         void *pvExtra),
+   void *(*pfCombine)(void *pvLeft, void *pvRight, void *pvExtra),
+   const void *pvExtra,
+   size_t uGrain);
+
+/*--------------------------------------------------------------------*/
+
+/* Sort oDynArray in the order determined by *pfCompare, in
+   O(n log n) time even for adversarial input, and in O(n) time for
+   input that consists of a few runs in order or in reverse order.
    *pfCompare must return <0, 0, or >0 depending upon whether
    *pvElement1 is less than, equal to, or greater than *pvElement2,
-   respectively. */
+   respectively.  The sort runs in the calling thread; see
+   DynArray_parallelSort for one that does not. */
 
 void DynArray_sort(DynArray_T oDynArray,
                    int (*pfCompare)(const void *pvElement1,
@@ -100,6 +200,24 @@ void DynArray_sort(DynArray_T oDynArray,
 
 /*--------------------------------------------------------------------*/
 
+/* The most threads, and the fewest elements per thread, that
+   DynArray_parallelSort uses. */
+
+enum {DYNARRAY_MAX_SORT_THREADS = 16, DYNARRAY_MIN_SORT_SLICE = 32768};
+
+/* Sort oDynArray like DynArray_sort, using up to uThreads threads.
+   Each thread sorts a slice of oDynArray, and then pairs of sorted
+   slices are merged in parallel, so *pfCompare must be safe to call
+   from several threads at once.  If a temporary copy of oDynArray
+   cannot be allocated, then sort it in the calling thread. */
+
+void DynArray_parallelSort(DynArray_T oDynArray,
+                           int (*pfCompare)(const void *pvElement1,
+                                            const void *pvElement2),
+                           size_t uThreads);
+
+/*--------------------------------------------------------------------*/
+
 /* Linear search oDynArray for *pvSoughtElement using *pfCompare to
    determine equality.  If the element is found, then assign its
    index to *puIndex and return 1.  If the element is not found, then
@@ -120,7 +238,9 @@ int DynArray_search(DynArray_T oDynArray,
    index to *puIndex and return 1.  If the element is not found, then
    assign nothing to *puIndex and return 0.
    *pfCompare must return <0, 0, or >0 if *pvElement1 is less than,
-   equal to, or greater than *pvElement2.
+   equal to, or greater than *pvElement2.  It is always called with
+   pvSoughtElement as pvElement1 and an element of oDynArray as
+   pvElement2, as bsearch calls its comparison function.
    oDynArray must be sorted as determined by *pfCompare. */
 
 int DynArray_bsearch(DynArray_T oDynArray, 
@@ -129,4 +249,40 @@ int DynArray_bsearch(DynArray_T oDynArray,
                      int (*pfCompare)(const void *pvElement1,
                                       const void *pvElement2));
 
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the first element of oDynArray that is not less
+   than pvSoughtElement as determined by *pfCompare, or the length of
+   oDynArray if there is none.  *pfCompare is called as by
+   DynArray_bsearch, with pvSoughtElement first.  oDynArray must be
+   sorted as determined by *pfCompare. */
+
+size_t DynArray_lowerBound(DynArray_T oDynArray,
+                           void *pvSoughtElement,
+                           int (*pfCompare)(const void *pvElement1,
+                                            const void *pvElement2));
+
+/*--------------------------------------------------------------------*/
+
+/* The index that DynArray_bsearchBatch assigns to elements that it
+   does not find. */
+
+#define DYNARRAY_NOT_FOUND ((size_t)-1)
+
+/* Binary search oDynArray for each of the uCount elements in
+   ppvSoughtElements, as DynArray_bsearch does, but with the searches
+   interleaved to hide the latency of memory.  Assign the index of each
+   element that is found to the corresponding element of puIndices, and
+   DYNARRAY_NOT_FOUND for each element that is not.  Return the number
+   of elements found.  *pfCompare is called as by DynArray_bsearch,
+   with the sought element first.  oDynArray must be sorted as
+   determined by *pfCompare. */
+
+size_t DynArray_bsearchBatch(DynArray_T oDynArray,
+                             void **ppvSoughtElements,
+                             size_t uCount,
+                             size_t *puIndices,
+                             int (*pfCompare)(const void *pvElement1,
+                                              const void *pvElement2));
+
 #endif
@@ -0,0 +1,281 @@
+/*--------------------------------------------------------------------*/
+/* dynarraybench.c                                                    */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "dynarray.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The default number of elements to sort. */
+
+enum {DEFAULT_LENGTH = 1000000};
+
+/* The input patterns to benchmark. */
+
+enum Pattern {PATTERN_RANDOM, PATTERN_SORTED, PATTERN_REVERSED,
+              PATTERN_ORGAN_PIPE, PATTERN_FEW_UNIQUE,
+              PATTERN_NEARLY_SORTED, PATTERN_COUNT};
+
+static const char *apcPatternNames[PATTERN_COUNT] =
+   {"random", "sorted", "reversed", "organ-pipe", "few-unique",
+    "nearly-sorted"};
+
+/* The number of comparisons made by compareCounting. */
+
+static unsigned long ulComparisons;
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the strings at pvElement1 and pvElement2 by strcmp. */
+
+static int compareStrings(const void *pvElement1,
+                          const void *pvElement2)
+{
+   return strcmp((const char*)pvElement1, (const char*)pvElement2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Like compareStrings, but count the calls in ulComparisons.  Only
+   single-threaded sorts may use it. */
+
+static int compareCounting(const void *pvElement1,
+                           const void *pvElement2)
+{
+   ulComparisons++;
+   return compareStrings(pvElement1, pvElement2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the string pointers at ppvElement1 and ppvElement2, as
+   qsort requires. */
+
+static int compareIndirect(const void *ppvElement1,
+                           const void *ppvElement2)
+{
+   return strcmp(*(char* const*)ppvElement1,
+                 *(char* const*)ppvElement2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the string at pvKey with the string pointer at ppvElement,
+   as bsearch requires. */
+
+static int compareKey(const void *pvKey, const void *ppvElement)
+{
+   return strcmp((const char*)pvKey, *(char* const*)ppvElement);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds since an arbitrary point. */
+
+static double now(void)
+{
+   struct timespec sTime;
+
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill ppcKeys with uLength distinct strings arranged in pattern
+   ePattern.  Each string lives in pcStorage, 16 bytes apart. */
+
+static void fillKeys(char **ppcKeys, char *pcStorage, size_t uLength,
+                     enum Pattern ePattern)
+{
+   size_t u;
+   size_t uValue;
+
+   for (u = 0; u < uLength; u++)
+   {
+      switch (ePattern)
+      {
+         case PATTERN_SORTED: uValue = u; break;
+         case PATTERN_REVERSED: uValue = uLength - u; break;
+         case PATTERN_ORGAN_PIPE:
+            uValue = (u < uLength / 2) ? u : uLength - u; break;
+         case PATTERN_FEW_UNIQUE: uValue = (size_t)rand() % 16; break;
+         case PATTERN_NEARLY_SORTED:
+            uValue = (u % 100 == 0) ? (size_t)rand() % uLength : u;
+            break;
+         default: uValue = (size_t)rand(); break;
+      }
+      ppcKeys[u] = pcStorage + 16 * u;
+      sprintf(ppcKeys[u], "%012lu", (unsigned long)uValue);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up uLength keys, about half of which are present, in the
+   uLength sorted keys of oDynArray and ppcSorted with bsearch,
+   DynArray_bsearch and DynArray_bsearchBatch, and write the times to
+   stdout.  ppcKeys and pcStorage are scratch space as large as the
+   arrays that fillKeys fills.  pcPgmName is the name of the
+   program. */
+
+static void lookUp(DynArray_T oDynArray, char **ppcSorted,
+                   char **ppcKeys, char *pcStorage, size_t uLength,
+                   const char *pcPgmName)
+{
+   size_t *puIndices;
+   char *pcAbsent;
+   size_t uFound = 0;
+   size_t uFoundBatch;
+   size_t uIndex;
+   double dStart, dBsearch, dSingle, dBatch;
+   size_t u;
+
+   puIndices = (size_t*)malloc(sizeof(size_t) * uLength);
+   pcAbsent = (char*)malloc(16 * (uLength / 2 + 1));
+   if (puIndices == NULL || pcAbsent == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   fillKeys(ppcKeys, pcStorage, uLength, PATTERN_RANDOM);
+   for (u = 0; u < uLength; u++)
+      DynArray_set(oDynArray, u, ppcKeys[u]);
+   DynArray_sort(oDynArray, compareStrings);
+   DynArray_toArray(oDynArray, (void**)ppcSorted);
+
+   /* Look up present keys and fresh ones, which are almost certainly
+      absent, in turn. */
+   for (u = 0; u < uLength; u++)
+   {
+      if (u % 2 == 0)
+         ppcKeys[u] = ppcSorted[(size_t)rand() % uLength];
+      else
+      {
+         ppcKeys[u] = pcAbsent + 16 * (u / 2);
+         sprintf(ppcKeys[u], "%012lu", (unsigned long)rand());
+      }
+   }
+
+   dStart = now();
+   for (u = 0; u < uLength; u++)
+      uFound += bsearch(ppcKeys[u], ppcSorted, uLength, sizeof(char*),
+                        compareKey) != NULL;
+   dBsearch = now() - dStart;
+
+   dStart = now();
+   for (u = 0; u < uLength; u++)
+      DynArray_bsearch(oDynArray, ppcKeys[u], &uIndex, compareStrings);
+   dSingle = now() - dStart;
+
+   dStart = now();
+   uFoundBatch = DynArray_bsearchBatch(oDynArray, (void**)ppcKeys,
+                                       uLength, puIndices,
+                                       compareStrings);
+   dBatch = now() - dStart;
+
+   if (uFound != uFoundBatch)
+   {
+      fprintf(stderr, "%s: search mismatch\n", pcPgmName);
+      exit(EXIT_FAILURE);
+   }
+
+   printf("\n%lu lookups, %lu found (seconds)\n",
+          (unsigned long)uLength, (unsigned long)uFound);
+   printf("%10s %10s %10s\n", "bsearch", "single", "batch");
+   printf("%10.4f %10.4f %10.4f\n", dBsearch, dSingle, dBatch);
+
+   free(pcAbsent);
+   free(puIndices);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Sort uLength keys in each pattern with qsort, DynArray_sort in one
+   thread, and DynArray_parallelSort in as many threads as there are
+   processors, and write the times to stdout.  Then time lookups (see
+   lookUp).  The optional argument is the number of keys. */
+
+int main(int argc, char *argv[])
+{
+   size_t uLength = DEFAULT_LENGTH;
+   long lThreads;
+   char *pcStorage;
+   char **ppcKeys;
+   char **ppcCopy;
+   DynArray_T oDynArray;
+   enum Pattern ePattern;
+   double dStart, dQsort, dSerial, dParallel;
+   size_t u;
+
+   if (argc > 2 || (argc == 2 && (uLength = strtoul(argv[1], NULL, 10))
+                    == 0))
+   {
+      fprintf(stderr, "Usage: %s [length]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   lThreads = sysconf(_SC_NPROCESSORS_ONLN);
+   if (lThreads < 1)
+      lThreads = 1;
+
+   pcStorage = (char*)malloc(16 * uLength);
+   ppcKeys = (char**)malloc(sizeof(char*) * uLength);
+   ppcCopy = (char**)malloc(sizeof(char*) * uLength);
+   oDynArray = DynArray_new(uLength);
+   if (pcStorage == NULL || ppcKeys == NULL || ppcCopy == NULL ||
+       oDynArray == NULL)
+      {perror(argv[0]); exit(EXIT_FAILURE);}
+
+   printf("%lu keys, %ld threads (seconds; comparisons per key)\n",
+          (unsigned long)uLength, lThreads);
+   printf("%-14s %10s %10s %10s %8s\n", "pattern", "qsort", "sort",
+          "parallel", "cmp/key");
+
+   for (ePattern = 0; ePattern < PATTERN_COUNT; ePattern++)
+   {
+      fillKeys(ppcKeys, pcStorage, uLength, ePattern);
+
+      memcpy(ppcCopy, ppcKeys, sizeof(char*) * uLength);
+      dStart = now();
+      qsort(ppcCopy, uLength, sizeof(char*), compareIndirect);
+      dQsort = now() - dStart;
+
+      for (u = 0; u < uLength; u++)
+         DynArray_set(oDynArray, u, ppcKeys[u]);
+      ulComparisons = 0;
+      dStart = now();
+      DynArray_sort(oDynArray, compareCounting);
+      dSerial = now() - dStart;
+
+      for (u = 0; u < uLength; u++)
+         DynArray_set(oDynArray, u, ppcKeys[u]);
+      dStart = now();
+      DynArray_parallelSort(oDynArray, compareStrings,
+                            (size_t)lThreads);
+      dParallel = now() - dStart;
+
+      /* Check the result against qsort. */
+      for (u = 0; u < uLength; u++)
+         if (strcmp((char*)DynArray_get(oDynArray, u), ppcCopy[u]) != 0)
+         {
+            fprintf(stderr, "%s: sort mismatch\n", argv[0]);
+            exit(EXIT_FAILURE);
+         }
+
+      printf("%-14s %10.4f %10.4f %10.4f %8.2f\n",
+             apcPatternNames[ePattern], dQsort, dSerial, dParallel,
+             (double)ulComparisons / (double)uLength);
+   }
+
+   lookUp(oDynArray, ppcCopy, ppcKeys, pcStorage, uLength, argv[0]);
+
+   DynArray_free(oDynArray);
+   free(ppcCopy);
+   free(ppcKeys);
+   free(pcStorage);
+   return 0;
+}
@@ -0,0 +1,958 @@
+/*--------------------------------------------------------------------*/
+/* dynarrayt.h                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef DYNARRAYT_INCLUDED
+#define DYNARRAYT_INCLUDED
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Hint that the memory at pv will soon be read. */
+
+#ifdef __GNUC__
+#define DYNARRAY_PREFETCH(pv) __builtin_prefetch(pv)
+#else
+#define DYNARRAY_PREFETCH(pv) ((void)0)
+#endif
+
+/* DYNARRAY_DEFINE(Name, Type, uInlineLength) defines a type Name, a
+   dynamic array that stores elements of type Type by value, together
+   with functions Name_init, Name_destroy, Name_reserve, Name_clear,
+   Name_addAll, Name_shrinkToFit, Name_getLength, Name_get, Name_at,
+   Name_set, Name_add, Name_addAt and Name_removeAt that work like
+   their DynArray counterparts.  The first uInlineLength elements
+   (at least 1) are stored within the Name object itself, so a Name
+   object must not be copied.  Adding or removing elements at either
+   end takes amortized O(1) time, and elsewhere moves the elements on
+   the shorter side of the index.
+
+   DYNARRAY_DEFINE_SORT(Name, Type, Context, COMPARE) then defines
+   Name_sort, Name_search and Name_bsearch, along with Name_sortRange,
+   Name_merge, Name_lowerBound and Name_lowerBoundBatch for plain
+   arrays, which order and find elements with COMPARE(pxElement1,
+   pxElement2, xContext).  COMPARE receives pointers to two elements
+   and a value of type Context, and must evaluate to <0, 0, or >0 like
+   a qsort comparison function.  Name_bsearch, Name_lowerBound and
+   Name_lowerBoundBatch always pass the sought element first and an
+   element of the array second, as bsearch does.  Because COMPARE is a
+   macro or an inline function rather than a function pointer, the
+   compiler can inline it into the loops. */
+
+#define DYNARRAY_DEFINE(Name, Type, uInlineLength)                     \
+                                                                       \
+typedef struct Name                                                    \
+{                                                                      \
+   /* The number of elements from the client's point of view. */       \
+   size_t uLength;                                                     \
+                                                                       \
+   /* The number of elements that pxBase can hold. */                  \
+   size_t uPhysLength;                                                 \
+                                                                       \
+   /* Either axInline or an array allocated with malloc. */            \
+   Type *pxBase;                                                       \
+                                                                       \
+   /* The first element, which follows a gap at the start of pxBase    \
+      that makes adding and removing at the front O(1). */             \
+   Type *pxArray;                                                      \
+                                                                       \
+   /* The array that underlies a short Name. */                        \
+   Type axInline[uInlineLength];                                       \
+} Name;                                                                \
+                                                                       \
+static inline void Name##_init(Name *ps)                               \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   ps->uLength = 0;                                                    \
+   ps->uPhysLength = (uInlineLength);                                  \
+   ps->pxBase = ps->axInline;                                          \
+   ps->pxArray = ps->axInline;                                         \
+}                                                                      \
+                                                                       \
+static inline void Name##_destroy(Name *ps)                            \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   if (ps->pxBase != ps->axInline)                                     \
+      free(ps->pxBase);                                                \
+}                                                                      \
+                                                                       \
+static inline int Name##_isValid(const Name *ps)                       \
+{                                                                      \
+   if (ps->uPhysLength < (uInlineLength)) return 0;                    \
+   if (ps->pxBase == NULL) return 0;                                   \
+   if (ps->pxArray < ps->pxBase) return 0;                             \
+   if (ps->uLength > ps->uPhysLength -                                 \
+       (size_t)(ps->pxArray - ps->pxBase)) return 0;                   \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Return the number of unused elements before the first element. */   \
+                                                                       \
+static inline size_t Name##_getFrontRoom(const Name *ps)               \
+{                                                                      \
+   return (size_t)(ps->pxArray - ps->pxBase);                          \
+}                                                                      \
+                                                                       \
+/* Return the number of unused elements after the last element. */     \
+                                                                       \
+static inline size_t Name##_getBackRoom(const Name *ps)                \
+{                                                                      \
+   return ps->uPhysLength - Name##_getFrontRoom(ps) - ps->uLength;     \
+}                                                                      \
+                                                                       \
+/* Move the elements of ps into an array of uNewLength elements,       \
+   leaving uFrontRoom unused elements before them.  The array is       \
+   pxBase itself if it is long enough.  Return 1 (TRUE) if successful, \
+   or 0 (FALSE) if insufficient memory is available. */                \
+                                                                       \
+static int Name##_relocate(Name *ps, size_t uNewLength,                \
+                           size_t uFrontRoom)                          \
+{                                                                      \
+   Type *pxNewBase;                                                    \
+                                                                       \
+   if (uNewLength <= ps->uPhysLength)                                  \
+      pxNewBase = ps->pxBase;                                          \
+   else if (ps->pxBase != ps->axInline &&                              \
+            uFrontRoom == Name##_getFrontRoom(ps))                     \
+   {                                                                   \
+      /* The elements stay where they are relative to the base. */     \
+      pxNewBase =                                                      \
+         (Type*)realloc(ps->pxBase, sizeof(Type) * uNewLength);        \
+      if (pxNewBase == NULL)                                           \
+         return 0;                                                     \
+      ps->pxArray = pxNewBase + uFrontRoom;                            \
+      ps->pxBase = pxNewBase;                                          \
+      ps->uPhysLength = uNewLength;                                    \
+      return 1;                                                        \
+   }                                                                   \
+   else                                                                \
+   {                                                                   \
+      pxNewBase = (Type*)malloc(sizeof(Type) * uNewLength);            \
+      if (pxNewBase == NULL)                                           \
+         return 0;                                                     \
+   }                                                                   \
+   memmove(pxNewBase + uFrontRoom, ps->pxArray,                        \
+           sizeof(Type) * ps->uLength);                                \
+   if (pxNewBase != ps->pxBase)                                        \
+   {                                                                   \
+      Name##_destroy(ps);                                              \
+      ps->pxBase = pxNewBase;                                          \
+      ps->uPhysLength = uNewLength;                                    \
+   }                                                                   \
+   ps->pxArray = pxNewBase + uFrontRoom;                               \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Make room for at least uMinLength elements after the first.  Return \
+   1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is      \
+   available. */                                                       \
+                                                                       \
+static inline int Name##_grow(Name *ps, size_t uMinLength)             \
+{                                                                      \
+   enum {GROWTH_FACTOR = 2};                                           \
+   size_t uFrontRoom = Name##_getFrontRoom(ps);                        \
+   size_t uNewLength = ps->uPhysLength;                                \
+                                                                       \
+   if (uMinLength <= ps->uPhysLength - uFrontRoom)                     \
+      return 1;                                                        \
+                                                                       \
+   /* Reclaim the front room if it is at least as large as the         \
+      elements, since that many removals paid for moving them. */      \
+   if (uFrontRoom >= ps->uLength && uMinLength <= ps->uPhysLength)     \
+      return Name##_relocate(ps, ps->uPhysLength, 0);                  \
+                                                                       \
+   while (uNewLength < uFrontRoom + uMinLength)                        \
+      uNewLength *= GROWTH_FACTOR;                                     \
+   return Name##_relocate(ps, uNewLength, uFrontRoom);                 \
+}                                                                      \
+                                                                       \
+/* Make room for at least one element before the first.  Return        \
+   1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is      \
+   available. */                                                       \
+                                                                       \
+static inline int Name##_growFront(Name *ps)                           \
+{                                                                      \
+   enum {GROWTH_FACTOR = 2};                                           \
+   size_t uNewLength = ps->uPhysLength;                                \
+                                                                       \
+   if (ps->pxArray != ps->pxBase)                                      \
+      return 1;                                                        \
+                                                                       \
+   /* Center the elements, in a larger array unless at least half of   \
+      this one is unused. */                                           \
+   if (ps->uLength >= ps->uPhysLength / 2)                             \
+      uNewLength *= GROWTH_FACTOR;                                     \
+   return Name##_relocate(ps, uNewLength,                              \
+                          (uNewLength - ps->uLength + 1) / 2);         \
+}                                                                      \
+                                                                       \
+/* Note that the element at uIndex is gone, and close the gap by       \
+   moving the shorter side of the elements. */                         \
+                                                                       \
+static inline void Name##_closeGap(Name *ps, size_t uIndex)            \
+{                                                                      \
+   if (uIndex < ps->uLength / 2)                                       \
+   {                                                                   \
+      memmove(&ps->pxArray[1], &ps->pxArray[0], sizeof(Type) * uIndex);\
+      ps->pxArray++;                                                   \
+   }                                                                   \
+   else                                                                \
+      memmove(&ps->pxArray[uIndex], &ps->pxArray[uIndex + 1],          \
+              sizeof(Type) * (ps->uLength - uIndex - 1));              \
+   ps->uLength--;                                                      \
+                                                                       \
+   /* Let an emptied array start over at the front. */                 \
+   if (ps->uLength == 0)                                               \
+      ps->pxArray = ps->pxBase;                                        \
+}                                                                      \
+                                                                       \
+/* Make room for uLength elements, so that adding up to that many      \
+   allocates no memory.  Return 1 (TRUE) if successful, or 0 (FALSE)   \
+   if insufficient memory is available. */                             \
+                                                                       \
+static inline int Name##_reserve(Name *ps, size_t uLength)             \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   return Name##_grow(ps, uLength);                                    \
+}                                                                      \
+                                                                       \
+/* Remove all elements, keeping the memory that holds them. */         \
+                                                                       \
+static inline void Name##_clear(Name *ps)                              \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   ps->uLength = 0;                                                    \
+   ps->pxArray = ps->pxBase;                                           \
+}                                                                      \
+                                                                       \
+/* Add the uCount elements at px to the end.  Return 1 (TRUE) if       \
+   successful, or 0 (FALSE) if insufficient memory is available. */    \
+                                                                       \
+static inline int Name##_addAll(Name *ps, const Type *px,              \
+                                size_t uCount)                         \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   assert(px != NULL || uCount == 0);                                  \
+   if (Name##_getBackRoom(ps) < uCount)                                \
+      if (! Name##_grow(ps, ps->uLength + uCount))                     \
+         return 0;                                                     \
+   memcpy(&ps->pxArray[ps->uLength], px, sizeof(Type) * uCount);       \
+   ps->uLength += uCount;                                              \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Free whatever memory the elements do not need, moving them inline   \
+   if they fit. */                                                     \
+                                                                       \
+static inline void Name##_shrinkToFit(Name *ps)                        \
+{                                                                      \
+   Type *pxNewBase;                                                    \
+                                                                       \
+   assert(ps != NULL);                                                 \
+   if (ps->pxBase == ps->axInline)                                     \
+      return;                                                          \
+   if (ps->uLength <= (uInlineLength))                                 \
+   {                                                                   \
+      memcpy(ps->axInline, ps->pxArray, sizeof(Type) * ps->uLength);   \
+      free(ps->pxBase);                                                \
+      ps->pxBase = ps->axInline;                                       \
+      ps->pxArray = ps->axInline;                                      \
+      ps->uPhysLength = (uInlineLength);                               \
+      return;                                                          \
+   }                                                                   \
+   memmove(ps->pxBase, ps->pxArray, sizeof(Type) * ps->uLength);       \
+   ps->pxArray = ps->pxBase;                                           \
+   pxNewBase = (Type*)realloc(ps->pxBase, sizeof(Type) * ps->uLength); \
+   if (pxNewBase == NULL)                                              \
+      return; /* The old memory is still good. */                      \
+   ps->pxBase = pxNewBase;                                             \
+   ps->pxArray = pxNewBase;                                            \
+   ps->uPhysLength = ps->uLength;                                      \
+}                                                                      \
+                                                                       \
+static inline size_t Name##_getLength(const Name *ps)                  \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   return ps->uLength;                                                 \
+}                                                                      \
+                                                                       \
+static inline Type Name##_get(const Name *ps, size_t uIndex)           \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   assert(uIndex < ps->uLength);                                       \
+   return ps->pxArray[uIndex];                                         \
+}                                                                      \
+                                                                       \
+static inline Type *Name##_at(Name *ps, size_t uIndex)                 \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   assert(uIndex < ps->uLength);                                       \
+   return &ps->pxArray[uIndex];                                        \
+}                                                                      \
+                                                                       \
+static inline Type Name##_set(Name *ps, size_t uIndex, Type xElement)  \
+{                                                                      \
+   Type xOldElement;                                                   \
+                                                                       \
+   assert(ps != NULL);                                                 \
+   assert(uIndex < ps->uLength);                                       \
+   xOldElement = ps->pxArray[uIndex];                                  \
+   ps->pxArray[uIndex] = xElement;                                     \
+   return xOldElement;                                                 \
+}                                                                      \
+                                                                       \
+static inline int Name##_add(Name *ps, Type xElement)                  \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   if (Name##_getBackRoom(ps) == 0)                                    \
+      if (! Name##_grow(ps, ps->uLength + 1))                          \
+         return 0;                                                     \
+   ps->pxArray[ps->uLength++] = xElement;                              \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Elements before uIndex move toward the front when there is room     \
+   there and they are the shorter side, so adding at either end is     \
+   amortized O(1). */                                                  \
+                                                                       \
+static inline int Name##_addAt(Name *ps, size_t uIndex, Type xElement) \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   assert(uIndex <= ps->uLength);                                      \
+   if (uIndex < ps->uLength / 2 ||                                     \
+       (uIndex == 0 && ps->uLength > 0))                               \
+   {                                                                   \
+      if (! Name##_growFront(ps))                                      \
+         return 0;                                                     \
+      ps->pxArray--;                                                   \
+      memmove(&ps->pxArray[0], &ps->pxArray[1], sizeof(Type) * uIndex);\
+   }                                                                   \
+   else                                                                \
+   {                                                                   \
+      if (Name##_getBackRoom(ps) == 0)                                 \
+         if (! Name##_grow(ps, ps->uLength + 1))                       \
+            return 0;                                                  \
+      memmove(&ps->pxArray[uIndex + 1], &ps->pxArray[uIndex],          \
+              sizeof(Type) * (ps->uLength - uIndex));                  \
+   }                                                                   \
+   ps->pxArray[uIndex] = xElement;                                     \
+   ps->uLength++;                                                      \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+static inline Type Name##_removeAt(Name *ps, size_t uIndex)            \
+{                                                                      \
+   Type xOldElement;                                                   \
+                                                                       \
+   assert(ps != NULL);                                                 \
+   assert(uIndex < ps->uLength);                                       \
+   xOldElement = ps->pxArray[uIndex];                                  \
+   Name##_closeGap(ps, uIndex);                                        \
+   return xOldElement;                                                 \
+}
+
+/*--------------------------------------------------------------------*/
+
+#define DYNARRAY_DEFINE_SORT(Name, Type, Context, COMPARE)             \
+                                                                       \
+/* Sort the uLength elements at px by insertion, which is fastest for  \
+   short ranges. */                                                    \
+                                                                       \
+static void Name##_insertionSort(Type *px, size_t uLength,             \
+                                 Context xContext)                     \
+{                                                                      \
+   size_t u, v;                                                        \
+   Type xTemp;                                                         \
+                                                                       \
+   for (u = 1; u < uLength; u++)                                       \
+   {                                                                   \
+      xTemp = px[u];                                                   \
+      for (v = u; v > 0 && COMPARE(&xTemp, &px[v - 1], xContext) < 0;  \
+           v--)                                                        \
+         px[v] = px[v - 1];                                            \
+      px[v] = xTemp;                                                   \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Like Name_insertionSort, but give up and return 0 (FALSE) as soon   \
+   as more than a few elements have moved.  Return 1 (TRUE) iff the    \
+   elements are sorted. */                                             \
+                                                                       \
+static int Name##_partialInsertionSort(Type *px, size_t uLength,       \
+                                       Context xContext)               \
+{                                                                      \
+   enum {MAX_MOVES = 8};                                               \
+   size_t uMoves = 0;                                                  \
+   size_t u, v;                                                        \
+   Type xTemp;                                                         \
+                                                                       \
+   for (u = 1; u < uLength; u++)                                       \
+   {                                                                   \
+      if (COMPARE(&px[u], &px[u - 1], xContext) >= 0)                  \
+         continue;                                                     \
+      xTemp = px[u];                                                   \
+      for (v = u; v > 0 && COMPARE(&xTemp, &px[v - 1], xContext) < 0;  \
+           v--)                                                        \
+         px[v] = px[v - 1];                                            \
+      px[v] = xTemp;                                                   \
+      uMoves += u - v;                                                 \
+      if (uMoves > MAX_MOVES)                                          \
+         return 0;                                                     \
+   }                                                                   \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Restore the heap order of the uLength elements at px below          \
+   px[uRoot]. */                                                       \
+                                                                       \
+static void Name##_siftDown(Type *px, size_t uRoot, size_t uLength,    \
+                            Context xContext)                          \
+{                                                                      \
+   size_t uChild;                                                      \
+   Type xTemp = px[uRoot];                                             \
+                                                                       \
+   while ((uChild = 2 * uRoot + 1) < uLength)                          \
+   {                                                                   \
+      if (uChild + 1 < uLength &&                                      \
+          COMPARE(&px[uChild], &px[uChild + 1], xContext) < 0)         \
+         uChild++;                                                     \
+      if (COMPARE(&xTemp, &px[uChild], xContext) >= 0)                 \
+         break;                                                        \
+      px[uRoot] = px[uChild];                                          \
+      uRoot = uChild;                                                  \
+   }                                                                   \
+   px[uRoot] = xTemp;                                                  \
+}                                                                      \
+                                                                       \
+/* Sort the uLength elements at px by heapsort, which is never worse   \
+   than O(n log n). */                                                 \
+                                                                       \
+static void Name##_heapSort(Type *px, size_t uLength, Context xContext)\
+{                                                                      \
+   size_t u;                                                           \
+   Type xTemp;                                                         \
+                                                                       \
+   for (u = uLength / 2; u > 0; u--)                                   \
+      Name##_siftDown(px, u - 1, uLength, xContext);                   \
+   for (u = uLength; u > 1; u--)                                       \
+   {                                                                   \
+      xTemp = px[0];                                                   \
+      px[0] = px[u - 1];                                               \
+      px[u - 1] = xTemp;                                               \
+      Name##_siftDown(px, 0, u - 1, xContext);                         \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Swap *pxA and *pxB. */                                              \
+                                                                       \
+static inline void Name##_swap(Type *pxA, Type *pxB)                   \
+{                                                                      \
+   Type xTemp = *pxA;                                                  \
+   *pxA = *pxB;                                                        \
+   *pxB = xTemp;                                                       \
+}                                                                      \
+                                                                       \
+/* Order *pxA, *pxB and *pxC so that *pxB is their median. */          \
+                                                                       \
+static inline void Name##_sort3(Type *pxA, Type *pxB, Type *pxC,       \
+                                Context xContext)                      \
+{                                                                      \
+   if (COMPARE(pxB, pxA, xContext) < 0) Name##_swap(pxA, pxB);         \
+   if (COMPARE(pxC, pxB, xContext) < 0) Name##_swap(pxB, pxC);         \
+   if (COMPARE(pxB, pxA, xContext) < 0) Name##_swap(pxA, pxB);         \
+}                                                                      \
+                                                                       \
+/* Swap the elements at the ends of the uLength elements at px, which  \
+   are where the next pivot comes from, with elements a quarter of the \
+   way in, breaking up patterns that produce bad pivots. */            \
+                                                                       \
+static void Name##_scatter(Type *px, size_t uLength)                   \
+{                                                                      \
+   size_t uQuarter = uLength / 4;                                      \
+   size_t u;                                                           \
+                                                                       \
+   for (u = 0; u < 3; u++)                                             \
+   {                                                                   \
+      Name##_swap(&px[u], &px[uQuarter + u]);                          \
+      Name##_swap(&px[uLength - 1 - u], &px[uLength - uQuarter - u]);  \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Sort the uLength elements at px with a pattern-defeating            \
+   introsort: quicksort with a median-of-3 (or, for long ranges,       \
+   median-of-9) pivot that switches to insertion sort for short        \
+   ranges, finishes early when a partition shows that a range is       \
+   already sorted, breaks up patterns that produce unbalanced          \
+   partitions, and falls back to heapsort when they persist.           \
+   iBadAllowed is the number of unbalanced partitions to tolerate. */  \
+                                                                       \
+static void Name##_introSort(Type *px, size_t uLength, int iBadAllowed,\
+                             Context xContext)                         \
+{                                                                      \
+   enum {INSERTION_SORT_MAX = 24, NINTHER_MIN = 128};                  \
+   size_t uMid, uLeft, uRight, uLow, uHigh;                            \
+   int iSwapped;                                                       \
+   Type xPivot;                                                        \
+                                                                       \
+   while (uLength > INSERTION_SORT_MAX)                                \
+   {                                                                   \
+      /* Move the pivot to px[0]. */                                   \
+      uMid = uLength / 2;                                              \
+      Name##_sort3(&px[0], &px[uMid], &px[uLength - 1], xContext);     \
+      if (uLength >= NINTHER_MIN)                                      \
+      {                                                                \
+         Name##_sort3(&px[1], &px[uMid - 1], &px[uLength - 2],         \
+                      xContext);                                       \
+         Name##_sort3(&px[2], &px[uMid + 1], &px[uLength - 3],         \
+                      xContext);                                       \
+         Name##_sort3(&px[uMid - 1], &px[uMid], &px[uMid + 1],         \
+                      xContext);                                       \
+      }                                                                \
+      Name##_swap(&px[0], &px[uMid]);                                  \
+      xPivot = px[0];                                                  \
+                                                                       \
+      /* Partition px[1...uLength-1] around xPivot.  Elements equal to \
+         xPivot stop both scans, which balances runs of duplicates. */ \
+      uLeft = 1;                                                       \
+      uRight = uLength - 1;                                            \
+      iSwapped = 0;                                                    \
+      for (;;)                                                         \
+      {                                                                \
+         while (uLeft <= uRight &&                                     \
+                COMPARE(&px[uLeft], &xPivot, xContext) < 0)            \
+            uLeft++;                                                   \
+         while (uLeft <= uRight &&                                     \
+                COMPARE(&xPivot, &px[uRight], xContext) < 0)           \
+            uRight--;                                                  \
+         if (uLeft >= uRight)                                          \
+            break;                                                     \
+         Name##_swap(&px[uLeft], &px[uRight]);                         \
+         iSwapped = 1;                                                 \
+         uLeft++;                                                      \
+         uRight--;                                                     \
+      }                                                                \
+      Name##_swap(&px[0], &px[uRight]);                                \
+                                                                       \
+      /* Now px[0...uRight-1] <= xPivot <= px[uRight+1...]. */         \
+      uLow = uRight;                                                   \
+      uHigh = uLength - uRight - 1;                                    \
+                                                                       \
+      if (uLow < uLength / 8 || uHigh < uLength / 8)                   \
+      {                                                                \
+         /* Unbalanced: give up on quicksort if it keeps happening,    \
+            and otherwise shuffle a few elements to break patterns. */ \
+         if (--iBadAllowed == 0)                                       \
+         {                                                             \
+            Name##_heapSort(px, uLength, xContext);                    \
+            return;                                                    \
+         }                                                             \
+         if (uLow >= INSERTION_SORT_MAX)                               \
+            Name##_scatter(px, uLow);                                  \
+         if (uHigh >= INSERTION_SORT_MAX)                              \
+            Name##_scatter(&px[uRight + 1], uHigh);                    \
+      }                                                                \
+      else if (! iSwapped &&                                           \
+               Name##_partialInsertionSort(px, uLow, xContext) &&      \
+               Name##_partialInsertionSort(&px[uRight + 1], uHigh,     \
+                                           xContext))                  \
+         /* The range was already (nearly) sorted. */                  \
+         return;                                                       \
+                                                                       \
+      /* Recurse into the shorter side and loop over the longer, which \
+         bounds the depth of the recursion by log2(uLength). */        \
+      if (uLow < uHigh)                                                \
+      {                                                                \
+         Name##_introSort(px, uLow, iBadAllowed, xContext);            \
+         px += uRight + 1;                                             \
+         uLength = uHigh;                                              \
+      }                                                                \
+      else                                                             \
+      {                                                                \
+         Name##_introSort(&px[uRight + 1], uHigh, iBadAllowed,         \
+                          xContext);                                   \
+         uLength = uLow;                                               \
+      }                                                                \
+   }                                                                   \
+   Name##_insertionSort(px, uLength, xContext);                        \
+}                                                                      \
+                                                                       \
+/* Sort the uLength elements at px in O(n log n) time without          \
+   allocating memory. */                                               \
+                                                                       \
+static void Name##_sortInPlace(Type *px, size_t uLength,               \
+                               Context xContext)                       \
+{                                                                      \
+   int iLog = 1;                                                       \
+   size_t u;                                                           \
+                                                                       \
+   for (u = uLength; u > 1; u /= 2)                                    \
+      iLog++;                                                          \
+   Name##_introSort(px, uLength, iLog, xContext);                      \
+}                                                                      \
+                                                                       \
+/* Reverse the order of the uLength elements at px. */                 \
+                                                                       \
+static void Name##_reverse(Type *px, size_t uLength)                   \
+{                                                                      \
+   size_t u;                                                           \
+                                                                       \
+   for (u = 0; u < uLength / 2; u++)                                   \
+      Name##_swap(&px[u], &px[uLength - 1 - u]);                       \
+}                                                                      \
+                                                                       \
+/* Return the length of the run that starts the uLength elements at    \
+   px: the longest prefix that is in order, or in strictly reverse     \
+   order, which is then reversed into order. */                        \
+                                                                       \
+static size_t Name##_findRun(Type *px, size_t uLength,                 \
+                             Context xContext)                         \
+{                                                                      \
+   size_t u;                                                           \
+                                                                       \
+   if (uLength < 2)                                                    \
+      return uLength;                                                  \
+   if (COMPARE(&px[1], &px[0], xContext) < 0)                          \
+   {                                                                   \
+      for (u = 2; u < uLength &&                                       \
+              COMPARE(&px[u], &px[u - 1], xContext) < 0; u++)          \
+         ;                                                             \
+      Name##_reverse(px, u);                                           \
+   }                                                                   \
+   else                                                                \
+      for (u = 2; u < uLength &&                                       \
+              COMPARE(&px[u], &px[u - 1], xContext) >= 0; u++)         \
+         ;                                                             \
+   return u;                                                           \
+}                                                                      \
+                                                                       \
+/* Sort the uLength elements at px, of which the first uSorted are     \
+   already sorted, by inserting each of the others where a binary      \
+   search places it. */                                                \
+                                                                       \
+static void Name##_binaryInsertionSort(Type *px, size_t uSorted,       \
+                                       size_t uLength,                 \
+                                       Context xContext)               \
+{                                                                      \
+   size_t uLow, uHigh, uMid;                                           \
+   Type xTemp;                                                         \
+                                                                       \
+   for (; uSorted < uLength; uSorted++)                                \
+   {                                                                   \
+      xTemp = px[uSorted];                                             \
+      uLow = 0;                                                        \
+      uHigh = uSorted;                                                 \
+      while (uLow < uHigh)                                             \
+      {                                                                \
+         uMid = uLow + (uHigh - uLow) / 2;                             \
+         if (COMPARE(&xTemp, &px[uMid], xContext) < 0)                 \
+            uHigh = uMid;                                              \
+         else                                                          \
+            uLow = uMid + 1;                                           \
+      }                                                                \
+      memmove(&px[uLow + 1], &px[uLow],                                \
+              sizeof(Type) * (uSorted - uLow));                        \
+      px[uLow] = xTemp;                                                \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Merge the sorted uMid elements at px with the sorted elements that  \
+   follow them up to px[uLength-1], in place.  The elements of each    \
+   run that are already where they belong stay put, and the shorter    \
+   of what remains of the two runs is copied to pxTemp, which must     \
+   hold at least half of uLength elements. */                          \
+                                                                       \
+static void Name##_mergeAdjacent(Type *px, size_t uMid, size_t uLength,\
+                                 Type *pxTemp, Context xContext)       \
+{                                                                      \
+   size_t uLow, uHigh, uProbe;                                         \
+   Type *pxA;                                                          \
+   Type *pxB;                                                          \
+   Type *pxOut;                                                        \
+   Type *pxEnd;                                                        \
+                                                                       \
+   /* Skip the elements of the first run that are not greater than the \
+      first of the second, and those of the second that are not less   \
+      than the last of the first. */                                   \
+   uLow = 0;                                                           \
+   uHigh = uMid;                                                       \
+   while (uLow < uHigh)                                                \
+   {                                                                   \
+      uProbe = uLow + (uHigh - uLow) / 2;                              \
+      if (COMPARE(&px[uMid], &px[uProbe], xContext) < 0)               \
+         uHigh = uProbe;                                               \
+      else                                                             \
+         uLow = uProbe + 1;                                            \
+   }                                                                   \
+   px += uLow;                                                         \
+   uMid -= uLow;                                                       \
+   uLength -= uLow;                                                    \
+   if (uMid == 0)                                                      \
+      return;                                                          \
+   uLow = uMid;                                                        \
+   uHigh = uLength;                                                    \
+   while (uLow < uHigh)                                                \
+   {                                                                   \
+      uProbe = uLow + (uHigh - uLow) / 2;                              \
+      if (COMPARE(&px[uProbe], &px[uMid - 1], xContext) < 0)           \
+         uLow = uProbe + 1;                                            \
+      else                                                             \
+         uHigh = uProbe;                                               \
+   }                                                                   \
+   uLength = uLow;                                                     \
+                                                                       \
+   if (uMid <= uLength - uMid)                                         \
+   {                                                                   \
+      /* Merge forward from the copy of the first run. */              \
+      memcpy(pxTemp, px, sizeof(Type) * uMid);                         \
+      pxA = pxTemp;                                                    \
+      pxEnd = pxTemp + uMid;                                           \
+      pxB = px + uMid;                                                 \
+      pxOut = px;                                                      \
+      while (pxA < pxEnd && pxB < px + uLength)                        \
+      {                                                                \
+         if (COMPARE(pxB, pxA, xContext) < 0)                          \
+            *pxOut++ = *pxB++;                                         \
+         else                                                          \
+            *pxOut++ = *pxA++;                                         \
+      }                                                                \
+      memcpy(pxOut, pxA, sizeof(Type) * (size_t)(pxEnd - pxA));        \
+   }                                                                   \
+   else                                                                \
+   {                                                                   \
+      /* Merge backward from the copy of the second run. */            \
+      memcpy(pxTemp, px + uMid, sizeof(Type) * (uLength - uMid));      \
+      pxA = px + uMid;                                                 \
+      pxB = pxTemp + (uLength - uMid);                                 \
+      pxOut = px + uLength;                                            \
+      while (pxA > px && pxB > pxTemp)                                 \
+      {                                                                \
+         if (COMPARE(pxB - 1, pxA - 1, xContext) < 0)                  \
+            *--pxOut = *--pxA;                                         \
+         else                                                          \
+            *--pxOut = *--pxB;                                         \
+      }                                                                \
+      memcpy(px, pxTemp, sizeof(Type) * (size_t)(pxB - pxTemp));       \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Sort the uLength elements at px in O(n log n) time with a natural   \
+   merge sort, which takes advantage of runs that are already in       \
+   order or in reverse order.  Runs shorter than MIN_RUN are extended  \
+   by insertion, and runs are merged as they are found, keeping each   \
+   pending run longer than the two after it together so that merges    \
+   stay balanced.  If memory for merging cannot be allocated, sort the \
+   elements in place instead. */                                       \
+                                                                       \
+static void Name##_sortRange(Type *px, size_t uLength,                 \
+                             Context xContext)                         \
+{                                                                      \
+   enum {MIN_RUN = 32, MAX_PENDING = 96};                              \
+   size_t auStart[MAX_PENDING], auLength[MAX_PENDING];                 \
+   size_t uPending = 0;                                                \
+   size_t uStart = 0;                                                  \
+   size_t uRun, uMin, uAt;                                             \
+   Type *pxTemp;                                                       \
+                                                                       \
+   if (uLength <= MIN_RUN)                                             \
+   {                                                                   \
+      Name##_binaryInsertionSort(px, Name##_findRun(px, uLength,       \
+                                                   xContext),          \
+                                 uLength, xContext);                   \
+      return;                                                          \
+   }                                                                   \
+   pxTemp = (Type*)malloc(sizeof(Type) * (uLength / 2 + 1));           \
+   if (pxTemp == NULL)                                                 \
+   {                                                                   \
+      Name##_sortInPlace(px, uLength, xContext);                       \
+      return;                                                          \
+   }                                                                   \
+                                                                       \
+   while (uStart < uLength)                                            \
+   {                                                                   \
+      uRun = Name##_findRun(&px[uStart], uLength - uStart, xContext);  \
+      if (uRun < MIN_RUN)                                              \
+      {                                                                \
+         uMin = (uLength - uStart < MIN_RUN) ?                         \
+            uLength - uStart : MIN_RUN;                                \
+         Name##_binaryInsertionSort(&px[uStart], uRun, uMin,           \
+                                    xContext);                         \
+         uRun = uMin;                                                  \
+      }                                                                \
+      auStart[uPending] = uStart;                                      \
+      auLength[uPending] = uRun;                                       \
+      uPending++;                                                      \
+      uStart += uRun;                                                  \
+                                                                       \
+      /* Merge pending runs until each is longer than the next, and    \
+         than the two after it together, or merge them all once the    \
+         last run is found. */                                         \
+      while (uPending > 1)                                             \
+      {                                                                \
+         /* Merge run uAt with run uAt+1. */                           \
+         uAt = uPending - 2;                                           \
+         if ((uAt > 0 && auLength[uAt - 1] <=                          \
+              auLength[uAt] + auLength[uAt + 1]) ||                    \
+             (uAt > 1 && auLength[uAt - 2] <=                          \
+              auLength[uAt - 1] + auLength[uAt]))                      \
+         {                                                             \
+            if (auLength[uAt - 1] < auLength[uAt + 1])                 \
+               uAt--;                                                  \
+         }                                                             \
+         else if (uStart < uLength &&                                  \
+                  auLength[uAt] > auLength[uAt + 1])                   \
+            break;                                                     \
+         Name##_mergeAdjacent(&px[auStart[uAt]], auLength[uAt],        \
+                              auLength[uAt] + auLength[uAt + 1],       \
+                              pxTemp, xContext);                       \
+         auLength[uAt] += auLength[uAt + 1];                           \
+         memmove(&auStart[uAt + 1], &auStart[uAt + 2],                 \
+                 sizeof(size_t) * (uPending - uAt - 2));               \
+         memmove(&auLength[uAt + 1], &auLength[uAt + 2],               \
+                 sizeof(size_t) * (uPending - uAt - 2));               \
+         uPending--;                                                   \
+      }                                                                \
+   }                                                                   \
+   free(pxTemp);                                                       \
+}                                                                      \
+                                                                       \
+/* Merge the sorted uLengthA elements at pxA and the sorted uLengthB   \
+   elements at pxB into pxOut, which must not overlap them. */         \
+                                                                       \
+static inline void Name##_merge(const Type *pxA, size_t uLengthA,      \
+                                const Type *pxB, size_t uLengthB,      \
+                                Type *pxOut, Context xContext)         \
+{                                                                      \
+   const Type *pxEndA = pxA + uLengthA;                                \
+   const Type *pxEndB = pxB + uLengthB;                                \
+                                                                       \
+   while (pxA < pxEndA && pxB < pxEndB)                                \
+   {                                                                   \
+      if (COMPARE(pxB, pxA, xContext) < 0)                             \
+         *pxOut++ = *pxB++;                                            \
+      else                                                             \
+         *pxOut++ = *pxA++;                                            \
+   }                                                                   \
+   memcpy(pxOut, pxA, sizeof(Type) * (size_t)(pxEndA - pxA));          \
+   pxOut += pxEndA - pxA;                                              \
+   memcpy(pxOut, pxB, sizeof(Type) * (size_t)(pxEndB - pxB));          \
+}                                                                      \
+                                                                       \
+static inline void Name##_sort(Name *ps, Context xContext)             \
+{                                                                      \
+   assert(ps != NULL);                                                 \
+   Name##_sortRange(ps->pxArray, ps->uLength, xContext);               \
+}                                                                      \
+                                                                       \
+static inline int Name##_search(const Name *ps, const Type *pxSought,  \
+                                size_t *puIndex, Context xContext)     \
+{                                                                      \
+   size_t u;                                                           \
+                                                                       \
+   assert(ps != NULL);                                                 \
+   assert(puIndex != NULL);                                            \
+   for (u = 0; u < ps->uLength; u++)                                   \
+      if (COMPARE(&ps->pxArray[u], pxSought, xContext) == 0)           \
+      {                                                                \
+         *puIndex = u;                                                 \
+         return 1;                                                     \
+      }                                                                \
+   return 0;                                                           \
+}                                                                      \
+                                                                       \
+/* Return the index of the first of the uLength sorted elements at px  \
+   that is not less than *pxSought, or uLength if there is none. */    \
+                                                                       \
+static inline size_t Name##_lowerBound(const Type *px, size_t uLength,\
+                                       const Type *pxSought,           \
+                                       Context xContext)               \
+{                                                                      \
+   size_t uLow = 0;                                                    \
+   size_t uMid;                                                        \
+                                                                       \
+   while (uLow < uLength)                                              \
+   {                                                                   \
+      uMid = uLow + (uLength - uLow) / 2;                              \
+      if (COMPARE(pxSought, &px[uMid], xContext) > 0)                  \
+         uLow = uMid + 1;                                              \
+      else                                                             \
+         uLength = uMid;                                               \
+   }                                                                   \
+   return uLow;                                                        \
+}                                                                      \
+                                                                       \
+/* For each of the uCount elements at pxSought, assign to the          \
+   corresponding element of puIndices what Name_lowerBound would       \
+   return.  Groups of searches advance in lockstep, so that the memory \
+   accesses of one overlap with those of the others. */                \
+                                                                       \
+static inline void Name##_lowerBoundBatch(const Type *px,              \
+                                          size_t uLength,              \
+                                          const Type *pxSought,        \
+                                          size_t uCount,               \
+                                          size_t *puIndices,           \
+                                          Context xContext)            \
+{                                                                      \
+   enum {GROUP_SIZE = 8};                                              \
+   const Type *apxBase[GROUP_SIZE];                                    \
+   size_t uGroup, uLeft, uHalf, u, v;                                  \
+                                                                       \
+   for (u = 0; u < uCount; u += uGroup)                                \
+   {                                                                   \
+      uGroup = (uCount - u < GROUP_SIZE) ? uCount - u : GROUP_SIZE;    \
+      if (uLength == 0)                                                \
+      {                                                                \
+         for (v = 0; v < uGroup; v++)                                  \
+            puIndices[u + v] = 0;                                      \
+         continue;                                                     \
+      }                                                                \
+      for (v = 0; v < uGroup; v++)                                     \
+         apxBase[v] = px;                                              \
+      for (uLeft = uLength; uLeft > 1; uLeft -= uHalf)                 \
+      {                                                                \
+         uHalf = uLeft / 2;                                            \
+         for (v = 0; v < uGroup; v++)                                  \
+         {                                                             \
+            DYNARRAY_PREFETCH(&apxBase[v][uHalf / 2]);                 \
+            DYNARRAY_PREFETCH(&apxBase[v][uHalf + uHalf / 2]);         \
+            apxBase[v] = (COMPARE(&pxSought[u + v], &apxBase[v][uHalf],\
+                                  xContext) > 0) ?                     \
+               &apxBase[v][uHalf] : apxBase[v];                        \
+         }                                                             \
+      }                                                                \
+      for (v = 0; v < uGroup; v++)                                     \
+         puIndices[u + v] = (size_t)(apxBase[v] - px) +                \
+            (COMPARE(&pxSought[u + v], apxBase[v], xContext) > 0);     \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+static inline int Name##_bsearch(const Name *ps, const Type *pxSought, \
+                                 size_t *puIndex, Context xContext)    \
+{                                                                      \
+   size_t uLow = 0;                                                    \
+   size_t uHigh;                                                       \
+   size_t uMid;                                                        \
+   int iCompare;                                                       \
+                                                                       \
+   assert(ps != NULL);                                                 \
+   assert(puIndex != NULL);                                            \
+   uHigh = ps->uLength;                                                \
+   while (uLow < uHigh)                                                \
+   {                                                                   \
+      uMid = uLow + (uHigh - uLow) / 2;                                \
+      iCompare = COMPARE(pxSought, &ps->pxArray[uMid], xContext);      \
+      if (iCompare == 0)                                               \
+      {                                                                \
+         *puIndex = uMid;                                              \
+         return 1;                                                     \
+      }                                                                \
+      if (iCompare < 0)                                                \
+         uHigh = uMid;                                                 \
+      else                                                             \
+         uLow = uMid + 1;                                              \
+   }                                                                   \
+   return 0;                                                           \
+}
+
+#endif
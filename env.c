@@ -0,0 +1,375 @@
+/*--------------------------------------------------------------------*/
+/* env.c                                                              */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "env.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of buckets that a new Env has, and the most variables
+   per bucket before the number of buckets doubles. */
+
+enum {INITIAL_BUCKET_COUNT = 64, MAX_LOAD = 2};
+
+/*--------------------------------------------------------------------*/
+
+/* A Binding is one variable, stored as its "NAME=value" string. */
+
+struct Binding
+{
+   /* The "NAME=value" string, which the Binding owns. */
+   char *pcEntry;
+
+   /* The length of the name. */
+   size_t uNameLength;
+
+   /* The hash of the name. */
+   size_t uHash;
+
+   /* The next Binding in the same bucket. */
+   struct Binding *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An Env is a hash table of Bindings, chained within buckets, and a
+   cached environment array. */
+
+struct Env
+{
+   /* The buckets, a power of 2 in number. */
+   struct Binding **ppsBuckets;
+   size_t uBucketCount;
+
+   /* The number of Bindings. */
+   size_t uLength;
+
+   /* The environment array, or NULL if the Bindings have changed
+      since it was built. */
+   char **ppcEnvp;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash of the uLength characters of the name pcName. */
+
+static size_t Env_hash(const char *pcName, size_t uLength)
+{
+   /* The 64-bit FNV-1a hash. */
+   unsigned long long ullHash = 14695981039346656037ULL;
+   size_t u;
+
+   for (u = 0; u < uLength; u++)
+   {
+      ullHash ^= (unsigned char)pcName[u];
+      ullHash *= 1099511628211ULL;
+   }
+   return (size_t)ullHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the pointer to the Binding of oEnv for the
+   uLength characters of the name pcName, whose hash is uHash.  The
+   pointer is NULL if there is no such Binding. */
+
+static struct Binding **Env_find(Env_T oEnv, const char *pcName,
+                                 size_t uLength, size_t uHash)
+{
+   struct Binding **ppsBinding;
+
+   ppsBinding = &oEnv->ppsBuckets[uHash & (oEnv->uBucketCount - 1)];
+   while (*ppsBinding != NULL &&
+          ((*ppsBinding)->uHash != uHash ||
+           (*ppsBinding)->uNameLength != uLength ||
+           strncmp((*ppsBinding)->pcEntry, pcName, uLength) != 0))
+      ppsBinding = &(*ppsBinding)->psNext;
+   return ppsBinding;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the number of buckets of oEnv. */
+
+static void Env_grow(Env_T oEnv)
+{
+   struct Binding **ppsOld = oEnv->ppsBuckets;
+   size_t uOldCount = oEnv->uBucketCount;
+   struct Binding *psBinding;
+   struct Binding *psNext;
+   struct Binding **ppsBucket;
+   size_t u;
+
+   oEnv->uBucketCount *= 2;
+   oEnv->ppsBuckets = (struct Binding**)
+      calloc(oEnv->uBucketCount, sizeof(struct Binding*));
+   if (oEnv->ppsBuckets == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   for (u = 0; u < uOldCount; u++)
+      for (psBinding = ppsOld[u]; psBinding != NULL;
+           psBinding = psNext)
+      {
+         psNext = psBinding->psNext;
+         ppsBucket = &oEnv->ppsBuckets[psBinding->uHash &
+                                       (oEnv->uBucketCount - 1)];
+         psBinding->psNext = *ppsBucket;
+         *ppsBucket = psBinding;
+      }
+   free(ppsOld);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind, in oEnv, the name of the "NAME=value" string pcEntry, whose
+   name is uNameLength characters long, to its value. */
+
+static void Env_bind(Env_T oEnv, const char *pcEntry,
+                     size_t uNameLength)
+{
+   struct Binding **ppsBinding;
+   struct Binding *psBinding;
+   size_t uHash;
+   char *pcCopy;
+
+   pcCopy = (char*)malloc(strlen(pcEntry) + 1);
+   if (pcCopy == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   strcpy(pcCopy, pcEntry);
+
+   uHash = Env_hash(pcEntry, uNameLength);
+   ppsBinding = Env_find(oEnv, pcEntry, uNameLength, uHash);
+   if (*ppsBinding != NULL)
+   {
+      free((*ppsBinding)->pcEntry);
+      (*ppsBinding)->pcEntry = pcCopy;
+   }
+   else
+   {
+      psBinding = (struct Binding*)malloc(sizeof(struct Binding));
+      if (psBinding == NULL)
+         {perror(getPgmName()); exit(EXIT_FAILURE);}
+      psBinding->pcEntry = pcCopy;
+      psBinding->uNameLength = uNameLength;
+      psBinding->uHash = uHash;
+      psBinding->psNext = NULL;
+      *ppsBinding = psBinding;
+      oEnv->uLength++;
+      if (oEnv->uLength > MAX_LOAD * oEnv->uBucketCount)
+         Env_grow(oEnv);
+   }
+
+   free(oEnv->ppcEnvp);
+   oEnv->ppcEnvp = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+Env_T Env_new(char **ppcEnviron)
+{
+   Env_T oEnv;
+   const char *pcEquals;
+
+   assert(ppcEnviron != NULL);
+
+   oEnv = (struct Env*)malloc(sizeof(struct Env));
+   if (oEnv == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   oEnv->uBucketCount = INITIAL_BUCKET_COUNT;
+   oEnv->ppsBuckets = (struct Binding**)
+      calloc(oEnv->uBucketCount, sizeof(struct Binding*));
+   if (oEnv->ppsBuckets == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   oEnv->uLength = 0;
+   oEnv->ppcEnvp = NULL;
+
+   /* Skip strings without a name. */
+   for (; *ppcEnviron != NULL; ppcEnviron++)
+   {
+      pcEquals = strchr(*ppcEnviron, '=');
+      if (pcEquals != NULL && pcEquals != *ppcEnviron)
+         Env_bind(oEnv, *ppcEnviron,
+                  (size_t)(pcEquals - *ppcEnviron));
+   }
+   return oEnv;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Env_free(Env_T oEnv)
+{
+   struct Binding *psBinding;
+   struct Binding *psNext;
+   size_t u;
+
+   assert(oEnv != NULL);
+
+   for (u = 0; u < oEnv->uBucketCount; u++)
+      for (psBinding = oEnv->ppsBuckets[u]; psBinding != NULL;
+           psBinding = psNext)
+      {
+         psNext = psBinding->psNext;
+         free(psBinding->pcEntry);
+         free(psBinding);
+      }
+   free(oEnv->ppsBuckets);
+   free(oEnv->ppcEnvp);
+   free(oEnv);
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *Env_get(Env_T oEnv, const char *pcName)
+{
+   assert(oEnv != NULL);
+   assert(pcName != NULL);
+
+   return Env_lookUp(oEnv, pcName, strlen(pcName));
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *Env_lookUp(Env_T oEnv, const char *pcName,
+                       size_t uLength)
+{
+   struct Binding *psBinding;
+
+   assert(oEnv != NULL);
+   assert(pcName != NULL);
+
+   psBinding = *Env_find(oEnv, pcName, uLength,
+                         Env_hash(pcName, uLength));
+   if (psBinding == NULL)
+      return NULL;
+   return psBinding->pcEntry + uLength + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Env_set(Env_T oEnv, const char *pcName, const char *pcValue)
+{
+   size_t uNameLength;
+   char *pcEntry;
+
+   assert(oEnv != NULL);
+   assert(pcName != NULL);
+   assert(pcValue != NULL);
+
+   uNameLength = strlen(pcName);
+   if (uNameLength == 0 || strchr(pcName, '=') != NULL)
+      return 0;
+
+   pcEntry = (char*)malloc(uNameLength + strlen(pcValue) + 2);
+   if (pcEntry == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   strcpy(pcEntry, pcName);
+   pcEntry[uNameLength] = '=';
+   strcpy(pcEntry + uNameLength + 1, pcValue);
+   Env_bind(oEnv, pcEntry, uNameLength);
+   free(pcEntry);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Env_unset(Env_T oEnv, const char *pcName)
+{
+   struct Binding **ppsBinding;
+   struct Binding *psBinding;
+   size_t uLength;
+
+   assert(oEnv != NULL);
+   assert(pcName != NULL);
+
+   uLength = strlen(pcName);
+   ppsBinding = Env_find(oEnv, pcName, uLength,
+                         Env_hash(pcName, uLength));
+   psBinding = *ppsBinding;
+   if (psBinding == NULL)
+      return;
+
+   *ppsBinding = psBinding->psNext;
+   free(psBinding->pcEntry);
+   free(psBinding);
+   oEnv->uLength--;
+   free(oEnv->ppcEnvp);
+   oEnv->ppcEnvp = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new environment array that holds the strings of the
+   variables of oEnv, and has room for uExtra more strings before the
+   terminating NULL.  Assign the number of strings to *puLength. */
+
+static char **Env_build(Env_T oEnv, size_t uExtra, size_t *puLength)
+{
+   struct Binding *psBinding;
+   char **ppcEnvp;
+   size_t uLength = 0;
+   size_t u;
+
+   ppcEnvp = (char**)malloc(sizeof(char*) *
+                            (oEnv->uLength + uExtra + 1));
+   if (ppcEnvp == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   for (u = 0; u < oEnv->uBucketCount; u++)
+      for (psBinding = oEnv->ppsBuckets[u]; psBinding != NULL;
+           psBinding = psBinding->psNext)
+         ppcEnvp[uLength++] = psBinding->pcEntry;
+   ppcEnvp[uLength] = NULL;
+   *puLength = uLength;
+   return ppcEnvp;
+}
+
+/*--------------------------------------------------------------------*/
+
+char **Env_getEnvp(Env_T oEnv)
+{
+   size_t uLength;
+
+   assert(oEnv != NULL);
+
+   if (oEnv->ppcEnvp == NULL)
+      oEnv->ppcEnvp = Env_build(oEnv, 0, &uLength);
+   return oEnv->ppcEnvp;
+}
+
+/*--------------------------------------------------------------------*/
+
+char **Env_getEnvpWith(Env_T oEnv, char **ppcOverrides,
+                       size_t uCount)
+{
+   char **ppcEnvp;
+   size_t uLength;
+   size_t uNameLength;
+   size_t u, v;
+
+   assert(oEnv != NULL);
+   assert(ppcOverrides != NULL || uCount == 0);
+
+   ppcEnvp = Env_build(oEnv, uCount, &uLength);
+
+   /* Replace the variables that the overrides name, and append the
+      others.  There are few overrides, so search linearly. */
+   for (u = 0; u < uCount; u++)
+   {
+      uNameLength = (size_t)(strchr(ppcOverrides[u], '=') -
+                             ppcOverrides[u]) + 1;
+      for (v = 0; v < uLength; v++)
+         if (strncmp(ppcEnvp[v], ppcOverrides[u], uNameLength) == 0)
+            break;
+      ppcEnvp[v] = ppcOverrides[u];
+      if (v == uLength)
+         uLength++;
+   }
+   ppcEnvp[uLength] = NULL;
+   return ppcEnvp;
+}
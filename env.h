@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------*/
+/* env.h                                                              */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef ENV_INCLUDED
+#define ENV_INCLUDED
+
+#include <stddef.h>
+
+/* An Env_T object is a set of environment variables, each a name
+   bound to a value, kept in a hash table.  It also supplies the
+   variables as an environment array for execve, which it rebuilds
+   only after they have changed. */
+
+typedef struct Env *Env_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Env_T object that holds the variables of the
+   environment array ppcEnviron, such as environ. */
+
+Env_T Env_new(char **ppcEnviron);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oEnv. */
+
+void Env_free(Env_T oEnv);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of the variable of oEnv named pcName, or NULL if
+   there is none.  The value stays valid until oEnv changes. */
+
+const char *Env_get(Env_T oEnv, const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Like Env_get, but the name is the uLength characters at pcName,
+   which need not be followed by a null character. */
+
+const char *Env_lookUp(Env_T oEnv, const char *pcName,
+                       size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Bind the variable of oEnv named pcName to the value pcValue.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if pcName is not a
+   valid name: empty or containing '='. */
+
+int Env_set(Env_T oEnv, const char *pcName, const char *pcValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the variable of oEnv named pcName, if any. */
+
+void Env_unset(Env_T oEnv, const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the variables of oEnv as an environment array of
+   "NAME=value" strings, the last followed by NULL.  The array belongs
+   to oEnv and stays valid until oEnv changes. */
+
+char **Env_getEnvp(Env_T oEnv);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the variables of oEnv, overridden and extended by the
+   uCount "NAME=value" strings ppcOverrides, as an environment array
+   like the one that Env_getEnvp returns.  The caller owns the array,
+   but not the strings, which belong to oEnv and ppcOverrides. */
+
+char **Env_getEnvpWith(Env_T oEnv, char **ppcOverrides,
+                       size_t uCount);
+
+#endif
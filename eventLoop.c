@@ -0,0 +1,207 @@
+/*--------------------------------------------------------------------*/
+/* eventLoop.c                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "eventLoop.h"
+#include "dynarray.h"
+#include "ish.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The most events that one epoll_wait collects. */
+
+enum {MAX_EVENTS = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* A Watch is a file descriptor together with the function to call
+   when it is ready. */
+
+struct Watch
+{
+   /* The file descriptor, or -1 once it is no longer watched. */
+   int iFd;
+
+   /* The function to call, and its extra argument. */
+   void (*pfReady)(int iFd, void *pvExtra);
+   void *pvExtra;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An EventLoop consists of an epoll instance and the Watches that it
+   reports events for. */
+
+struct EventLoop
+{
+   /* The epoll instance. */
+   int iEpollFd;
+
+   /* The Watches, in no particular order. */
+   DynArray_T oWatches;
+
+   /* The Watches that EventLoop_unwatch removed while events that
+      may refer to them were being handled.  They are freed after
+      the events are. */
+   DynArray_T oRetired;
+
+   /* 1 (TRUE) iff EventLoop_run should return. */
+   int iStopping;
+};
+
+/*--------------------------------------------------------------------*/
+
+EventLoop_T EventLoop_new(void)
+{
+   EventLoop_T oEventLoop;
+
+   oEventLoop = (struct EventLoop*)malloc(sizeof(struct EventLoop));
+   if (oEventLoop == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   oEventLoop->iEpollFd = epoll_create1(EPOLL_CLOEXEC);
+   if (oEventLoop->iEpollFd == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   oEventLoop->oWatches = DynArray_new(0);
+   oEventLoop->oRetired = DynArray_new(0);
+   if (oEventLoop->oWatches == NULL || oEventLoop->oRetired == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   oEventLoop->iStopping = 0;
+   return oEventLoop;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pvWatch, a struct Watch.  pvExtra is unused. */
+
+static void EventLoop_freeWatch(void *pvWatch, void *pvExtra)
+{
+   free(pvWatch);
+}
+
+/*--------------------------------------------------------------------*/
+
+void EventLoop_free(EventLoop_T oEventLoop)
+{
+   assert(oEventLoop != NULL);
+
+   DynArray_map(oEventLoop->oWatches, EventLoop_freeWatch, NULL);
+   DynArray_map(oEventLoop->oRetired, EventLoop_freeWatch, NULL);
+   DynArray_free(oEventLoop->oWatches);
+   DynArray_free(oEventLoop->oRetired);
+   close(oEventLoop->iEpollFd);
+   free(oEventLoop);
+}
+
+/*--------------------------------------------------------------------*/
+
+void EventLoop_watch(EventLoop_T oEventLoop, int iFd,
+                     void (*pfReady)(int iFd, void *pvExtra),
+                     void *pvExtra)
+{
+   struct Watch *psWatch;
+   struct epoll_event sEvent;
+
+   assert(oEventLoop != NULL);
+   assert(iFd >= 0);
+   assert(pfReady != NULL);
+
+   psWatch = (struct Watch*)malloc(sizeof(struct Watch));
+   if (psWatch == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   psWatch->iFd = iFd;
+   psWatch->pfReady = pfReady;
+   psWatch->pvExtra = pvExtra;
+
+   sEvent.events = EPOLLIN;
+   sEvent.data.ptr = psWatch;
+   if (epoll_ctl(oEventLoop->iEpollFd, EPOLL_CTL_ADD, iFd, &sEvent)
+       == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   if (! DynArray_add(oEventLoop->oWatches, psWatch))
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+void EventLoop_unwatch(EventLoop_T oEventLoop, int iFd)
+{
+   struct Watch *psWatch;
+   size_t uLength;
+   size_t u;
+
+   assert(oEventLoop != NULL);
+
+   uLength = DynArray_getLength(oEventLoop->oWatches);
+   for (u = 0; u < uLength; u++)
+   {
+      psWatch = DynArray_get(oEventLoop->oWatches, u);
+      if (psWatch->iFd == iFd)
+         break;
+   }
+   assert(u < uLength);
+
+   if (epoll_ctl(oEventLoop->iEpollFd, EPOLL_CTL_DEL, iFd, NULL) == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   /* Events that EventLoop_run has yet to handle may still point to
+      the Watch, so mark it rather than free it now. */
+   DynArray_set(oEventLoop->oWatches, u,
+                DynArray_get(oEventLoop->oWatches, uLength - 1));
+   DynArray_removeAt(oEventLoop->oWatches, uLength - 1);
+   psWatch->iFd = -1;
+   if (! DynArray_add(oEventLoop->oRetired, psWatch))
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+void EventLoop_run(EventLoop_T oEventLoop)
+{
+   struct epoll_event asEvents[MAX_EVENTS];
+   struct Watch *psWatch;
+   int iCount;
+   int i;
+
+   assert(oEventLoop != NULL);
+
+   oEventLoop->iStopping = 0;
+   while (! oEventLoop->iStopping)
+   {
+      iCount = epoll_wait(oEventLoop->iEpollFd, asEvents, MAX_EVENTS,
+                          -1);
+      if (iCount == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         perror(getPgmName());
+         exit(EXIT_FAILURE);
+      }
+
+      for (i = 0; i < iCount; i++)
+      {
+         psWatch = (struct Watch*)asEvents[i].data.ptr;
+         if (psWatch->iFd != -1)
+            (*psWatch->pfReady)(psWatch->iFd, psWatch->pvExtra);
+      }
+
+      DynArray_map(oEventLoop->oRetired, EventLoop_freeWatch, NULL);
+      DynArray_clear(oEventLoop->oRetired);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void EventLoop_stop(EventLoop_T oEventLoop)
+{
+   assert(oEventLoop != NULL);
+
+   oEventLoop->iStopping = 1;
+}
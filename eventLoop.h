@@ -0,0 +1,63 @@
+/*--------------------------------------------------------------------*/
+/* eventLoop.h                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef EVENTLOOP_INCLUDED
+#define EVENTLOOP_INCLUDED
+
+/* An EventLoop_T object waits, with epoll, for any of a set of file
+   descriptors to become ready for reading, and calls the function
+   that watches each one that does.  Input, signals, child processes
+   and timers all reach the shell through one EventLoop_T object. */
+
+typedef struct EventLoop *EventLoop_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new EventLoop_T object that watches no file
+   descriptors. */
+
+EventLoop_T EventLoop_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oEventLoop.  The file descriptors that it watches stay
+   open. */
+
+void EventLoop_free(EventLoop_T oEventLoop);
+
+/*--------------------------------------------------------------------*/
+
+/* Make oEventLoop call (*pfReady)(iFd, pvExtra) whenever file
+   descriptor iFd is ready for reading, or has reached end-of-file or
+   an error.  oEventLoop must not already watch iFd. */
+
+void EventLoop_watch(EventLoop_T oEventLoop, int iFd,
+                     void (*pfReady)(int iFd, void *pvExtra),
+                     void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Make oEventLoop stop watching file descriptor iFd, which it must
+   watch.  Once EventLoop_unwatch returns, the function that watched
+   iFd is not called for it again, even for events that oEventLoop has
+   already collected.  The caller may then close iFd. */
+
+void EventLoop_unwatch(EventLoop_T oEventLoop, int iFd);
+
+/*--------------------------------------------------------------------*/
+
+/* Wait for events and call the functions that watch the ready file
+   descriptors, until one of them calls EventLoop_stop. */
+
+void EventLoop_run(EventLoop_T oEventLoop);
+
+/*--------------------------------------------------------------------*/
+
+/* Make EventLoop_run return once the functions for the events that
+   oEventLoop has already collected have been called. */
+
+void EventLoop_stop(EventLoop_T oEventLoop);
+
+#endif
@@ -3,25 +3,90 @@
 /* Author: Jingran Zhou                                               */
 /*--------------------------------------------------------------------*/
 
-#define _GNU_SOURCE /* For setenv and unsetenv to work properly. */
-
 #include "lexAnalyzer.h"
 #include "synAnalyzer.h"
+#include "readAhead.h"
+#include "signals.h"
+#include "eventLoop.h"
+#include "launch.h"
+#include "env.h"
 #include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
-#include <fcntl.h>
-#include <signal.h>
+#include <sys/resource.h>
+#include <sys/pidfd.h>
+#include <sys/timerfd.h>
 
 /*--------------------------------------------------------------------*/
 
 /* The name of the executable binary file. */
 static const char *pcPgmName;
 
+/* The environment that the shell passes to commands. */
+extern char **environ;
+static Env_T oEnv;
+
+/* The shell is an EventLoop that watches signals and, in turn, either
+   the input for the next line or the pidfd of the command that runs.
+   It is driven by oEventLoop. */
+static EventLoop_T oEventLoop;
+
+/* The analyzed lines of stdin, and the file descriptor that tells
+   when the next one is ready. */
+static ReadAhead_T oReadAhead;
+static int iInputFd;
+
+/* 1 (TRUE) iff stdin is a terminal. */
+static int iInteractive;
+
+/* 1 (TRUE) iff the shell is a subshell that runs the command of a
+   command substitution, instead of reading lines. */
+static int iSubshell = 0;
+
+/* The process ID and pidfd of the command that runs, or -1 if the
+   shell is reading a line. */
+static pid_t iChildPid = -1;
+static int iChildFd = -1;
+
+/* How the command that runs was launched, or NULL if no command
+   runs. */
+static Launch_T oChildLaunch = NULL;
+
+/* The commands of the line that follow the command that runs, or
+   NULL if none do, and how the command that runs is joined to them. */
+static Command_T oPendingCommands = NULL;
+static enum CommandJoin ePendingJoin = COMMAND_JOIN_NONE;
+
+/* The line whose remaining commands are analyzed only when their turn
+   comes, because they expand variables, commands or patterns, or NULL
+   if there is none, and the index in it of the next command. */
+static char *pcPendingLine = NULL;
+static size_t uPendingIndex = 0;
+
+/* The timerfd that enforces the timeout of the command that runs, or
+   -1 if it has none, and the number of seconds after SIGTERM that it
+   is sent SIGKILL (0 if never). */
+static int iTimerFd = -1;
+static double dKillAfter = 0;
+
+/* The signal that the timeout of the command that runs sent last, or
+   0 if none. */
+static int iTimeoutSignal = 0;
+
+/* The exit status of the last command: 125 if its prefix commands
+   were malformed, 124 if its timeout sent it SIGTERM, 128 plus the
+   number of the signal that ended it otherwise, and the status that
+   it exited with otherwise. */
+static int iStatus = 0;
+
 /*--------------------------------------------------------------------*/
 
 /* Return the value of the global variable pcPgmName, which means the
@@ -36,93 +101,64 @@ const char* getPgmName()
 
 /*--------------------------------------------------------------------*/
 
-/* Handler for the ALRM signal. */
-
-static void alarmHandler(int iSig)
-{
-   printf("Alarm handler triggered!\n");
-}
-
-/*--------------------------------------------------------------------*/
-
-/* Handler for signal iSig When the parent process is not handling a 
-   command. */
+/* Return the value of the variable whose name is the uLength
+   characters at pcName, or NULL if it is not set.  The variable ? is
+   the exit status of the last command.  pvExtra is unused. */
 
-static void idleHandler(int iSig)
+static const char *lookUpVariable(const char *pcName, size_t uLength,
+                                  void *pvExtra)
 {
-   size_t uTimeRemain = alarm(0);
-   /* If within 5 seconds, print message. */
-   if (uTimeRemain > 0)
-      printf("To exit the shell, issue an 'exit' command\n");
-   alarm(5);
-}
+   /* Room for the digits of the status. */
+   static char acStatus[16];
 
-/*--------------------------------------------------------------------*/
-
-static void handleRedirection(Command_T oCommand)
-{
-   /* The permissions of the newly-created file. */
-   enum {PERMISSIONS = 0600};
-   int iFd; /* File descriptor. */
-   int iRet; /* Function return value. */
-   
-   /* Handle stdin-redirection. */
-   if (Command_getStdIn(oCommand) != NULL)
+   if (uLength == 1 && pcName[0] == '?')
    {
-      iFd = open(Command_getStdIn(oCommand), O_RDONLY);
-      if (iFd == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
-      iRet = close(0); /* Close stdin. */
-      if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
-      iRet = dup(iFd);
-      if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
-      iRet = close(iFd);
-      if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-   }
-   
-   /* Handle stdout-redirection. */
-   if (Command_getStdOut(oCommand) != NULL)
-   {
-      iFd = creat(Command_getStdOut(oCommand), PERMISSIONS);
-      if (iFd == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-
-      iRet = close(1); /* Close stdout. */
-      if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-
-      iRet = dup(iFd);
-      if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-
-      iRet = close(iFd);
-      if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+      sprintf(acStatus, "%d", iStatus);
+      return acStatus;
    }
+   return Env_lookUp(oEnv, pcName, uLength);
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Handle the cd command depending on ppcArgv and uArgsNum. */
+/* Handle the cd command depending on ppcArgv and uArgsNum.  On
+   failure, report the error and set the status to 1. */
 
 static void handleCd(char** ppcArgv, size_t uArgsNum)
 {
+   const char* pcDir;
+
    /* If 0 argument, default to HOME. */
    if (uArgsNum == 0)
    {
-      char* HOME;
-      if ((HOME = getenv("HOME")) == NULL)
+      if ((pcDir = Env_get(oEnv, "HOME")) == NULL)
+      {
          fprintf(stderr, "%s: HOME is not set.\n", pcPgmName);
-      else chdir(HOME);
+         iStatus = 1;
+         return;
+      }
    }
    /* Else if there are more than 1 argument, error. */
    else if (uArgsNum > 1)
+   {
       fprintf(stderr, "%s: too many arguments\n", pcPgmName);
-   else /* Else call chdir normally. */
-      chdir(ppcArgv[1]);
+      iStatus = 1;
+      return;
+   }
+   else pcDir = ppcArgv[1];
+
+   if (chdir(pcDir) == -1)
+   {
+      fprintf(stderr, "%s: cd: %s: %s\n", pcPgmName, pcDir,
+              strerror(errno));
+      iStatus = 1;
+   }
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Handle the unsetenv command depending on ppcArgv and uArgsNum. */
+/* Handle the unsetenv command depending on ppcArgv and uArgsNum.  On
+   failure, report the error and set the status to 1. */
 
 static void handleUnsetenv(char** ppcArgv, size_t uArgsNum)
 {
@@ -131,15 +167,17 @@ static void handleUnsetenv(char** ppcArgv, size_t uArgsNum)
    {
       fprintf(stderr,
               "%s: missing variable\n", pcPgmName);
+      iStatus = 1;
    }
    
-   /* Else call unsetenv normally. */
-   else unsetenv(ppcArgv[1]);
+   /* Else remove the variable. */
+   else Env_unset(oEnv, ppcArgv[1]);
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Handle the setenv shell command with ppcArgv and uArgsNum. */
+/* Handle the setenv shell command with ppcArgv and uArgsNum.  On
+   failure, report the error and set the status to 1. */
 
 static void handleSetenv(char** ppcArgv, size_t uArgsNum)
 {
@@ -148,23 +186,197 @@ static void handleSetenv(char** ppcArgv, size_t uArgsNum)
    {
       fprintf(stderr,
               "%s: missing variable\n", pcPgmName);
+      iStatus = 1;
    }
    
-   /* If only 1 argument, set to empty string. */
-   else if (uArgsNum == 1) setenv(ppcArgv[1], "", 1);
-   
-   /* There are two commands, call setenv normally. */
-   else setenv(ppcArgv[1], ppcArgv[2], 1);
+   /* If only 1 argument, set to empty string; else set to the second
+      argument. */
+   else if (! Env_set(oEnv, ppcArgv[1],
+                      (uArgsNum == 1) ? "" : ppcArgv[2]))
+   {
+      fprintf(stderr, "%s: setenv: invalid variable\n", pcPgmName);
+      iStatus = 1;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Handle the next line (see below). */
+
+static void handleLine(int iFd, void *pvExtra);
+static void execCmds(Command_T oCommand, DynArray_T oTokens);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout a prompt. */
+
+static void writePrompt(void)
+{
+   printf("%% ");
+   if (iInteractive) fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Arm the timerfd iTimerFd to expire once, after dSeconds
+   seconds. */
+
+static void armTimer(double dSeconds)
+{
+   struct itimerspec sTimer;
+
+   memset(&sTimer, 0, sizeof(sTimer));
+   sTimer.it_value.tv_sec = (time_t)dSeconds;
+   sTimer.it_value.tv_nsec =
+      (long)((dSeconds - (double)sTimer.it_value.tv_sec) * 1e9);
+
+   /* A zero it_value would disarm the timer. */
+   if (sTimer.it_value.tv_sec == 0 && sTimer.it_value.tv_nsec == 0)
+      sTimer.it_value.tv_nsec = 1;
+   if (timerfd_settime(iTimerFd, 0, &sTimer, NULL) == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Execute oCommand. */
+/* Enforce the timeout of the command that runs, whose timerfd iFd has
+   expired: send it SIGTERM, and the next time SIGKILL.  pvExtra is
+   unused. */
+
+static void handleTimeout(int iFd, void *pvExtra)
+{
+   uint64_t uiExpirations;
+
+   assert(iFd == iTimerFd);
+
+   if (read(iTimerFd, &uiExpirations, sizeof(uiExpirations)) == -1)
+      return;
+
+   iTimeoutSignal = (iTimeoutSignal == 0) ? SIGTERM : SIGKILL;
+   /* The command may have exited without having been reaped yet. */
+   if (pidfd_send_signal(iChildFd, iTimeoutSignal, NULL, 0) == -1 &&
+       errno != ESRCH)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   if (iTimeoutSignal == SIGTERM && dKillAfter > 0)
+      armTimer(dKillAfter);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Reap the command that runs, whose pidfd iFd is ready, and read
+   lines again.  pvExtra is unused. */
+
+static void handleChildExit(int iFd, void *pvExtra)
+{
+   pid_t pid;
+   int iWaitStatus;
+   struct rusage sUsage;
+   const char *pcLimit;
+
+   assert(iFd == iChildFd);
+
+   pid = wait4(iChildPid, &iWaitStatus, 0, &sUsage);
+   if (pid == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   /* Report the resource limit that ended the command, if any. */
+   pcLimit = Launch_getLimitHit(oChildLaunch, iWaitStatus, &sUsage);
+   if (pcLimit != NULL)
+      fprintf(stderr, "%s: command exceeded its %s limit\n",
+              pcPgmName, pcLimit);
+   Launch_free(oChildLaunch);
+   oChildLaunch = NULL;
+   EventLoop_unwatch(oEventLoop, iChildFd);
+   close(iChildFd);
+   iChildPid = -1;
+   iChildFd = -1;
+
+   if (iTimeoutSignal == SIGTERM) iStatus = 124;
+   else if (WIFSIGNALED(iWaitStatus))
+      iStatus = 128 + WTERMSIG(iWaitStatus);
+   else iStatus = WEXITSTATUS(iWaitStatus);
+   if (iTimerFd != -1)
+   {
+      EventLoop_unwatch(oEventLoop, iTimerFd);
+      close(iTimerFd);
+      iTimerFd = -1;
+   }
+   iTimeoutSignal = 0;
+
+   /* Stop ignoring SIGINT. */
+   Signals_setState(SIGNALS_IDLE);
+
+   /* Run the rest of the line, unless SIGINT ended the command. */
+   if (WIFSIGNALED(iWaitStatus) && WTERMSIG(iWaitStatus) == SIGINT)
+   {
+      Command_free(oPendingCommands);
+      oPendingCommands = NULL;
+      free(pcPendingLine);
+      pcPendingLine = NULL;
+   }
+   if (oPendingCommands != NULL || pcPendingLine != NULL)
+   {
+      execCmds(NULL, NULL);
+      if (iChildPid != -1)
+         return;
+   }
+
+   /* A subshell is done once its command is. */
+   if (iSubshell)
+   {
+      EventLoop_stop(oEventLoop);
+      return;
+   }
+
+   writePrompt();
+   EventLoop_watch(oEventLoop, iInputFd, handleLine, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Handle the ulimit shell command with ppcArgv and uArgsNum. */
+
+static void handleUlimit(char** ppcArgv, size_t uArgsNum)
+{
+   /* If there are no arguments, show the limits. */
+   if (uArgsNum == 0)
+      Launch_printLimits();
+
+   /* Else set them for every later command. */
+   else if (! Launch_setLimits(ppcArgv + 1))
+   {
+      fprintf(stderr, "%s: ulimit: invalid limit\n", pcPgmName);
+      iStatus = 1;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Handle the setsched shell command with ppcArgv and uArgsNum. */
+
+static void handleSetsched(char** ppcArgv, size_t uArgsNum)
+{
+   /* If there are no arguments, show the settings. */
+   if (uArgsNum == 0)
+      Launch_printPlacement();
+
+   /* Else make them for every later command. */
+   else if (! Launch_setPlacement(ppcArgv + 1))
+   {
+      fprintf(stderr, "%s: setsched: invalid setting\n", pcPgmName);
+      iStatus = 1;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute oCommand.  If it is an external command, then start it,
+   and leave it to handleChildExit to finish it. */
+
 static void execCmd(Command_T oCommand, DynArray_T oTokens)
 {
    size_t uArgsNum = Command_getArgsNum(oCommand);
-   pid_t pid;
-   int iRet; /* Function return value. */
+   Launch_T oLaunch;
+   const char *pcError;
    char** ppcArgv;
 
    assert(oCommand != NULL);
@@ -172,12 +384,13 @@ static void execCmd(Command_T oCommand, DynArray_T oTokens)
    /* Extract arguments into an array. */
    ppcArgv = Command_getArgv(oCommand);
    
+   /* Ignore SIGINT while the command runs. */
+   Signals_setState(SIGNALS_BUSY);
+   iStatus = 0;
+
    /* Handle exit shell command. */
    if (strcmp(Command_getName(oCommand), "exit") == 0)
    {
-      /* Ignore SIGINT signal. */
-      signal(SIGINT, SIG_IGN);
-      
       if (oTokens != NULL)
       {
          LexAnalyzer_freeTokens(oTokens);
@@ -189,76 +402,58 @@ static void execCmd(Command_T oCommand, DynArray_T oTokens)
    
    /* Handle setenv shell command. */
    else if (strcmp(Command_getName(oCommand), "setenv") == 0)
-   {  /* Ignore SIGINT signal. */
-      signal(SIGINT, SIG_IGN);
-      
       handleSetenv(ppcArgv, uArgsNum);
 
-      /* Restore default action for SIGINT signal. */
-      signal(SIGINT, idleHandler);
-   }
-
    /* Handle unsetenv shell command. */
    else if (strcmp(Command_getName(oCommand), "unsetenv") == 0)
-   {  /* Ignore SIGINT signal. */
-      signal(SIGINT, SIG_IGN);
-      
       handleUnsetenv(ppcArgv, uArgsNum);
 
-      /* Restore default action for SIGINT signal. */
-      signal(SIGINT, idleHandler);
-   }
-
    /* Handle cd shell command. */ 
    else if (strcmp(Command_getName(oCommand), "cd") == 0)
-   {  /* Ignore SIGINT signal. */
-      signal(SIGINT, SIG_IGN);
-      
       handleCd(ppcArgv, uArgsNum);
 
-      /* Restore default action for SIGINT signal. */
-      signal(SIGINT, idleHandler);
-   }
+   /* Handle ulimit shell command. */
+   else if (strcmp(Command_getName(oCommand), "ulimit") == 0)
+      handleUlimit(ppcArgv, uArgsNum);
+
+   /* Handle setsched shell command. */
+   else if (strcmp(Command_getName(oCommand), "setsched") == 0)
+      handleSetsched(ppcArgv, uArgsNum);
    
    else /* Handle external commands. */
    {
-      /* Flush buffer. */
-      iRet = fflush(NULL);
-      if (iRet == EOF) {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
-      /* Ignore SIGINT signal. */
-      signal(SIGINT, SIG_IGN);
-      
-      pid = fork();
-      if (pid == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
-      if (pid == 0)
+      oLaunch = Launch_new(oCommand, ppcArgv, &pcError);
+      if (oLaunch == NULL)
       {
-         /* Make sure the SIGINT and SIGALRM are not blocked. */
-         sigset_t sigintMask;
-         sigemptyset(&sigintMask);
-         sigaddset(&sigintMask, SIGINT);
-         sigprocmask(SIG_UNBLOCK, &sigintMask, NULL);
-
-         /* Restore default action for SIGINT signal. */
-         signal(SIGINT, SIG_DFL);
-         
-         /* Handle stdin and stdout file redirections. */
-         handleRedirection(oCommand);
-
-         /* In child, execute the command. */
-         execvp(Command_getName(oCommand), ppcArgv);
-         fprintf(stderr, "%s: No such file or directory\n", pcPgmName);
-         exit(EXIT_FAILURE);
+         fprintf(stderr, "%s: %s\n", pcPgmName, pcError);
+         iStatus = 125;
+      }
+      else
+      {
+         iChildPid = Launch_start(oLaunch, oEnv);
+
+         /* Parent watches the child. */
+         iChildFd = pidfd_open(iChildPid, 0);
+         if (iChildFd == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+         EventLoop_watch(oEventLoop, iChildFd, handleChildExit, NULL);
+
+         /* Watch the timeout, if any, too. */
+         if (Launch_getTimeout(oLaunch) > 0)
+         {
+            iTimerFd = timerfd_create(CLOCK_MONOTONIC,
+                                      TFD_NONBLOCK | TFD_CLOEXEC);
+            if (iTimerFd == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+            dKillAfter = Launch_getKillAfter(oLaunch);
+            armTimer(Launch_getTimeout(oLaunch));
+            EventLoop_watch(oEventLoop, iTimerFd, handleTimeout, NULL);
+         }
+         oChildLaunch = oLaunch;
       }
-      
-      /* Parent waits. */
-      pid = wait(NULL);
-      if (pid == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-
-      /* Restore handler for SIGINT signal. */
-      signal(SIGINT, idleHandler);
    }
+
+   /* Stop ignoring SIGINT once a shell command is done. */
+   if (iChildPid == -1)
+      Signals_setState(SIGNALS_IDLE);
    
    /* Free memory. */
    Command_free(oCommand);
@@ -267,61 +462,388 @@ static void execCmd(Command_T oCommand, DynArray_T oTokens)
 
 /*--------------------------------------------------------------------*/
 
-int main(int argc, char* argv[])
-{  
+/* Return 1 (TRUE) iff the uLength characters at pcText are all white
+   space. */
+
+static int isBlank(const char *pcText, size_t uLength)
+{
+   size_t u;
+
+   for (u = 0; u < uLength; u++)
+      if (strchr(" \t\n\v\f\r", pcText[u]) == NULL)
+         return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the next command from the pending line, assign how it is
+   joined to the command after it to *peJoin, and if iAnalyze is
+   1 (TRUE), then analyze it, expanding its variables, commands and
+   patterns now.  Return its Command object, or NULL if it is not
+   analyzed, has no words, or has an error, which is reported, and
+   then sets the status to 1.  Free the line after its last
+   command. */
+
+static Command_T takePendingCommand(int iAnalyze,
+                                    enum CommandJoin *peJoin)
+{
+   char *pcCommand = pcPendingLine + uPendingIndex;
+   size_t uLength;
+   size_t uJoinLength;
+   DynArray_T oTokens;
+   Command_T oCommand = NULL;
+   const char *pcError = NULL;
+
+   assert(pcPendingLine != NULL);
+   assert(peJoin != NULL);
+
+   uLength = LexAnalyzer_findJoin(pcCommand, &uJoinLength);
+   if (uJoinLength == 0) *peJoin = COMMAND_JOIN_NONE;
+   else if (uJoinLength == 1) *peJoin = COMMAND_JOIN_SEQUENCE;
+   else if (pcCommand[uLength] == '&') *peJoin = COMMAND_JOIN_AND;
+   else *peJoin = COMMAND_JOIN_OR;
+   uPendingIndex += uLength + uJoinLength;
+   pcCommand[uLength] = '\0';
+
+   if (iAnalyze)
+   {
+      oTokens = LexAnalyzer_lexLineQuietly(pcCommand, &pcError);
+      if (oTokens != NULL)
+      {
+         oCommand = SynAnalyzer_synTokensQuietly(oTokens, &pcError);
+         LexAnalyzer_freeTokens(oTokens);
+         DynArray_free(oTokens);
+      }
+      if (pcError != NULL)
+      {
+         fprintf(stderr, "%s: %s\n", pcPgmName, pcError);
+         iStatus = 1;
+      }
+   }
+
+   /* The list may end with ";". */
+   if (*peJoin == COMMAND_JOIN_SEQUENCE &&
+       isBlank(pcPendingLine + uPendingIndex,
+               strlen(pcPendingLine + uPendingIndex)))
+      *peJoin = COMMAND_JOIN_NONE;
+   if (*peJoin == COMMAND_JOIN_NONE)
+   {
+      free(pcPendingLine);
+      pcPendingLine = NULL;
+   }
+   return oCommand;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the list of commands that starts with oCommand, or the
+   pending commands if oCommand is NULL, one after the other, skipping
+   each command that the exit status of the last one rules out: one
+   that "&&" joins to a command that failed, or "||" to one that
+   succeeded.  A skipped command of the pending line is not analyzed.
+   Stop at a command that runs as a child, leaving the commands that
+   follow it pending until it exits.  The exit command frees oTokens,
+   the tokens of the line, unless it is NULL. */
+
+static void execCmds(Command_T oCommand, DynArray_T oTokens)
+{
+   enum CommandJoin eJoin;
+   int iSkipped;
+
+   /* The first command of a line runs in any case. */
+   if (oCommand != NULL)
+   {
+      oPendingCommands = oCommand;
+      ePendingJoin = COMMAND_JOIN_SEQUENCE;
+   }
+
+   while (oPendingCommands != NULL || pcPendingLine != NULL)
+   {
+      iSkipped = (ePendingJoin == COMMAND_JOIN_AND && iStatus != 0) ||
+         (ePendingJoin == COMMAND_JOIN_OR && iStatus == 0);
+      if (oPendingCommands != NULL)
+      {
+         oCommand = oPendingCommands;
+         eJoin = Command_getJoin(oCommand);
+         oPendingCommands = Command_detachNext(oCommand);
+      }
+      else oCommand = takePendingCommand(! iSkipped, &eJoin);
+
+      if (iSkipped)
+         Command_free(oCommand);
+      else if (oCommand != NULL)
+         execCmd(oCommand, oTokens);
+      ePendingJoin = eJoin;
+
+      if (iChildPid != -1)
+         return;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the commands of pcLine, which the shell then owns, and which
+   expands variables, commands or patterns.  Analyze each command only
+   when its turn comes, so that it sees the effects of the commands
+   before it.  Return 1 (TRUE) if successful, or 0 (FALSE) after
+   reporting an error if a command of the list is missing. */
+
+static int execLine(char *pcLine)
+{
+   size_t uIndex = 0;
+   size_t uLength;
+   size_t uJoinLength;
+   size_t uLastJoinLength = 1;
+
+   assert(pcLine != NULL);
+
+   /* Only a final command after ";" may be missing. */
+   do
+   {
+      uLength = LexAnalyzer_findJoin(pcLine + uIndex, &uJoinLength);
+      if (isBlank(pcLine + uIndex, uLength) &&
+          (uJoinLength > 0 || uLastJoinLength > 1))
+      {
+         fprintf(stderr, "%s: missing command name\n", pcPgmName);
+         free(pcLine);
+         return 0;
+      }
+      uIndex += uLength + uJoinLength;
+      uLastJoinLength = uJoinLength;
+   } while (uJoinLength > 0);
+
+   pcPendingLine = pcLine;
+   uPendingIndex = 0;
+   ePendingJoin = COMMAND_JOIN_SEQUENCE;
+   execCmds(NULL, NULL);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Handle the next line, whose input file descriptor iFd is ready.  At
+   end-of-file, stop the EventLoop.  pvExtra is unused. */
+
+static void handleLine(int iFd, void *pvExtra)
+{
    char* pcLine;
+   const char* pcError;
    int iRet;
    DynArray_T oTokens = NULL;
    Command_T oCommand = NULL;
-   sigset_t mask, prev_mask;
-   
-   pcPgmName = argv[0];
 
-   /* Make sure the SIGINT and SIGALRM are not blocked. */
-   sigemptyset(&mask);
-   sigaddset(&mask, SIGINT);
-   sigaddset(&mask, SIGALRM);
-   sigprocmask(SIG_UNBLOCK, &mask, &prev_mask);
+   assert(iFd == iInputFd);
 
-   /* Install signal handlers. */
-   signal(SIGINT, idleHandler);
-   signal(SIGALRM, alarmHandler);
-   
-   /* Write to stdout a prompt. */
-   printf("%% ");
+   if (! ReadAhead_next(oReadAhead, &pcLine, &oTokens, &oCommand,
+                        &pcError))
+   {
+      EventLoop_stop(oEventLoop);
+      return;
+   }
+
+   /* Write the line to stdout and flush the buffer. */
+   printf("%s\n", pcLine);
+   iRet = fflush(stdout);
+   if (iRet == EOF)
+   {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   /* Report a lexical or syntactic error in the line, which fails
+      like a command that fails. */
+   if (pcError != NULL)
+   {
+      fprintf(stderr, "%s: %s\n", pcPgmName, pcError);
+      iStatus = 1;
+   }
    
-   /* Read a line from stdin until reaching end-of-file. */
-   while ((pcLine = LexAnalyzer_readLine(stdin)) != NULL)
+   /* Execute the commands, if any, analyzing those of a line that
+      was left unanalyzed one at a time. */
+   if (oTokens == NULL && pcError == NULL)
+      execLine(pcLine);
+   else
    {
-      /* Write the line to stdout and flush the buffer. */
-      printf("%s\n", pcLine);
-      iRet = fflush(stdout);
-      if (iRet == EOF)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
-      /* Pass the line to the lexical analyzer. */
-      oTokens = LexAnalyzer_lexLine(pcLine);
       free(pcLine);
-      
-      /* Pass the tokens to the syntactic analyzer. */
-      if (oTokens == NULL) oCommand = NULL;
-      else oCommand = SynAnalyzer_synTokens(oTokens);
-      
-      /* Execute the command, if any. */
       if (oCommand != NULL)
-         execCmd(oCommand, oTokens);
-      
-      /* Free tokens. */
-      if (oTokens != NULL)
+         execCmds(oCommand, oTokens);
+   }
+   
+   /* Free tokens, and reuse their DynArray object. */
+   if (oTokens != NULL)
+   {
+      LexAnalyzer_freeTokens(oTokens);
+      ReadAhead_recycle(oReadAhead, oTokens);
+   }
+
+   /* Unless a command runs, write to stdout a prompt.  Otherwise
+      watch the command instead of the input. */
+   if (iChildPid == -1)
+      writePrompt();
+   else EventLoop_unwatch(oEventLoop, iInputFd);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Handle the signals that have arrived, whose signalfd iFd is ready.
+   pvExtra is unused. */
+
+static void handleSignals(int iFd, void *pvExtra)
+{
+   Signals_dispatch();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* In a child process whose stdout is the pipe of a command
+   substitution, run the commands of pcLine, which the child then owns,
+   as the shell runs the commands of a line, and exit with the status
+   of the last. */
+
+static void runSubshell(char *pcLine)
+{
+   iSubshell = 1;
+
+   /* The EventLoop that the child inherits shares its epoll instance
+      with the parent's, and never runs again, so watch the command
+      with an EventLoop of its own. */
+   EventLoop_free(oEventLoop);
+   oEventLoop = EventLoop_new();
+   EventLoop_watch(oEventLoop, Signals_getFd(), handleSignals, NULL);
+
+   /* The commands that the parent has yet to run are not the
+      child's. */
+   Command_free(oPendingCommands);
+   oPendingCommands = NULL;
+   free(pcPendingLine);
+   pcPendingLine = NULL;
+
+   if (! execLine(pcLine))
+      exit(EXIT_FAILURE);
+   if (iChildPid != -1)
+      EventLoop_run(oEventLoop);
+   EventLoop_free(oEventLoop);
+   exit(iStatus);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the command that is the uLength characters at pcCommand in a
+   subshell, and return its standard output, whose length is assigned
+   to *puLength.  The output is in its own memory chunk, which the
+   caller owns.  pvExtra is unused. */
+
+static char *substituteCommand(const char *pcCommand, size_t uLength,
+                               size_t *puLength, void *pvExtra)
+{
+   /* The size of the buffer that the output is first read into. */
+   enum {INITIAL_OUTPUT_SIZE = 64 * 1024};
+
+   char *pcLine;
+   char *pcOutput;
+   size_t uSize = INITIAL_OUTPUT_SIZE;
+   size_t uOutputLength = 0;
+   ssize_t lRead;
+   int aiPipe[2];
+   int iWaitStatus;
+   pid_t pid;
+
+   assert(pcCommand != NULL);
+   assert(puLength != NULL);
+
+   pcLine = (char*)malloc(uLength + 1);
+   if (pcLine == NULL) {perror(pcPgmName); exit(EXIT_FAILURE);}
+   memcpy(pcLine, pcCommand, uLength);
+   pcLine[uLength] = '\0';
+
+   /* Flush stdout, or the child would write what it buffers, too. */
+   if (fflush(NULL) == EOF) {perror(pcPgmName); exit(EXIT_FAILURE);}
+   if (pipe(aiPipe) == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+   pid = fork();
+   if (pid == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+   if (pid == 0)
+   {
+      close(aiPipe[0]);
+      if (dup2(aiPipe[1], 1) == -1)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      close(aiPipe[1]);
+      runSubshell(pcLine);
+   }
+   close(aiPipe[1]);
+   free(pcLine);
+
+   /* Fill all of the buffer that remains with each read, and double
+      the buffer whenever it is full, so that reading takes time
+      linear in the length of the output. */
+   pcOutput = (char*)malloc(uSize);
+   if (pcOutput == NULL) {perror(pcPgmName); exit(EXIT_FAILURE);}
+   for (;;)
+   {
+      if (uOutputLength == uSize)
       {
-         LexAnalyzer_freeTokens(oTokens);
-         DynArray_free(oTokens);
+         uSize *= 2;
+         pcOutput = (char*)realloc(pcOutput, uSize);
+         if (pcOutput == NULL) {perror(pcPgmName); exit(EXIT_FAILURE);}
+      }
+      lRead = read(aiPipe[0], pcOutput + uOutputLength,
+                   uSize - uOutputLength);
+      if (lRead == 0)
+         break;
+      if (lRead == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         perror(pcPgmName);
+         exit(EXIT_FAILURE);
       }
-      
-      /* Write to stdout a prompt. */
-      printf("%% ");
-   } /* The while loop. */
+      uOutputLength += (size_t)lRead;
+   }
+   close(aiPipe[0]);
+
+   while (waitpid(pid, &iWaitStatus, 0) == -1)
+      if (errno != EINTR) {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   /* The status is the last command's until a command of the line
+      runs. */
+   if (WIFSIGNALED(iWaitStatus))
+      iStatus = 128 + WTERMSIG(iWaitStatus);
+   else iStatus = WEXITSTATUS(iWaitStatus);
+
+   *puLength = uOutputLength;
+   return pcOutput;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char* argv[])
+{  
+   /* The number of lines that may be analyzed ahead of execution. */
+   enum {READ_AHEAD_DEPTH = 16};
+
+   pcPgmName = argv[0];
+   oEnv = Env_new(environ);
+   LexAnalyzer_setLookUp(lookUpVariable, NULL);
+   LexAnalyzer_setGlobbing(1);
+   LexAnalyzer_setSubstitute(substituteCommand, NULL);
+
+   /* Accept signals through the EventLoop, before any thread starts. */
+   Signals_install();
+   oEventLoop = EventLoop_new();
+   EventLoop_watch(oEventLoop, Signals_getFd(), handleSignals, NULL);
+
+   /* Analyze lines ahead of execution only when stdin is not a
+      terminal, since lines typed interactively do not exist yet. */
+   iInteractive = isatty(0);
+   if (iInteractive) oReadAhead = ReadAhead_new(stdin, 0);
+   else oReadAhead = ReadAhead_new(stdin, READ_AHEAD_DEPTH);
+   iInputFd = ReadAhead_getFd(oReadAhead);
+   
+   /* Read a line from stdin until reaching end-of-file. */
+   writePrompt();
+   EventLoop_watch(oEventLoop, iInputFd, handleLine, NULL);
+   EventLoop_run(oEventLoop);
    
+   EventLoop_free(oEventLoop);
+   ReadAhead_free(oReadAhead);
+   Env_free(oEnv);
    printf("\n");
    return 0;
 }
@@ -3,22 +3,32 @@
 /* Author: Jingran Zhou                                               */
 /*--------------------------------------------------------------------*/
 
+#define _GNU_SOURCE /* For memrchr to work properly. */
+
 #include "dynarray.h"
 #include "token.h"
 #include "ish.h"
 #include "lexAnalyzer.h"
+#include "buffer.h"
+#include "dump.h"
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 /*--------------------------------------------------------------------*/
 
 /* The name of the executable binary file. */
 static const char *pcPgmName;
 
+/* 1 (TRUE) iff the output is a binary dump rather than text. */
+static int iBinary = 0;
+
 /*--------------------------------------------------------------------*/
 
-/* Return the value of the global variable pcPgmName, which means the 
+/* Return the value of the global variable pcPgmName, which means the
    name of the program. */
 
 const char* getPgmName()
@@ -30,13 +40,339 @@ const char* getPgmName()
 
 /*--------------------------------------------------------------------*/
 
-int main(int argc, char *argv[])
+/* A chunk of whole lines that one worker thread lexes, along with the
+   output that the serial mode would produce for them. */
+
+struct Chunk
+{
+   /* The first character of the chunk. */
+   char *pcStart;
+
+   /* One past the last character of the chunk, which ends with a
+      newline character. */
+   char *pcEnd;
+
+   /* The text destined for stdout. */
+   Buffer_T oOut;
+
+   /* The text destined for stderr. */
+   Buffer_T oErr;
+
+   /* The worker thread. */
+   pthread_t sThread;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append uLength characters at pcChars to oBuffer, exiting if
+   insufficient memory is available. */
+
+static void appendOrDie(Buffer_T oBuffer, const char *pcChars,
+                        size_t uLength)
+{
+   if (! Buffer_append(oBuffer, pcChars, uLength))
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append to oBuffer the text that Token_print writes for each token
+   in oTokens. */
+
+static void appendTokens(Buffer_T oBuffer, DynArray_T oTokens)
+{
+   size_t u;
+   size_t uLength;
+   Token_T oToken;
+   const char *pcValue;
+
+   assert(oBuffer != NULL);
+   assert(oTokens != NULL);
+
+   uLength = DynArray_getLength(oTokens);
+   for (u = 0; u < uLength; u++)
+   {
+      oToken = DynArray_get(oTokens, u);
+      pcValue = Token_getString(oToken);
+      appendOrDie(oBuffer, "Token: ", 7);
+      appendOrDie(oBuffer, pcValue, strlen(pcValue));
+      if (Token_getType(oToken) == TOKEN_ORDINARY)
+         appendOrDie(oBuffer, " (ordinary)\n", 12);
+      else
+         appendOrDie(oBuffer, " (special)\n", 11);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex pcLine, and append to oOut and oErr the output destined for
+   stdout and stderr respectively. */
+
+static void lexLineInto(const char *pcLine, Buffer_T oOut,
+                        Buffer_T oErr)
+{
+   DynArray_T oTokens;
+   const char *pcError;
+
+   assert(pcLine != NULL);
+   assert(oOut != NULL);
+   assert(oErr != NULL);
+
+   oTokens = LexAnalyzer_lexLineQuietly(pcLine, &pcError);
+
+   if (iBinary)
+   {
+      if (! Dump_appendString(oOut, DUMP_LINE, pcLine))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      if (oTokens != NULL)
+      {
+         if (! Dump_appendTokens(oOut, oTokens))
+            {perror(pcPgmName); exit(EXIT_FAILURE);}
+      }
+      else if (! Dump_appendString(oOut, DUMP_ERROR, pcError))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+   }
+   else
+   {
+      /* Like printf("%s\n"), stop the echo at any null character. */
+      appendOrDie(oOut, pcLine, strlen(pcLine));
+      appendOrDie(oOut, "\n", 1);
+      if (oTokens != NULL)
+         appendTokens(oOut, oTokens);
+      else
+      {
+         appendOrDie(oErr, pcPgmName, strlen(pcPgmName));
+         appendOrDie(oErr, ": ", 2);
+         appendOrDie(oErr, pcError, strlen(pcError));
+         appendOrDie(oErr, "\n", 1);
+      }
+      appendOrDie(oOut, "% ", 2);
+   }
+
+   if (oTokens != NULL)
+   {
+      LexAnalyzer_freeTokens(oTokens);
+      DynArray_free(oTokens);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The body of a worker thread that lexes the Chunk pvChunk. */
+
+static void *lexChunk(void *pvChunk)
+{
+   struct Chunk *psChunk = (struct Chunk*)pvChunk;
+   char *pcLine;
+   char *pcNewline;
+
+   assert(psChunk != NULL);
+
+   for (pcLine = psChunk->pcStart; pcLine < psChunk->pcEnd;
+        pcLine = pcNewline + 1)
+   {
+      pcNewline = (char*)memchr(pcLine, '\n',
+                                (size_t)(psChunk->pcEnd - pcLine));
+      assert(pcNewline != NULL);
+      *pcNewline = '\0';
+      lexLineInto(pcLine, psChunk->oOut, psChunk->oErr);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the start of the output to stdout. */
+
+static void writeHeader(void)
+{
+   Buffer_T oHeader;
+
+   if (! iBinary)
+   {
+      printf("%% ");
+      return;
+   }
+   oHeader = Buffer_new(0);
+   if (oHeader == NULL || ! Dump_appendHeader(oHeader))
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   fwrite(Buffer_getData(oHeader), 1, Buffer_getLength(oHeader),
+          stdout);
+   Buffer_free(oHeader);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the end of the output to stdout. */
+
+static void writeTrailer(void)
+{
+   if (! iBinary)
+      printf("\n");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex the newline-terminated lines at pcBlock...pcBlock+uLength-1
+   using uThreads threads, and write the output in order.  psChunks
+   must have room for uThreads chunks. */
+
+static void lexBlock(char *pcBlock, size_t uLength,
+                     struct Chunk *psChunks, size_t uThreads)
+{
+   size_t u;
+   char *pcStart = pcBlock;
+   char *pcEnd;
+   char *pcLimit = pcBlock + uLength;
+   int iRet;
+
+   assert(pcBlock != NULL);
+   assert(uLength > 0 && pcBlock[uLength - 1] == '\n');
+   assert(psChunks != NULL);
+
+   /* Split the block near equal sizes, at line boundaries. */
+   for (u = 0; u < uThreads; u++)
+   {
+      pcEnd = pcBlock + uLength / uThreads * (u + 1);
+      if (pcEnd < pcStart)
+         pcEnd = pcStart;
+      if (u == uThreads - 1 || pcEnd >= pcLimit)
+         pcEnd = pcLimit;
+      else
+         pcEnd = (char*)memchr(pcEnd, '\n', (size_t)(pcLimit - pcEnd))
+            + 1;
+      psChunks[u].pcStart = pcStart;
+      psChunks[u].pcEnd = pcEnd;
+      Buffer_clear(psChunks[u].oOut);
+      Buffer_clear(psChunks[u].oErr);
+      iRet = pthread_create(&psChunks[u].sThread, NULL, lexChunk,
+                            &psChunks[u]);
+      if (iRet != 0)
+         {errno = iRet; perror(pcPgmName); exit(EXIT_FAILURE);}
+      pcStart = pcEnd;
+   }
+
+   for (u = 0; u < uThreads; u++)
+   {
+      pthread_join(psChunks[u].sThread, NULL);
+      fwrite(Buffer_getData(psChunks[u].oOut), 1,
+             Buffer_getLength(psChunks[u].oOut), stdout);
+      fwrite(Buffer_getData(psChunks[u].oErr), 1,
+             Buffer_getLength(psChunks[u].oErr), stderr);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex stdin using uThreads threads.  Write to stdout exactly what the
+   serial mode would write. */
+
+static void lexInParallel(size_t uThreads)
+{
+   /* The number of characters of stdin lexed at a time. */
+   enum {BLOCK_SIZE = 16 * 1024 * 1024};
+
+   char *pcBlock;
+   size_t uCapacity = BLOCK_SIZE;
+   size_t uLength = 0;
+   size_t uLinesEnd;
+   char *pcLastNewline;
+   int iEof = 0;
+   struct Chunk *psChunks;
+   size_t u;
+
+   assert(uThreads > 0);
+
+   pcBlock = (char*)malloc(uCapacity + 1);
+   psChunks = (struct Chunk*)calloc(uThreads, sizeof(struct Chunk));
+   if (pcBlock == NULL || psChunks == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   for (u = 0; u < uThreads; u++)
+   {
+      psChunks[u].oOut = Buffer_new(0);
+      psChunks[u].oErr = Buffer_new(0);
+      if (psChunks[u].oOut == NULL || psChunks[u].oErr == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+   }
+
+   writeHeader();
+   while (! iEof)
+   {
+      uLength += fread(pcBlock + uLength, 1, uCapacity - uLength, stdin);
+      if (ferror(stdin))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      iEof = feof(stdin);
+
+      if (iEof)
+      {
+         /* Terminate a final line that lacks a newline character. */
+         if (uLength > 0 && pcBlock[uLength - 1] != '\n')
+            pcBlock[uLength++] = '\n';
+         uLinesEnd = uLength;
+      }
+      else
+      {
+         pcLastNewline = (char*)memrchr(pcBlock, '\n', uLength);
+         if (pcLastNewline == NULL)
+         {
+            /* A single line fills the block, so enlarge it. */
+            uCapacity *= 2;
+            pcBlock = (char*)realloc(pcBlock, uCapacity + 1);
+            if (pcBlock == NULL)
+               {perror(pcPgmName); exit(EXIT_FAILURE);}
+            continue;
+         }
+         uLinesEnd = (size_t)(pcLastNewline - pcBlock) + 1;
+      }
+
+      if (uLinesEnd > 0)
+         lexBlock(pcBlock, uLinesEnd, psChunks, uThreads);
+
+      /* Keep the partial line that ends the block. */
+      memmove(pcBlock, pcBlock + uLinesEnd, uLength - uLinesEnd);
+      uLength -= uLinesEnd;
+   }
+
+   for (u = 0; u < uThreads; u++)
+   {
+      Buffer_free(psChunks[u].oOut);
+      Buffer_free(psChunks[u].oErr);
+   }
+   free(psChunks);
+   free(pcBlock);
+   writeTrailer();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex stdin one line at a time. */
+
+static void lexSerially(void)
 {
    char *pcLine;
    DynArray_T oTokens;
+   Buffer_T oOut;
+   Buffer_T oErr;
    int iRet;
 
-   pcPgmName = argv[0];
+   if (iBinary)
+   {
+      oOut = Buffer_new(0);
+      oErr = Buffer_new(0);
+      if (oOut == NULL || oErr == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      writeHeader();
+      while ((pcLine = LexAnalyzer_readLine(stdin)) != NULL)
+      {
+         lexLineInto(pcLine, oOut, oErr);
+         fwrite(Buffer_getData(oOut), 1, Buffer_getLength(oOut), stdout);
+         Buffer_clear(oOut);
+         free(pcLine);
+      }
+      Buffer_free(oOut);
+      Buffer_free(oErr);
+      return;
+   }
 
    printf("%% ");
    while ((pcLine = LexAnalyzer_readLine(stdin)) != NULL)
@@ -58,5 +394,48 @@ int main(int argc, char *argv[])
       printf("%% ");
    }
    printf("\n");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex the lines of stdin.  With "-j N", split stdin into chunks of
+   whole lines that N threads lex at the same time.  With "-b", write
+   a binary dump (see dump.h) instead of text.  With "-u", reject lines
+   that are not well-formed UTF-8. */
+
+int main(int argc, char *argv[])
+{
+   long lThreads = 0;
+   char *pcEnd;
+   int i;
+   int iUsageError = 0;
+
+   pcPgmName = argv[0];
+
+   for (i = 1; i < argc && ! iUsageError; i++)
+   {
+      if (strcmp(argv[i], "-b") == 0)
+         iBinary = 1;
+      else if (strcmp(argv[i], "-u") == 0)
+         LexAnalyzer_setValidateUtf8(1);
+      else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+      {
+         lThreads = strtol(argv[++i], &pcEnd, 10);
+         if (*pcEnd != '\0' || lThreads < 1)
+            iUsageError = 1;
+      }
+      else
+         iUsageError = 1;
+   }
+   if (iUsageError)
+   {
+      fprintf(stderr, "Usage: %s [-b] [-u] [-j threads]\n", pcPgmName);
+      exit(EXIT_FAILURE);
+   }
+
+   if (lThreads == 0)
+      lexSerially();
+   else
+      lexInParallel((size_t)lThreads);
    return 0;
 }
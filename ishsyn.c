@@ -6,8 +6,11 @@
 #include "lexAnalyzer.h"
 #include "synAnalyzer.h"
 #include "token.h"
+#include "buffer.h"
+#include "dump.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 /*--------------------------------------------------------------------*/
@@ -15,9 +18,15 @@
 /* The name of the executable binary file. */
 static const char *pcPgmName;
 
+/* 1 (TRUE) iff the output is a binary dump rather than text. */
+static int iBinary = 0;
+
+/* The output of the current line, if the output is binary. */
+static Buffer_T oOut = NULL;
+
 /*--------------------------------------------------------------------*/
 
-/* Return the value of the global variable pcPgmName, which means the 
+/* Return the value of the global variable pcPgmName, which means the
    name of the program. */
 
 const char* getPgmName()
@@ -29,54 +38,234 @@ const char* getPgmName()
 
 /*--------------------------------------------------------------------*/
 
-int main(int argc, char* argv[])
+/* Write the binary output of the current line to stdout. */
+
+static void flushOut(void)
+{
+   assert(oOut != NULL);
+
+   fwrite(Buffer_getData(oOut), 1, Buffer_getLength(oOut), stdout);
+   Buffer_clear(oOut);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the line pcLine to stdout. */
+
+static void writeLine(const char *pcLine)
 {
-   char* pcLine;
    int iRet;
+
+   assert(pcLine != NULL);
+
+   if (iBinary)
+   {
+      if (! Dump_appendString(oOut, DUMP_LINE, pcLine))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      return;
+   }
+
+   /* Write the line to stdout. */
+   printf("%s\n", pcLine);
+
+   /* Flush the stdout buffer. */
+   iRet = fflush(stdout);
+   if (iRet == EOF)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the lexical or syntactic error pcError. */
+
+static void writeError(const char *pcError)
+{
+   assert(pcError != NULL);
+
+   if (iBinary)
+   {
+      if (! Dump_appendString(oOut, DUMP_ERROR, pcError))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+   }
+   else
+      fprintf(stderr, "%s: %s\n", pcPgmName, pcError);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Syntactically analyze oTokens and write the resulting commands, if
+   any. */
+
+static void writeCommand(DynArray_T oTokens)
+{
+   Command_T oCommand;
+   Command_T oNext;
+   const char *pcError;
+
+   assert(oTokens != NULL);
+
+   oCommand = SynAnalyzer_synTokensQuietly(oTokens, &pcError);
+   if (pcError != NULL)
+      writeError(pcError);
+
+   /* Print each command of the list and free the list. */
+   for (oNext = oCommand; oNext != NULL; oNext = Command_getNext(oNext))
+   {
+      if (! iBinary)
+         Command_print(oNext);
+      else if (! Dump_appendCommand(oOut, oNext))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+   }
+   Command_free(oCommand);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Analyze the lines of stdin, which is text. */
+
+static void synLines(void)
+{
+   char* pcLine;
+   const char* pcError;
    DynArray_T oTokens = NULL;
-   Command_T oCommand = NULL;
-   
-   pcPgmName = argv[0];
-   
-   /* Write to stdout a prompt. */
-   printf("%% ");
 
    /* Read a line from stdin. */
    while ((pcLine = LexAnalyzer_readLine(stdin)) != NULL)
    {
-      /* Write the line to stdout. */
-      printf("%s\n", pcLine);
-      
-      /* Flush the stdout buffer. */
-      iRet = fflush(stdout);
-      if (iRet == EOF)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
-      
+      writeLine(pcLine);
+
       /* Pass the line to lexical analyzer. */
-      oTokens = LexAnalyzer_lexLine(pcLine);
-      
+      oTokens = LexAnalyzer_lexLineQuietly(pcLine, &pcError);
+
       /* Pass the DynArray object to syntactic analyzer. */
-      if (oTokens != NULL)
-         oCommand = SynAnalyzer_synTokens(oTokens);
-      else oCommand = NULL;
-      
-      /* Print command and free command. */
-      if (oCommand != NULL)
-      {
-         Command_print(oCommand);
-         Command_free(oCommand);
-      }
-      
-      /* Free up memory. */
       if (oTokens != NULL)
       {
+         writeCommand(oTokens);
          LexAnalyzer_freeTokens(oTokens);
          DynArray_free(oTokens);
       }
+      else writeError(pcError);
       free(pcLine);
-      
-      printf("%% ");
+
+      if (iBinary) flushOut();
+      else printf("%% ");
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Analyze the token dump (see dump.h) that ishlex -b wrote to
+   stdin. */
+
+static void synDump(void)
+{
+   DumpReader_T oDumpReader;
+   struct DumpRecord sRecord;
+   struct DumpField sField;
+   DynArray_T oTokens;
+   int iLines = 0;
+
+   oDumpReader = DumpReader_new(0);
+   if (oDumpReader == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   while (DumpReader_next(oDumpReader, &sRecord))
+   {
+      switch (sRecord.eKind)
+      {
+         case DUMP_LINE:
+            /* The prompt that follows the previous line. */
+            if (iBinary) flushOut();
+            else if (iLines > 0) printf("%% ");
+            iLines++;
+            DumpRecord_nextField(&sRecord, &sField);
+            writeLine(sField.pcValue);
+            break;
+
+         case DUMP_ERROR:
+            DumpRecord_nextField(&sRecord, &sField);
+            writeError(sField.pcValue);
+            break;
+
+         case DUMP_TOKENS:
+            oTokens = DynArray_new(0);
+            if (oTokens == NULL)
+               {perror(pcPgmName); exit(EXIT_FAILURE);}
+            while (DumpRecord_nextField(&sRecord, &sField))
+            {
+               if (sField.iTag != TOKEN_ORDINARY &&
+                   sField.iTag != TOKEN_SPECIAL)
+               {
+                  fprintf(stderr, "%s: not a token dump\n", pcPgmName);
+                  exit(EXIT_FAILURE);
+               }
+               if (! DynArray_add(oTokens,
+                                  Token_new((enum TokenType)sField.iTag,
+                                            (char*)sField.pcValue)))
+                  {perror(pcPgmName); exit(EXIT_FAILURE);}
+            }
+            writeCommand(oTokens);
+            LexAnalyzer_freeTokens(oTokens);
+            DynArray_free(oTokens);
+            break;
+
+         default:
+            fprintf(stderr, "%s: not a token dump\n", pcPgmName);
+            exit(EXIT_FAILURE);
+      }
+   }
+   if (iBinary) flushOut();
+   else if (iLines > 0) printf("%% ");
+
+   DumpReader_free(oDumpReader);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Syntactically analyze the lines of stdin.  With "-t", read the token
+   dump that "ishlex -b" writes instead of text.  With "-b", write a
+   binary dump (see dump.h) instead of text.  With "-u", reject lines
+   that are not well-formed UTF-8. */
+
+int main(int argc, char* argv[])
+{
+   int i;
+   int iTokenInput = 0;
+
+   pcPgmName = argv[0];
+
+   for (i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "-b") == 0)
+         iBinary = 1;
+      else if (strcmp(argv[i], "-u") == 0)
+         LexAnalyzer_setValidateUtf8(1);
+      else if (strcmp(argv[i], "-t") == 0)
+         iTokenInput = 1;
+      else
+      {
+         fprintf(stderr, "Usage: %s [-b] [-t] [-u]\n", pcPgmName);
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   /* Write to stdout a prompt, or the start of a dump. */
+   if (iBinary)
+   {
+      oOut = Buffer_new(0);
+      if (oOut == NULL || ! Dump_appendHeader(oOut))
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+   }
+   else printf("%% ");
+
+   if (iTokenInput) synDump();
+   else synLines();
+
+   if (iBinary)
+   {
+      flushOut();
+      Buffer_free(oOut);
    }
-   printf("\n");
+   else printf("\n");
    return 0;
 }
@@ -0,0 +1,1039 @@
+/*--------------------------------------------------------------------*/
+/* launch.c                                                           */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE /* For sched_setaffinity and the CPU_ macros. */
+
+#include "launch.h"
+#include "signals.h"
+#include "ish.h"
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The resource limits that commands can set, by name.  The limits on
+   processor time are enforced with SIGXCPU at the soft limit and
+   SIGKILL a second later at the hard limit. */
+
+static const struct LimitName
+{
+   const char *pcName;
+   int iResource;
+} asLimitNames[] =
+{
+   {"as", RLIMIT_AS}, {"cpu", RLIMIT_CPU}, {"nofile", RLIMIT_NOFILE},
+   {"nproc", RLIMIT_NPROC}
+};
+
+enum {LIMIT_COUNT = sizeof(asLimitNames) / sizeof(asLimitNames[0])};
+
+/* A set of resource limits, indexed like asLimitNames. */
+
+struct Limits
+{
+   /* 1 (TRUE) iff the limit is set. */
+   int aiSet[LIMIT_COUNT];
+
+   /* The values of the limits that are set. */
+   rlim_t auValues[LIMIT_COUNT];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The I/O scheduling classes, by name and in the order of their
+   numbers, which start at 1, and the number of levels within each. */
+
+static const char *apcIoClasses[] = {"rt", "be", "idle"};
+
+enum {IO_CLASS_COUNT = sizeof(apcIoClasses) / sizeof(apcIoClasses[0]),
+      IO_LEVELS = 8, IO_CLASS_SHIFT = 13, IOPRIO_WHO_PROCESS = 1};
+
+/* Where and how a command is scheduled. */
+
+struct Placement
+{
+   /* 1 (TRUE) iff the CPUs are set, and 1 (TRUE) iff each command
+      gets the next CPU of the shell's own in turn. */
+   int iCpusSet;
+   int iCpusAuto;
+
+   /* The CPUs on which the command may run. */
+   cpu_set_t sCpus;
+
+   /* 1 (TRUE) iff the nice value is set, and the nice value. */
+   int iNiceSet;
+   int iNice;
+
+   /* 1 (TRUE) iff the I/O priority is set, and the I/O priority as
+      ioprio_set expects it. */
+   int iIoprioSet;
+   int iIoprio;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The limits that apply to every command. */
+
+static struct Limits sDefaultLimits;
+
+/* The placement that applies to every command. */
+
+static struct Placement sDefaultPlacement;
+
+/* The index, among the shell's own CPUs, of the CPU that the next
+   command placed automatically runs on. */
+
+static int iNextCpu = 0;
+
+/*--------------------------------------------------------------------*/
+
+/* A Launch consists of a command, the arguments that remain once the
+   prefix commands are removed, and the limits that they set. */
+
+struct Launch
+{
+   /* The command, which supplies the redirections. */
+   Command_T oCommand;
+
+   /* The argument vector of the command to execute, which is the
+      tail of the argument vector of oCommand. */
+   char **ppcArgv;
+
+   /* See Launch_getTimeout and Launch_getKillAfter. */
+   double dTimeout;
+   double dKillAfter;
+
+   /* The resource limits of the command. */
+   struct Limits sLimits;
+
+   /* The placement of the command. */
+   struct Placement sPlacement;
+
+   /* The uAssignments "NAME=VALUE" arguments that set environment
+      variables for the command. */
+   char **ppcAssignments;
+   size_t uAssignments;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Assign to *pdSeconds the duration that pcDuration denotes.  Return
+   1 (TRUE) if successful, or 0 (FALSE) if pcDuration is not a valid
+   duration. */
+
+static int Launch_parseDuration(const char *pcDuration,
+                                double *pdSeconds)
+{
+   char *pcEnd;
+   double dValue;
+
+   dValue = strtod(pcDuration, &pcEnd);
+   if (pcEnd == pcDuration || ! isfinite(dValue) || dValue < 0)
+      return 0;
+
+   switch (*pcEnd)
+   {
+      case '\0': case 's': break;
+      case 'm': dValue *= 60; break;
+      case 'h': dValue *= 60 * 60; break;
+      case 'd': dValue *= 24 * 60 * 60; break;
+      default: return 0;
+   }
+   if (*pcEnd != '\0' && pcEnd[1] != '\0')
+      return 0;
+
+   *pdSeconds = dValue;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Parse the timeout prefix command whose arguments start at
+   *pppcArgv into psLaunch, and advance *pppcArgv past it.  Return NULL
+   if successful, or a description of the error otherwise. */
+
+static const char *Launch_parseTimeout(struct Launch *psLaunch,
+                                       char ***pppcArgv)
+{
+   char **ppcArgv = *pppcArgv;
+
+   if (*ppcArgv == NULL ||
+       ! Launch_parseDuration(*ppcArgv, &psLaunch->dTimeout))
+      return "timeout: invalid duration";
+   ppcArgv++;
+
+   if (*ppcArgv != NULL && strcmp(*ppcArgv, "--kill-after") == 0)
+   {
+      ppcArgv++;
+      if (*ppcArgv == NULL ||
+          ! Launch_parseDuration(*ppcArgv, &psLaunch->dKillAfter))
+         return "timeout: invalid duration";
+      ppcArgv++;
+   }
+
+   if (*ppcArgv == NULL)
+      return "timeout: missing command";
+   *pppcArgv = ppcArgv;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the highest value to which a command may set the resource
+   limit iResource: the hard limit of the shell, which only a
+   privileged process may raise, and, for open files, the most that
+   the kernel allows. */
+
+static rlim_t Launch_getMaxLimit(int iResource)
+{
+   struct rlimit sLimit;
+   rlim_t uMax = RLIM_INFINITY;
+   unsigned long long ullOpen;
+   FILE *psFile;
+
+   if (geteuid() != 0 && getrlimit(iResource, &sLimit) == 0)
+      uMax = sLimit.rlim_max;
+
+   if (iResource == RLIMIT_NOFILE)
+   {
+      psFile = fopen("/proc/sys/fs/nr_open", "r");
+      if (psFile != NULL)
+      {
+         if (fscanf(psFile, "%llu", &ullOpen) == 1 &&
+             (rlim_t)ullOpen < uMax)
+            uMax = (rlim_t)ullOpen;
+         fclose(psFile);
+      }
+   }
+   return uMax;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the setting pcSetting, of the form NAME=VALUE, to *psLimits.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if pcSetting is not a
+   valid setting or sets a limit above Launch_getMaxLimit. */
+
+static int Launch_parseLimit(const char *pcSetting,
+                             struct Limits *psLimits)
+{
+   const char *pcValue;
+   char *pcEnd;
+   unsigned long long ullValue;
+   int iShift = 0;
+   size_t u;
+
+   pcValue = strchr(pcSetting, '=');
+   if (pcValue == NULL)
+      return 0;
+   for (u = 0; u < LIMIT_COUNT; u++)
+      if (strncmp(pcSetting, asLimitNames[u].pcName,
+                  (size_t)(pcValue - pcSetting)) == 0 &&
+          asLimitNames[u].pcName[pcValue - pcSetting] == '\0')
+         break;
+   if (u == LIMIT_COUNT)
+      return 0;
+   pcValue++;
+
+   if (strcmp(pcValue, "unlimited") == 0)
+   {
+      if (Launch_getMaxLimit(asLimitNames[u].iResource) !=
+          RLIM_INFINITY)
+         return 0;
+      psLimits->aiSet[u] = 1;
+      psLimits->auValues[u] = RLIM_INFINITY;
+      return 1;
+   }
+
+   if (*pcValue < '0' || *pcValue > '9')
+      return 0;
+   ullValue = strtoull(pcValue, &pcEnd, 10);
+   switch (*pcEnd)
+   {
+      case '\0': break;
+      case 'K': iShift = 10; break;
+      case 'M': iShift = 20; break;
+      case 'G': iShift = 30; break;
+      case 'T': iShift = 40; break;
+      default: return 0;
+   }
+   if ((*pcEnd != '\0' && pcEnd[1] != '\0') ||
+       ullValue > ((rlim_t)RLIM_INFINITY - 1) >> iShift ||
+       (rlim_t)ullValue << iShift >
+       Launch_getMaxLimit(asLimitNames[u].iResource))
+      return 0;
+
+   psLimits->aiSet[u] = 1;
+   psLimits->auValues[u] = (rlim_t)ullValue << iShift;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Parse the limit prefix command whose arguments start at *pppcArgv
+   into psLaunch, and advance *pppcArgv past it.  Return NULL if
+   successful, or a description of the error otherwise. */
+
+static const char *Launch_parseLimits(struct Launch *psLaunch,
+                                      char ***pppcArgv)
+{
+   char **ppcArgv = *pppcArgv;
+
+   if (*ppcArgv == NULL || strchr(*ppcArgv, '=') == NULL)
+      return "limit: missing limit";
+   while (*ppcArgv != NULL && strchr(*ppcArgv, '=') != NULL)
+   {
+      if (! Launch_parseLimit(*ppcArgv, &psLaunch->sLimits))
+         return "limit: invalid limit";
+      ppcArgv++;
+   }
+
+   if (*ppcArgv == NULL)
+      return "limit: missing command";
+   *pppcArgv = ppcArgv;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Assign to *psCpus the CPUs that pcCpus lists, as comma-separated
+   numbers and ranges such as 0-3,6.  Return 1 (TRUE) if successful,
+   or 0 (FALSE) if pcCpus is not a valid list. */
+
+static int Launch_parseCpus(const char *pcCpus, cpu_set_t *psCpus)
+{
+   char *pcEnd;
+   unsigned long ulFirst, ulLast, ul;
+
+   CPU_ZERO(psCpus);
+   for (;;)
+   {
+      if (*pcCpus < '0' || *pcCpus > '9')
+         return 0;
+      ulFirst = ulLast = strtoul(pcCpus, &pcEnd, 10);
+      if (*pcEnd == '-')
+      {
+         pcCpus = pcEnd + 1;
+         if (*pcCpus < '0' || *pcCpus > '9')
+            return 0;
+         ulLast = strtoul(pcCpus, &pcEnd, 10);
+      }
+      if (ulFirst > ulLast || ulLast >= CPU_SETSIZE)
+         return 0;
+      for (ul = ulFirst; ul <= ulLast; ul++)
+         CPU_SET(ul, psCpus);
+
+      if (*pcEnd == '\0')
+         return 1;
+      if (*pcEnd != ',')
+         return 0;
+      pcCpus = pcEnd + 1;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the shell may run on every CPU in *psCpus, or
+   0 (FALSE) otherwise. */
+
+static int Launch_isOwnCpus(const cpu_set_t *psCpus)
+{
+   cpu_set_t sOwnCpus;
+   cpu_set_t sBoth;
+
+   /* Leave the check to the command if the CPUs are unknown. */
+   if (sched_getaffinity(0, sizeof(sOwnCpus), &sOwnCpus) == -1)
+      return 1;
+   CPU_AND(&sBoth, psCpus, &sOwnCpus);
+   return CPU_EQUAL(&sBoth, psCpus);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if a command may be given the nice value iNice, or
+   0 (FALSE) otherwise.  Raising the nice value is always allowed, and
+   lowering it below the shell's own requires privilege or a high
+   enough RLIMIT_NICE. */
+
+static int Launch_isAllowedNice(int iNice)
+{
+   struct rlimit sLimit;
+   int iOwnNice;
+
+   if (geteuid() == 0)
+      return 1;
+   errno = 0;
+   iOwnNice = getpriority(PRIO_PROCESS, 0);
+   if (errno != 0 || iNice >= iOwnNice)
+      return 1;
+   return getrlimit(RLIMIT_NICE, &sLimit) == 0 &&
+      (sLimit.rlim_cur == RLIM_INFINITY ||
+       (rlim_t)(20 - iNice) <= sLimit.rlim_cur);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the setting pcSetting, of the form NAME=VALUE, to
+   *psPlacement.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   pcSetting is not a valid setting or is one that the shell could not
+   apply: CPUs on which the shell may not run, a nice value below the
+   shell's own without the right to it, or the rt I/O class without
+   privilege. */
+
+static int Launch_parsePlacement(const char *pcSetting,
+                                 struct Placement *psPlacement)
+{
+   char *pcEnd;
+   long lValue;
+   size_t u;
+
+   if (strncmp(pcSetting, "cpus=", 5) == 0)
+   {
+      pcSetting += 5;
+      psPlacement->iCpusAuto = (strcmp(pcSetting, "auto") == 0);
+      if (! psPlacement->iCpusAuto &&
+          (! Launch_parseCpus(pcSetting, &psPlacement->sCpus) ||
+           ! Launch_isOwnCpus(&psPlacement->sCpus)))
+         return 0;
+      psPlacement->iCpusSet = 1;
+      return 1;
+   }
+
+   if (strncmp(pcSetting, "nice=", 5) == 0)
+   {
+      pcSetting += 5;
+      lValue = strtol(pcSetting, &pcEnd, 10);
+      if (pcEnd == pcSetting || *pcEnd != '\0' ||
+          lValue < -20 || lValue > 19 ||
+          ! Launch_isAllowedNice((int)lValue))
+         return 0;
+      psPlacement->iNiceSet = 1;
+      psPlacement->iNice = (int)lValue;
+      return 1;
+   }
+
+   if (strncmp(pcSetting, "ioprio=", 7) == 0)
+   {
+      /* The value is CLASS or CLASS/LEVEL, such as be/4. */
+      pcSetting += 7;
+      for (u = 0; u < IO_CLASS_COUNT; u++)
+         if (strncmp(pcSetting, apcIoClasses[u],
+                     strlen(apcIoClasses[u])) == 0)
+            break;
+      if (u == IO_CLASS_COUNT || (u == 0 && geteuid() != 0))
+         return 0;
+      pcSetting += strlen(apcIoClasses[u]);
+      lValue = 0;
+      if (*pcSetting == '/')
+      {
+         lValue = strtol(pcSetting + 1, &pcEnd, 10);
+         if (pcEnd == pcSetting + 1 || lValue < 0 ||
+             lValue >= IO_LEVELS)
+            return 0;
+         pcSetting = pcEnd;
+      }
+      if (*pcSetting != '\0')
+         return 0;
+      psPlacement->iIoprioSet = 1;
+      psPlacement->iIoprio =
+         (int)((u + 1) << IO_CLASS_SHIFT) | (int)lValue;
+      return 1;
+   }
+
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Parse the sched prefix command whose arguments start at *pppcArgv
+   into psLaunch, and advance *pppcArgv past it.  Return NULL if
+   successful, or a description of the error otherwise. */
+
+static const char *Launch_parseSched(struct Launch *psLaunch,
+                                     char ***pppcArgv)
+{
+   char **ppcArgv = *pppcArgv;
+
+   if (*ppcArgv == NULL || strchr(*ppcArgv, '=') == NULL)
+      return "sched: missing setting";
+   while (*ppcArgv != NULL && strchr(*ppcArgv, '=') != NULL)
+   {
+      if (! Launch_parsePlacement(*ppcArgv, &psLaunch->sPlacement))
+         return "sched: invalid setting";
+      ppcArgv++;
+   }
+
+   if (*ppcArgv == NULL)
+      return "sched: missing command";
+   *pppcArgv = ppcArgv;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if pcArg is an assignment of the form NAME=VALUE,
+   or 0 (FALSE) otherwise. */
+
+static int Launch_isAssignment(const char *pcArg)
+{
+   if (! isalpha((unsigned char)*pcArg) && *pcArg != '_')
+      return 0;
+   for (pcArg++; *pcArg != '='; pcArg++)
+      if (! isalnum((unsigned char)*pcArg) && *pcArg != '_')
+         return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+Launch_T Launch_new(Command_T oCommand, char **ppcArgv,
+                    const char **ppcError)
+{
+   Launch_T oLaunch;
+   const char *pcError = NULL;
+   size_t uArgs;
+
+   assert(oCommand != NULL);
+   assert(ppcArgv != NULL);
+   assert(ppcError != NULL);
+
+   oLaunch = (struct Launch*)malloc(sizeof(struct Launch));
+   if (oLaunch == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   /* Make room for every argument to be an assignment. */
+   for (uArgs = 0; ppcArgv[uArgs] != NULL; uArgs++)
+      ;
+   oLaunch->ppcAssignments = (char**)malloc(sizeof(char*) * uArgs);
+   if (oLaunch->ppcAssignments == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   oLaunch->uAssignments = 0;
+
+   oLaunch->oCommand = oCommand;
+   oLaunch->dTimeout = 0;
+   oLaunch->dKillAfter = 0;
+   oLaunch->sLimits = sDefaultLimits;
+   oLaunch->sPlacement = sDefaultPlacement;
+
+   /* Strip the prefix commands, each of which precedes the command
+      that it applies to. */
+   while (pcError == NULL)
+   {
+      if (strcmp(ppcArgv[0], "timeout") == 0)
+      {
+         ppcArgv++;
+         pcError = Launch_parseTimeout(oLaunch, &ppcArgv);
+      }
+      else if (strcmp(ppcArgv[0], "limit") == 0)
+      {
+         ppcArgv++;
+         pcError = Launch_parseLimits(oLaunch, &ppcArgv);
+      }
+      else if (strcmp(ppcArgv[0], "sched") == 0)
+      {
+         ppcArgv++;
+         pcError = Launch_parseSched(oLaunch, &ppcArgv);
+      }
+      else if (Launch_isAssignment(ppcArgv[0]))
+      {
+         oLaunch->ppcAssignments[oLaunch->uAssignments++] = *ppcArgv;
+         ppcArgv++;
+         if (*ppcArgv == NULL)
+            pcError = "missing command";
+      }
+      else
+         break;
+   }
+   if (pcError != NULL)
+   {
+      *ppcError = pcError;
+      free(oLaunch->ppcAssignments);
+      free(oLaunch);
+      return NULL;
+   }
+
+   oLaunch->ppcArgv = ppcArgv;
+   *ppcError = NULL;
+   return oLaunch;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Launch_free(Launch_T oLaunch)
+{
+   assert(oLaunch != NULL);
+
+   free(oLaunch->ppcAssignments);
+   free(oLaunch);
+}
+
+/*--------------------------------------------------------------------*/
+
+double Launch_getTimeout(Launch_T oLaunch)
+{
+   assert(oLaunch != NULL);
+
+   return oLaunch->dTimeout;
+}
+
+/*--------------------------------------------------------------------*/
+
+double Launch_getKillAfter(Launch_T oLaunch)
+{
+   assert(oLaunch != NULL);
+
+   return oLaunch->dKillAfter;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *Launch_getLimitHit(Launch_T oLaunch, int iWaitStatus,
+                               const struct rusage *psUsage)
+{
+   struct Limits *psLimits;
+   size_t u;
+
+   assert(oLaunch != NULL);
+   assert(psUsage != NULL);
+
+   if (! WIFSIGNALED(iWaitStatus))
+      return NULL;
+   psLimits = &oLaunch->sLimits;
+
+   for (u = 0; u < LIMIT_COUNT; u++)
+   {
+      if (! psLimits->aiSet[u] ||
+          psLimits->auValues[u] == RLIM_INFINITY)
+         continue;
+      switch (asLimitNames[u].iResource)
+      {
+         /* Running out of processor time raises SIGXCPU, and then
+            SIGKILL. */
+         case RLIMIT_CPU:
+            if (WTERMSIG(iWaitStatus) == SIGXCPU ||
+                (WTERMSIG(iWaitStatus) == SIGKILL &&
+                 (rlim_t)(psUsage->ru_utime.tv_sec +
+                          psUsage->ru_stime.tv_sec) >=
+                 psLimits->auValues[u]))
+               return asLimitNames[u].pcName;
+            break;
+
+         /* Running out of address space makes allocations fail, which
+            programs commonly answer by crashing or aborting. */
+         case RLIMIT_AS:
+            if (WTERMSIG(iWaitStatus) == SIGSEGV ||
+                WTERMSIG(iWaitStatus) == SIGBUS ||
+                WTERMSIG(iWaitStatus) == SIGABRT)
+               return asLimitNames[u].pcName;
+            break;
+
+         default:
+            break;
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Launch_setLimits(char **ppcSettings)
+{
+   struct Limits sLimits = sDefaultLimits;
+
+   assert(ppcSettings != NULL);
+
+   for (; *ppcSettings != NULL; ppcSettings++)
+      if (! Launch_parseLimit(*ppcSettings, &sLimits))
+         return 0;
+   sDefaultLimits = sLimits;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Launch_printLimits(void)
+{
+   struct rlimit sLimit;
+   rlim_t uValue;
+   size_t u;
+
+   for (u = 0; u < LIMIT_COUNT; u++)
+   {
+      /* Commands inherit the limits that the shell does not set. */
+      if (sDefaultLimits.aiSet[u])
+         uValue = sDefaultLimits.auValues[u];
+      else if (getrlimit(asLimitNames[u].iResource, &sLimit) == 0)
+         uValue = sLimit.rlim_cur;
+      else
+         uValue = RLIM_INFINITY;
+
+      if (uValue == RLIM_INFINITY)
+         printf("%s=unlimited\n", asLimitNames[u].pcName);
+      else
+         printf("%s=%llu\n", asLimitNames[u].pcName,
+                (unsigned long long)uValue);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+int Launch_setPlacement(char **ppcSettings)
+{
+   struct Placement sPlacement = sDefaultPlacement;
+
+   assert(ppcSettings != NULL);
+
+   for (; *ppcSettings != NULL; ppcSettings++)
+      if (! Launch_parsePlacement(*ppcSettings, &sPlacement))
+         return 0;
+   sDefaultPlacement = sPlacement;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the CPUs in *psCpus as a list of ranges. */
+
+static void Launch_printCpus(const cpu_set_t *psCpus)
+{
+   const char *pcSeparator = "";
+   int iFirst, iLast;
+
+   for (iFirst = 0; iFirst < CPU_SETSIZE; iFirst = iLast + 1)
+   {
+      if (! CPU_ISSET(iFirst, psCpus))
+      {
+         iLast = iFirst;
+         continue;
+      }
+      for (iLast = iFirst; iLast + 1 < CPU_SETSIZE &&
+              CPU_ISSET(iLast + 1, psCpus); iLast++)
+         ;
+      if (iLast == iFirst) printf("%s%d", pcSeparator, iFirst);
+      else printf("%s%d-%d", pcSeparator, iFirst, iLast);
+      pcSeparator = ",";
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void Launch_printPlacement(void)
+{
+   const struct Placement *psPlacement = &sDefaultPlacement;
+
+   printf("cpus=");
+   if (! psPlacement->iCpusSet) printf("inherited");
+   else if (psPlacement->iCpusAuto) printf("auto");
+   else Launch_printCpus(&psPlacement->sCpus);
+   printf("\n");
+
+   if (psPlacement->iNiceSet)
+      printf("nice=%d\n", psPlacement->iNice);
+   else printf("nice=inherited\n");
+
+   if (psPlacement->iIoprioSet)
+      printf("ioprio=%s/%d\n",
+             apcIoClasses[(psPlacement->iIoprio >> IO_CLASS_SHIFT) - 1],
+             psPlacement->iIoprio & ((1 << IO_CLASS_SHIFT) - 1));
+   else printf("ioprio=inherited\n");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If *psPlacement places commands automatically, then replace that
+   with the next of the CPUs on which the shell may run, in turn. */
+
+static void Launch_placeNext(struct Placement *psPlacement)
+{
+   cpu_set_t sOwnCpus;
+   int iCount;
+   int iIndex;
+   int i;
+
+   if (! psPlacement->iCpusSet || ! psPlacement->iCpusAuto)
+      return;
+   psPlacement->iCpusAuto = 0;
+   if (sched_getaffinity(0, sizeof(sOwnCpus), &sOwnCpus) == -1 ||
+       (iCount = CPU_COUNT(&sOwnCpus)) == 0)
+   {
+      /* Leave the command where the shell is. */
+      psPlacement->iCpusSet = 0;
+      return;
+   }
+
+   iIndex = iNextCpu++ % iCount;
+   if (iNextCpu == INT_MAX) iNextCpu = 0;
+   for (i = 0; i < CPU_SETSIZE; i++)
+      if (CPU_ISSET(i, &sOwnCpus) && iIndex-- == 0)
+         break;
+   CPU_ZERO(&psPlacement->sCpus);
+   CPU_SET(i, &psPlacement->sCpus);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Schedule the calling process as *psPlacement requires. */
+
+static void Launch_applyPlacement(const struct Placement *psPlacement)
+{
+   const char *pcSetting = NULL;
+
+   if (psPlacement->iCpusSet &&
+       sched_setaffinity(0, sizeof(psPlacement->sCpus),
+                         &psPlacement->sCpus) == -1)
+      pcSetting = "cpus";
+   else if (psPlacement->iNiceSet &&
+            setpriority(PRIO_PROCESS, 0, psPlacement->iNice) == -1)
+      pcSetting = "nice";
+   else if (psPlacement->iIoprioSet &&
+            syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                    psPlacement->iIoprio) == -1)
+      pcSetting = "ioprio";
+   if (pcSetting != NULL)
+   {
+      fprintf(stderr, "%s: sched %s: %s\n", getPgmName(), pcSetting,
+              strerror(errno));
+      exit(EXIT_FAILURE);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the resource limits of the calling process to *psLimits. */
+
+static void Launch_applyLimits(const struct Limits *psLimits)
+{
+   struct rlimit sLimit;
+   size_t u;
+
+   for (u = 0; u < LIMIT_COUNT; u++)
+   {
+      if (! psLimits->aiSet[u])
+         continue;
+      sLimit.rlim_cur = psLimits->auValues[u];
+      sLimit.rlim_max = psLimits->auValues[u];
+
+      /* Leave a second between SIGXCPU and SIGKILL, if the hard
+         limit allows it. */
+      if (asLimitNames[u].iResource == RLIMIT_CPU &&
+          sLimit.rlim_max != RLIM_INFINITY &&
+          sLimit.rlim_max < Launch_getMaxLimit(RLIMIT_CPU))
+         sLimit.rlim_max++;
+      if (setrlimit(asLimitNames[u].iResource, &sLimit) == -1)
+      {
+         fprintf(stderr, "%s: limit %s: %s\n", getPgmName(),
+                 asLimitNames[u].pcName, strerror(errno));
+         exit(EXIT_FAILURE);
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Redirect the standard input and output of the calling process as
+   oCommand requires. */
+
+static void Launch_redirect(Command_T oCommand)
+{
+   /* The permissions of the newly-created file. */
+   enum {PERMISSIONS = 0600};
+   int iFd; /* File descriptor. */
+   int iRet; /* Function return value. */
+   
+   /* Handle stdin-redirection. */
+   if (Command_getStdIn(oCommand) != NULL)
+   {
+      iFd = open(Command_getStdIn(oCommand), O_RDONLY);
+      if (iFd == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+      
+      iRet = close(0); /* Close stdin. */
+      if (iRet == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+      
+      iRet = dup(iFd);
+      if (iRet == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+      
+      iRet = close(iFd);
+      if (iRet == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+   }
+   
+   /* Handle stdout-redirection. */
+   if (Command_getStdOut(oCommand) != NULL)
+   {
+      iFd = creat(Command_getStdOut(oCommand), PERMISSIONS);
+      if (iFd == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+      iRet = close(1); /* Close stdout. */
+      if (iRet == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+      iRet = dup(iFd);
+      if (iRet == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+      iRet = close(iFd);
+      if (iRet == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the file pcFile with the argument vector ppcArgv and the
+   environment array ppcEnvp.  If the file is not in a format that the
+   system can execute, run it as a script of /bin/sh, passing pcFile
+   as its first argument, as execvp does.  Return only if the file
+   cannot be executed. */
+
+static void Launch_execFile(const char *pcFile, char **ppcArgv,
+                            char **ppcEnvp)
+{
+   char **ppcShArgv;
+   size_t uArgc;
+   int iErrno;
+
+   execve(pcFile, ppcArgv, ppcEnvp);
+   if (errno != ENOEXEC)
+      return;
+
+   for (uArgc = 0; ppcArgv[uArgc] != NULL; uArgc++)
+      ;
+   ppcShArgv = (char**)malloc(sizeof(char*) * (uArgc + 2));
+   if (ppcShArgv == NULL) {perror(getPgmName()); exit(EXIT_FAILURE);}
+   ppcShArgv[0] = (char*)"/bin/sh";
+   ppcShArgv[1] = (char*)pcFile;
+   memcpy(ppcShArgv + 2, ppcArgv + 1, sizeof(char*) * uArgc);
+   execve(ppcShArgv[0], ppcShArgv, ppcEnvp);
+
+   /* Report the failure of the file itself, not of the shell. */
+   iErrno = errno;
+   free(ppcShArgv);
+   errno = (iErrno == ENOENT) ? ENOEXEC : iErrno;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the command whose argument vector is ppcArgv with the
+   environment array ppcEnvp, searching for it in the colon-separated
+   directories pcPath, as execvp does.  Return only if the command
+   cannot be executed. */
+
+static void Launch_exec(char **ppcArgv, char **ppcEnvp,
+                        const char *pcPath)
+{
+   char acFile[PATH_MAX];
+   const char *pcEnd;
+   size_t uDirLength;
+   size_t uNameLength;
+   int iDenied = 0;
+
+   if (strchr(ppcArgv[0], '/') != NULL)
+   {
+      Launch_execFile(ppcArgv[0], ppcArgv, ppcEnvp);
+      return;
+   }
+
+   uNameLength = strlen(ppcArgv[0]);
+   for (;; pcPath = pcEnd + 1)
+   {
+      pcEnd = strchr(pcPath, ':');
+      if (pcEnd == NULL)
+         pcEnd = pcPath + strlen(pcPath);
+      uDirLength = (size_t)(pcEnd - pcPath);
+
+      /* An empty directory is the working directory. */
+      if (uDirLength + uNameLength + 2 <= sizeof(acFile))
+      {
+         if (uDirLength == 0)
+         {
+            acFile[0] = '.';
+            uDirLength = 1;
+         }
+         else
+            memcpy(acFile, pcPath, uDirLength);
+         acFile[uDirLength] = '/';
+         strcpy(acFile + uDirLength + 1, ppcArgv[0]);
+         Launch_execFile(acFile, ppcArgv, ppcEnvp);
+
+         /* Go on to the next directory only if the command is not in
+            this one. */
+         if (errno == EACCES)
+            iDenied = 1;
+         else if (errno != ENOENT && errno != ENOTDIR)
+            return;
+      }
+      if (*pcEnd == '\0')
+         break;
+   }
+   errno = iDenied ? EACCES : ENOENT;
+}
+
+/*--------------------------------------------------------------------*/
+
+pid_t Launch_start(Launch_T oLaunch, Env_T oEnv)
+{
+   /* The directories to search if PATH is not set. */
+   static const char acDefaultPath[] = "/bin:/usr/bin";
+   const char *pcPath = NULL;
+   char **ppcEnvp;
+   pid_t pid;
+   int iRet; /* Function return value. */
+   size_t u;
+
+   assert(oLaunch != NULL);
+   assert(oEnv != NULL);
+
+   /* Choose the CPU here, so that the turn passes on. */
+   Launch_placeNext(&oLaunch->sPlacement);
+
+   /* Build the environment here, so that the table keeps its cached
+      array.  The command's own PATH, if any, directs the search. */
+   if (oLaunch->uAssignments == 0)
+      ppcEnvp = Env_getEnvp(oEnv);
+   else
+      ppcEnvp = Env_getEnvpWith(oEnv, oLaunch->ppcAssignments,
+                                oLaunch->uAssignments);
+   for (u = oLaunch->uAssignments; u > 0 && pcPath == NULL; u--)
+      if (strncmp(oLaunch->ppcAssignments[u - 1], "PATH=", 5) == 0)
+         pcPath = oLaunch->ppcAssignments[u - 1] + 5;
+   if (pcPath == NULL && (pcPath = Env_get(oEnv, "PATH")) == NULL)
+      pcPath = acDefaultPath;
+
+   /* Flush buffer. */
+   iRet = fflush(NULL);
+   if (iRet == EOF) {perror(getPgmName()); exit(EXIT_FAILURE);}
+   
+   pid = fork();
+   if (pid == -1) {perror(getPgmName()); exit(EXIT_FAILURE);}
+   if (pid > 0)
+   {
+      if (oLaunch->uAssignments != 0)
+         free(ppcEnvp);
+      return pid;
+   }
+
+   /* Restore default actions for signals. */
+   Signals_resetInChild();
+
+   /* Set resource limits and scheduling. */
+   Launch_applyLimits(&oLaunch->sLimits);
+   Launch_applyPlacement(&oLaunch->sPlacement);
+   
+   /* Handle stdin and stdout file redirections. */
+   Launch_redirect(oLaunch->oCommand);
+
+   /* In child, execute the command. */
+   Launch_exec(oLaunch->ppcArgv, ppcEnvp, pcPath);
+   fprintf(stderr, "%s: No such file or directory\n", getPgmName());
+   exit(EXIT_FAILURE);
+}
@@ -0,0 +1,139 @@
+/*--------------------------------------------------------------------*/
+/* launch.h                                                           */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef LAUNCH_INCLUDED
+#define LAUNCH_INCLUDED
+
+#include "command.h"
+#include "env.h"
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/* A Launch_T object is an external command together with the prefix
+   commands that control how it runs.  The prefix commands are
+
+      timeout DURATION [--kill-after DURATION] command ...
+      limit NAME=VALUE ... command ...
+      sched NAME=VALUE ... command ...
+      NAME=VALUE command ...
+
+   Each DURATION is a number of seconds, optionally followed by s, m,
+   h or d for seconds, minutes, hours or days.  A DURATION of 0
+   disables the limit.
+
+   Each NAME=VALUE sets a resource limit of the command: as (bytes of
+   address space), cpu (seconds of processor time), nofile (open file
+   descriptors) or nproc (processes of the user).  A VALUE is a
+   number, optionally followed by K, M, G or T for units of 1024,
+   1024^2, 1024^3 or 1024^4, or "unlimited".  Unless the shell is
+   privileged, no VALUE may exceed the shell's own hard limit, and no
+   nofile VALUE may exceed what the kernel allows.  Limits that a
+   command does not set are those set by Launch_setLimits.
+
+   Each NAME=VALUE of sched sets where and how the command is
+   scheduled: cpus (the CPUs on which it may run, as a list such as
+   0-3,6, or "auto" for the next of the shell's CPUs in turn), nice
+   (its nice value, from -20 to 19) or ioprio (its I/O scheduling
+   class, rt, be or idle, optionally followed by / and a level from 0
+   to 7, such as be/4).  The CPUs must be ones on which the shell may
+   run, a nice value below the shell's own requires privilege or a
+   high enough RLIMIT_NICE, and the rt class requires privilege.
+   Settings that a command does not make are those made by
+   Launch_setPlacement.
+
+   Each NAME=VALUE that stands before a command, or before another
+   prefix command, in place of a prefix command sets the environment
+   variable NAME to VALUE for that command alone.  NAME consists of
+   letters, digits and underscores, and does not start with a
+   digit. */
+
+typedef struct Launch *Launch_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Launch_T object for oCommand, whose argument vector is
+   ppcArgv, as Command_getArgv returns it.  The object refers to
+   oCommand and ppcArgv until Launch_start returns.  If the prefix
+   commands are malformed, then assign a description of the error to
+   *ppcError and return NULL. */
+
+Launch_T Launch_new(Command_T oCommand, char **ppcArgv,
+                    const char **ppcError);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLaunch. */
+
+void Launch_free(Launch_T oLaunch);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds that the command of oLaunch may run
+   before it is sent SIGTERM, or 0 if there is no limit. */
+
+double Launch_getTimeout(Launch_T oLaunch);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds after SIGTERM that the command of
+   oLaunch is sent SIGKILL, or 0 if it is not. */
+
+double Launch_getKillAfter(Launch_T oLaunch);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of the resource limit that most likely made the
+   command of oLaunch end as it did, given the status iWaitStatus and
+   the resource usage *psUsage that wait4 reported for it, or NULL if
+   none did. */
+
+const char *Launch_getLimitHit(Launch_T oLaunch, int iWaitStatus,
+                               const struct rusage *psUsage);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the limit settings ppcSettings, each of the form NAME=VALUE
+   and the last followed by NULL, to every later command.  Return 1
+   (TRUE) if successful, or 0 (FALSE), changing no limit, if a setting
+   is malformed or exceeds what the shell may set. */
+
+int Launch_setLimits(char **ppcSettings);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the limits that apply to every command, including
+   those that commands inherit from the shell. */
+
+void Launch_printLimits(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the placement settings ppcSettings, each of the form
+   NAME=VALUE and the last followed by NULL, to every later command.
+   Return 1 (TRUE) if successful, or 0 (FALSE), changing nothing, if a
+   setting is malformed or cannot be applied. */
+
+int Launch_setPlacement(char **ppcSettings);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the placement settings that apply to every
+   command. */
+
+void Launch_printPlacement(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Flush all output streams, create a child process that sets the
+   resource limits and placement, redirects its standard input and
+   output as the command of oLaunch requires and executes the command
+   with the environment variables of oEnv, overridden by those that
+   the command sets, and return the process ID of the child.  The
+   command is searched for in the directories that the PATH variable
+   lists, unless its name contains a slash. */
+
+pid_t Launch_start(Launch_T oLaunch, Env_T oEnv);
+
+#endif
@@ -7,7 +7,9 @@
 #include "token.h"
 #include "ish.h"
 #include "lexAnalyzer.h"
-#include <ctype.h>
+#include "threadPool.h"
+#include "utf8.h"
+#include "wildcard.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,6 +17,74 @@
 
 /*--------------------------------------------------------------------*/
 
+/* The classes of characters that the DFA distinguishes. */
+
+enum {CHAR_SPACE = 1, CHAR_SPECIAL = 2};
+
+/* The class of each byte.  Unlike isspace, the table does not depend
+   on the locale and is defined for every byte, so the bytes of UTF-8
+   multibyte sequences are ordinary characters. */
+
+static const unsigned char aucCharClass[256] =
+{
+   [' '] = CHAR_SPACE, ['\t'] = CHAR_SPACE, ['\n'] = CHAR_SPACE,
+   ['\v'] = CHAR_SPACE, ['\f'] = CHAR_SPACE, ['\r'] = CHAR_SPACE,
+   ['<'] = CHAR_SPECIAL, ['>'] = CHAR_SPECIAL
+};
+
+/* Return nonzero iff character c is white space. */
+
+#define IS_SPACE(c) (aucCharClass[(unsigned char)(c)] & CHAR_SPACE)
+
+/* Return nonzero iff character c starts or continues a special
+   token. */
+
+#define IS_SPECIAL(c) (aucCharClass[(unsigned char)(c)] & CHAR_SPECIAL)
+
+/* Return nonzero iff character c starts, or continues, the name of a
+   variable. */
+
+#define IS_NAME_START(c) (((c) >= 'A' && (c) <= 'Z') || \
+                          ((c) >= 'a' && (c) <= 'z') || (c) == '_')
+#define IS_NAME(c) (IS_NAME_START(c) || ((c) >= '0' && (c) <= '9'))
+
+/* Return nonzero iff character c is a wildcard, or the backslash that
+   makes a character of a pattern match itself. */
+
+#define IS_GLOB(c) ((c) == '*' || (c) == '?' || (c) == '[' || \
+                    (c) == '\\')
+
+/*--------------------------------------------------------------------*/
+
+/* 1 (TRUE) iff lines must be well-formed UTF-8. */
+
+static int iValidateUtf8 = 0;
+
+/* The largest number of chunks into which a line is split, or 0 for
+   one per thread of the shared ThreadPool. */
+
+static size_t uMaxLineChunks = 0;
+
+/* The function that looks up the values of variables, or NULL if
+   variables are not expanded, and its extra argument. */
+
+static const char *(*pfLookUp)(const char *pcName, size_t uLength,
+                               void *pvExtra) = NULL;
+static void *pvLookUpExtra = NULL;
+
+/* The function that runs the commands of command substitutions, or
+   NULL if commands are not substituted, and its extra argument. */
+
+static char *(*pfSubstitute)(const char *pcCommand, size_t uLength,
+                             size_t *puLength, void *pvExtra) = NULL;
+static void *pvSubstituteExtra = NULL;
+
+/* 1 (TRUE) iff words with wildcards are expanded to paths. */
+
+static int iGlobbing = 0;
+
+/*--------------------------------------------------------------------*/
+
 /* If no lines remain in psFile, then return NULL. Otherwise read a line
    of psFile and return it as a string. The string does not contain a
    terminating newline character. The caller owns the string. */
@@ -116,12 +186,361 @@ void LexAnalyzer_freeTokens(DynArray_T oTokens)
 
 /*--------------------------------------------------------------------*/
 
-/* Lexically analyze string pcLine.  If pcLine contains a lexical
-   error, then return NULL.  Otherwise return a DynArray object
-   containing the tokens in pcLine.  The caller owns the DynArray
-   object and the tokens that it contains. */
+/* Make the buffer *ppcBuffer, of *puBufferSize bytes, at least
+   uNeeded bytes long, keeping its contents. */
 
-DynArray_T LexAnalyzer_lexLine(const char *pcLine)
+static void LexAnalyzer_reserve(char **ppcBuffer, size_t *puBufferSize,
+                                size_t uNeeded)
+{
+   char *pcBuffer;
+
+   if (uNeeded <= *puBufferSize)
+      return;
+   if (uNeeded < *puBufferSize * 2)
+      uNeeded = *puBufferSize * 2;
+   pcBuffer = (char*)realloc(*ppcBuffer, uNeeded);
+   if (pcBuffer == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   *ppcBuffer = pcBuffer;
+   *puBufferSize = uNeeded;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the operator that joins commands at
+   pcLine[uIndex], where pcLine ends at index uEnd: 1 for ";", 2 for
+   "&&" or "||", or 0 if there is none there.  A single "&" or "|" is
+   an ordinary character. */
+
+static size_t LexAnalyzer_getJoinLength(const char *pcLine,
+                                        size_t uIndex, size_t uEnd)
+{
+   char c;
+
+   if (uIndex >= uEnd)
+      return 0;
+   c = pcLine[uIndex];
+   if (c == ';')
+      return 1;
+   if ((c == '&' || c == '|') && uIndex + 1 < uEnd &&
+       pcLine[uIndex + 1] == c)
+      return 2;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the operator that the SPECIAL character c denotes on its
+   own.  A longer run of SPECIAL characters denotes TOKEN_OP_INVALID. */
+
+static enum TokenOp LexAnalyzer_getSpecialOp(char c)
+{
+   return (c == '<') ? TOKEN_OP_REDIRECT_IN : TOKEN_OP_REDIRECT_OUT;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the operator that joins commands and starts with c, which is
+   the first character of an operator that LexAnalyzer_getJoinLength
+   found. */
+
+static enum TokenOp LexAnalyzer_getJoinOp(char c)
+{
+   switch (c)
+   {
+      case ';': return TOKEN_OP_SEQUENCE;
+      case '&': return TOKEN_OP_AND;
+      default: return TOKEN_OP_OR;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Terminate the word of uLength characters in pcBuffer, and add it to
+   oTokens as an ORDINARY token.  If *piPattern is 1 (TRUE), then the
+   word is a pattern (see wildcard.h) with wildcards outside quotes:
+   add the paths that it matches instead, unless it matches none or
+   follows a redirection operator.  If *piEscaped is 1 (TRUE), then
+   the word contains backslashes that make the characters of a pattern
+   match themselves; remove them from a word that is added as it is.
+   Reset *piPattern and *piEscaped to 0 (FALSE). */
+
+static void LexAnalyzer_addWord(char *pcBuffer, size_t uLength,
+                                DynArray_T oTokens, int *piPattern,
+                                int *piEscaped)
+{
+   DynArray_Storage sMatchesStorage;
+   DynArray_T oMatches;
+   Token_T oToken;
+   char *pcPath;
+   size_t uTokens;
+   enum TokenOp eOp = TOKEN_OP_NONE;
+   size_t u;
+
+   pcBuffer[uLength] = '\0';
+   uTokens = DynArray_getLength(oTokens);
+   if (uTokens > 0)
+      eOp = Token_getOp(DynArray_get(oTokens, uTokens - 1));
+   if (*piPattern &&
+       (uTokens == 0 ||
+        (eOp != TOKEN_OP_REDIRECT_IN && eOp != TOKEN_OP_REDIRECT_OUT)))
+   {
+      oMatches = DynArray_init(&sMatchesStorage);
+      if (Wildcard_expand(pcBuffer, oMatches) > 0)
+      {
+         /* Grow oTokens once, however many paths there are. */
+         if (! DynArray_reserve(oTokens,
+                                uTokens + DynArray_getLength(oMatches)))
+            {perror(getPgmName()); exit(EXIT_FAILURE);}
+         for (u = 0; u < DynArray_getLength(oMatches); u++)
+         {
+            pcPath = (char*)DynArray_get(oMatches, u);
+            oToken = Token_newOp(TOKEN_ORDINARY, TOKEN_OP_NONE, pcPath);
+            if (! DynArray_add(oTokens, oToken))
+               {perror(getPgmName()); exit(EXIT_FAILURE);}
+            free(pcPath);
+         }
+         DynArray_destroy(oMatches);
+         *piPattern = 0;
+         *piEscaped = 0;
+         return;
+      }
+      DynArray_destroy(oMatches);
+   }
+
+   if (*piEscaped)
+      Wildcard_unescape(pcBuffer);
+   oToken = Token_newOp(TOKEN_ORDINARY, TOKEN_OP_NONE, pcBuffer);
+   if (! DynArray_add(oTokens, oToken))
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   *piPattern = 0;
+   *piEscaped = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Expand the variable reference, $NAME, ${NAME} or $?, that starts
+   with the '$' just before pcLine[*puLineIndex], where pcLine ends at
+   index uEnd.  Copy the value straight into the buffer *ppcBuffer of
+   *puBufferSize bytes at index *puBufferIndex, growing the buffer so
+   that it keeps room for the rest of the line, and advance
+   *puLineIndex and *puBufferIndex past the reference and the value.
+   When globbing, escape the characters of the value that are special
+   in patterns, and then assign 1 (TRUE) to *piEscaped.  Return
+   1 (TRUE) if successful, 0 (FALSE), changing nothing, if the
+   '$' does not start a reference, or -1 after assigning a description
+   of the error to *ppcError if the reference is malformed. */
+
+static int LexAnalyzer_expand(const char *pcLine, size_t uEnd,
+                              size_t *puLineIndex, char **ppcBuffer,
+                              size_t *puBufferSize,
+                              size_t *puBufferIndex, int *piEscaped,
+                              const char **ppcError)
+{
+   size_t uIndex = *puLineIndex;
+   const char *pcName;
+   size_t uNameLength = 0;
+   int iBraced = 0;
+   const char *pcValue;
+   size_t uValueLength;
+   size_t uEscapes = 0;
+   char *pcBuffer;
+   size_t u;
+
+   if (uIndex < uEnd && pcLine[uIndex] == '{')
+   {
+      iBraced = 1;
+      uIndex++;
+   }
+
+   /* Find the name, which is pcLine[uIndex...uIndex+uNameLength-1]. */
+   pcName = pcLine + uIndex;
+   if (uIndex < uEnd && pcLine[uIndex] == '?')
+      uNameLength = 1;
+   else if (uIndex < uEnd && IS_NAME_START(pcLine[uIndex]))
+      while (uIndex + uNameLength < uEnd &&
+             IS_NAME(pcName[uNameLength]))
+         uNameLength++;
+   uIndex += uNameLength;
+
+   if (iBraced)
+   {
+      if (uNameLength == 0 || uIndex >= uEnd || pcLine[uIndex] != '}')
+      {
+         *ppcError = "bad substitution";
+         return -1;
+      }
+      uIndex++;
+   }
+   else if (uNameLength == 0)
+      return 0;
+
+   /* A variable that is not set expands to nothing. */
+   pcValue = (*pfLookUp)(pcName, uNameLength, pvLookUpExtra);
+   if (pcValue == NULL)
+      pcValue = "";
+   uValueLength = strlen(pcValue);
+   if (iGlobbing)
+      for (u = 0; u < uValueLength; u++)
+         if (IS_GLOB(pcValue[u]))
+            uEscapes++;
+
+   LexAnalyzer_reserve(ppcBuffer, puBufferSize,
+                       *puBufferIndex + uValueLength + uEscapes +
+                       (uEnd - uIndex) + 1);
+   pcBuffer = *ppcBuffer;
+
+   if (uEscapes == 0)
+   {
+      memcpy(pcBuffer + *puBufferIndex, pcValue, uValueLength);
+      *puBufferIndex += uValueLength;
+   }
+   else
+   {
+      for (u = 0; u < uValueLength; u++)
+      {
+         if (IS_GLOB(pcValue[u]))
+            pcBuffer[(*puBufferIndex)++] = '\\';
+         pcBuffer[(*puBufferIndex)++] = pcValue[u];
+      }
+      *piEscaped = 1;
+   }
+   *puLineIndex = uIndex;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the ')' that closes the command substitution
+   whose command starts at pcLine[uStart], outside quotes, or uEnd if
+   pcLine, which ends at index uEnd, does not close it. */
+
+static size_t LexAnalyzer_findClose(const char *pcLine, size_t uStart,
+                                    size_t uEnd)
+{
+   size_t uIndex;
+   size_t uDepth = 1;
+   int iInQuote = 0;
+   char c;
+
+   for (uIndex = uStart; uIndex < uEnd; uIndex++)
+   {
+      c = pcLine[uIndex];
+      if (c == '\"')
+         iInQuote = ! iInQuote;
+      else if (iInQuote)
+         continue;
+      else if (c == '(')
+         uDepth++;
+      else if (c == ')' && --uDepth == 0)
+         break;
+   }
+   return uIndex;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Substitute the output of the command of the command substitution
+   $(...) whose '(' is pcLine[*puLineIndex], where pcLine ends at index
+   uEnd.  Copy the output, without its trailing newlines, straight into
+   the buffer *ppcBuffer of *puBufferSize bytes at index
+   *puBufferIndex, growing the buffer so that it keeps room for the
+   rest of the line, and advance *puLineIndex and *puBufferIndex past
+   the substitution and the output.  Unless iQuoted is 1 (TRUE), split
+   the output into words at white space: *piOpen is 1 (TRUE) iff the
+   buffer holds a word, which white space ends by adding it to oTokens
+   with *piPattern and *piEscaped (see LexAnalyzer_addWord).  When
+   globbing, escape the characters of the output that are special in
+   patterns.  Return 1 (TRUE) if successful, or 0 (FALSE) after
+   assigning a description of the error to *ppcError if the
+   substitution has no closing ')'. */
+
+static int LexAnalyzer_substitute(const char *pcLine, size_t uEnd,
+                                  size_t *puLineIndex,
+                                  char **ppcBuffer,
+                                  size_t *puBufferSize,
+                                  size_t *puBufferIndex,
+                                  DynArray_T oTokens, int iQuoted,
+                                  int *piOpen, int *piPattern,
+                                  int *piEscaped,
+                                  const char **ppcError)
+{
+   size_t uStart = *puLineIndex + 1;
+   size_t uIndex;
+   char *pcOutput;
+   size_t uLength;
+   size_t uBufferIndex;
+   char *pcBuffer;
+   char c;
+   size_t u;
+
+   uIndex = LexAnalyzer_findClose(pcLine, uStart, uEnd);
+   if (uIndex >= uEnd)
+   {
+      *ppcError = "unmatched parenthesis";
+      return 0;
+   }
+
+   pcOutput = (*pfSubstitute)(pcLine + uStart, uIndex - uStart,
+                              &uLength, pvSubstituteExtra);
+   while (uLength > 0 && pcOutput[uLength - 1] == '\n')
+      uLength--;
+
+   LexAnalyzer_reserve(ppcBuffer, puBufferSize,
+                       *puBufferIndex + 2 * uLength +
+                       (uEnd - uIndex - 1) + 1);
+   pcBuffer = *ppcBuffer;
+   uBufferIndex = *puBufferIndex;
+
+   for (u = 0; u < uLength; u++)
+   {
+      c = pcOutput[u];
+
+      /* A null character cannot be part of a token. */
+      if (c == '\0')
+         continue;
+      if (! iQuoted && IS_SPACE(c))
+      {
+         if (*piOpen)
+         {
+            LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                piPattern, piEscaped);
+            uBufferIndex = 0;
+            *piOpen = 0;
+         }
+         continue;
+      }
+      if (iGlobbing && IS_GLOB(c))
+      {
+         pcBuffer[uBufferIndex++] = '\\';
+         *piEscaped = 1;
+      }
+      pcBuffer[uBufferIndex++] = c;
+      *piOpen = 1;
+   }
+   free(pcOutput);
+
+   *puBufferIndex = uBufferIndex;
+   *puLineIndex = uIndex + 1;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the characters pcLine[uStart...uEnd-1] as if
+   they formed a whole line, and add their tokens to oTokens.  The
+   buffer *ppcBuffer, of *puBufferSize bytes, must be large enough to
+   store the largest token that might appear within those characters
+   before variables are expanded; expanding them may replace it with a
+   larger one.  Return 1 (TRUE) if successful.  If the characters
+   contain a lexical error, then assign a description of the error to
+   *ppcError and return 0 (FALSE). */
+
+static int LexAnalyzer_lexRange(const char *pcLine, size_t uStart,
+                                size_t uEnd, char **ppcBuffer,
+                                size_t *puBufferSize,
+                                DynArray_T oTokens,
+                                const char **ppcError)
 {
    /* lexLine() uses a DFA approach.  It "reads" its characters from
       pcLine. The DFA has these four states: */
@@ -131,38 +550,154 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
    /* The current state of the DFA. */
    enum LexState eState = STATE_START;
 
+   /* The operator that the SPECIAL token being accumulated denotes. */
+   enum TokenOp eSpecialOp = TOKEN_OP_INVALID;
+
    /* An index into pcLine. */
-   size_t uLineIndex = 0;
+   size_t uLineIndex = uStart;
 
-   /* Pointer to a buffer in which the characters comprising each
-      token are accumulated. */
+   /* An index into the buffer. */
+   size_t uBufferIndex = 0;
+
+   /* The buffer in which the characters comprising each token are
+      accumulated. */
    char *pcBuffer;
 
-   /* An index into the buffer. */
-   int uBufferIndex = 0;
+   /* 1 (TRUE) iff the token being accumulated is a pattern, and 1
+      (TRUE) iff it contains backslashes that make characters match
+      themselves.  See LexAnalyzer_addWord. */
+   int iPattern = 0;
+   int iEscaped = 0;
+
+   /* 1 (TRUE) iff a command substitution continues a word. */
+   int iOpen;
 
    char c;
    Token_T oToken;
-   DynArray_T oTokens;
    int iSuccessful;
+   int iExpanded;
+   size_t uJoinLength;
 
    assert(pcLine != NULL);
+   assert(ppcBuffer != NULL);
+   assert(puBufferSize != NULL);
+   assert(oTokens != NULL);
+   assert(ppcError != NULL);
 
-   /* Create an empty token DynArray object. */
-   oTokens = DynArray_new(0);
-   if (oTokens == NULL)
-   {perror(getPgmName()); exit(EXIT_FAILURE);}
-
-   /* Allocate memory for a buffer that is large enough to store the
-      largest token that might appear within pcLine. */
-   pcBuffer = (char*)malloc(strlen(pcLine) + 1);
-   if (pcBuffer == NULL)
-      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   pcBuffer = *ppcBuffer;
 
    for (;;)
    {
-      /* "Read" the next character from pcLine. */
-      c = pcLine[uLineIndex++];
+      /* "Read" the next character from pcLine.  The end of the range
+         acts as the end of the line. */
+      if (uLineIndex < uEnd) c = pcLine[uLineIndex];
+      else c = '\0';
+      uLineIndex++;
+
+      /* An operator that joins commands, outside quotes, is a SPECIAL
+         token of its own, which ends the token before it. */
+      if (eState != STATE_IN_QUOTE &&
+          (uJoinLength = LexAnalyzer_getJoinLength(
+              pcLine, uLineIndex - 1, uEnd)) > 0)
+      {
+         if (eState == STATE_SPECIAL)
+         {
+            /* Create a SPECIAL token. */
+            pcBuffer[uBufferIndex] = '\0';
+            oToken = Token_newOp(TOKEN_SPECIAL, eSpecialOp, pcBuffer);
+            iSuccessful = DynArray_add(oTokens, oToken);
+            if (! iSuccessful)
+               {perror(getPgmName()); exit(EXIT_FAILURE);}
+         }
+         else if (eState != STATE_START)
+         {
+            /* Create an ORDINARY token. */
+            LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                &iPattern, &iEscaped);
+         }
+
+         /* Create a SPECIAL token for the operator. */
+         memcpy(pcBuffer, pcLine + uLineIndex - 1, uJoinLength);
+         pcBuffer[uJoinLength] = '\0';
+         oToken = Token_newOp(TOKEN_SPECIAL,
+                              LexAnalyzer_getJoinOp(c), pcBuffer);
+         iSuccessful = DynArray_add(oTokens, oToken);
+         if (! iSuccessful)
+            {perror(getPgmName()); exit(EXIT_FAILURE);}
+         uBufferIndex = 0;
+         uLineIndex += uJoinLength - 1;
+         eState = STATE_START;
+         continue;
+      }
+
+      /* Splice the value of a variable reference into the token in
+         place of the reference, and the output of a command in place
+         of its substitution.  A reference that stands alone and
+         outside quotes expands to no token if its value is empty.
+         When globbing, a word with a wildcard outside quotes is a
+         pattern, and wildcards within quotes, and backslashes, are
+         escaped so that they match themselves. */
+      if ((c == '$' && (pfLookUp != NULL || pfSubstitute != NULL)) ||
+          (iGlobbing && IS_GLOB(c)))
+      {
+         if (eState == STATE_SPECIAL)
+         {
+            /* Create a SPECIAL token. */
+            pcBuffer[uBufferIndex] = '\0';
+            oToken = Token_newOp(TOKEN_SPECIAL, eSpecialOp, pcBuffer);
+            iSuccessful = DynArray_add(oTokens, oToken);
+            if (! iSuccessful)
+               {perror(getPgmName()); exit(EXIT_FAILURE);}
+            uBufferIndex = 0;
+            eState = STATE_START;
+         }
+         if (c == '$' && pfSubstitute != NULL && uLineIndex < uEnd &&
+             pcLine[uLineIndex] == '(')
+         {
+            iOpen = (eState != STATE_START);
+            if (! LexAnalyzer_substitute(pcLine, uEnd, &uLineIndex,
+                                         ppcBuffer, puBufferSize,
+                                         &uBufferIndex, oTokens,
+                                         eState == STATE_IN_QUOTE,
+                                         &iOpen, &iPattern, &iEscaped,
+                                         ppcError))
+               return 0;
+            pcBuffer = *ppcBuffer;
+            if (eState != STATE_IN_QUOTE)
+               eState = iOpen ? STATE_ORDINARY : STATE_START;
+            continue;
+         }
+         else if (c == '$' && pfLookUp != NULL)
+         {
+            iExpanded = LexAnalyzer_expand(pcLine, uEnd, &uLineIndex,
+                                           ppcBuffer, puBufferSize,
+                                           &uBufferIndex, &iEscaped,
+                                           ppcError);
+            pcBuffer = *ppcBuffer;
+            if (iExpanded < 0)
+               return 0;
+            if (iExpanded)
+            {
+               if (eState != STATE_IN_QUOTE &&
+                   (eState != STATE_START || uBufferIndex > 0))
+                  eState = STATE_ORDINARY;
+               continue;
+            }
+         }
+         else if (c == '$')
+            ;
+         else if (eState == STATE_IN_QUOTE || c == '\\')
+         {
+            /* Then c is added as usual, below. */
+            LexAnalyzer_reserve(ppcBuffer, puBufferSize,
+                                uBufferIndex + (uEnd - uLineIndex) + 3);
+            pcBuffer = *ppcBuffer;
+            pcBuffer[uBufferIndex++] = '\\';
+            iEscaped = 1;
+         }
+         else
+            iPattern = 1;
+      }
 
       switch (eState)
       {
@@ -170,17 +705,17 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
          case STATE_START:
             if (c == '\0')
             {
-               free(pcBuffer);
-               return oTokens;
+               return 1;
             }
             else if (c == '\"')
                eState = STATE_IN_QUOTE;
-            else if (isspace(c))
+            else if (IS_SPACE(c))
                eState = STATE_START;
-            else if (c == '<' || c == '>')
+            else if (IS_SPECIAL(c))
             {
                pcBuffer[uBufferIndex++] = c;
                eState = STATE_SPECIAL;
+               eSpecialOp = LexAnalyzer_getSpecialOp(c);
             }
             else
             {
@@ -194,35 +729,26 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
             if (c == '\0')
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
-               free(pcBuffer);
-               return oTokens;
+               return 1;
             }
-            else if (c == '<' || c == '>')
+            else if (IS_SPECIAL(c))
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
                pcBuffer[uBufferIndex++] = c;
                eState = STATE_SPECIAL;
+               eSpecialOp = LexAnalyzer_getSpecialOp(c);
             }
-            else if (isspace(c))
+            else if (IS_SPACE(c))
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
                eState = STATE_START;
             }
@@ -241,24 +767,26 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
             {
                /* Create a SPECIAL token. */
                pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_SPECIAL, pcBuffer);
+               oToken = Token_newOp(TOKEN_SPECIAL, eSpecialOp,
+                                    pcBuffer);
                iSuccessful = DynArray_add(oTokens, oToken);
                if (! iSuccessful)
                   {perror(getPgmName()); exit(EXIT_FAILURE);}
                uBufferIndex = 0;
-               free(pcBuffer);
-               return oTokens;
+               return 1;
             }
-            else if (c == '<' || c == '>')
+            else if (IS_SPECIAL(c))
             {
                pcBuffer[uBufferIndex++] = c;
                eState = STATE_SPECIAL;
+               eSpecialOp = TOKEN_OP_INVALID;
             }
-            else if (isspace(c))
+            else if (IS_SPACE(c))
             {
                /* Create a SPECIAL token. */
                pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_SPECIAL, pcBuffer);
+               oToken = Token_newOp(TOKEN_SPECIAL, eSpecialOp,
+                                    pcBuffer);
                iSuccessful = DynArray_add(oTokens, oToken);
                if (! iSuccessful)
                   {perror(getPgmName()); exit(EXIT_FAILURE);}
@@ -269,7 +797,8 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
             {
                /* Create a SPECIAL token. */
                pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_SPECIAL, pcBuffer);
+               oToken = Token_newOp(TOKEN_SPECIAL, eSpecialOp,
+                                    pcBuffer);
                iSuccessful = DynArray_add(oTokens, oToken);
                if (! iSuccessful)
                   {perror(getPgmName()); exit(EXIT_FAILURE);}
@@ -280,7 +809,8 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
             {
                /* Create a SPECIAL token. */
                pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_SPECIAL, pcBuffer);
+               oToken = Token_newOp(TOKEN_SPECIAL, eSpecialOp,
+                                    pcBuffer);
                iSuccessful = DynArray_add(oTokens, oToken);
                if (! iSuccessful)
                {perror(getPgmName()); exit(EXIT_FAILURE);}
@@ -294,11 +824,8 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
          case STATE_IN_QUOTE:
             if (c == '\0')
             {
-               fprintf(stderr, "%s: unmatched quote\n", getPgmName());
-               free(pcBuffer);
-               LexAnalyzer_freeTokens(oTokens);
-               DynArray_free(oTokens); 
-               return NULL;
+               *ppcError = "unmatched quote";
+               return 0;
             }
             else if (c == '\"')
                eState = STATE_OUT_QUOTE;
@@ -314,45 +841,34 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
             if (c == '\0')
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
-               free(pcBuffer);
-               return oTokens;
+               return 1;
             }
-            else if (c == '<' || c == '>')
+            else if (IS_SPECIAL(c))
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
+               pcBuffer[uBufferIndex++] = c;
                eState = STATE_SPECIAL;
+               eSpecialOp = LexAnalyzer_getSpecialOp(c);
             }
             else if (c == '\"')
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
                eState = STATE_IN_QUOTE;
             }
-            else if (isspace(c))
+            else if (IS_SPACE(c))
             {
                /* Create an ORDINARY token. */
-               pcBuffer[uBufferIndex] = '\0';
-               oToken = Token_new(TOKEN_ORDINARY, pcBuffer);
-               iSuccessful = DynArray_add(oTokens, oToken);
-               if (! iSuccessful)
-                  {perror(getPgmName()); exit(EXIT_FAILURE);}
+               LexAnalyzer_addWord(pcBuffer, uBufferIndex, oTokens,
+                                   &iPattern, &iEscaped);
                uBufferIndex = 0;
                eState = STATE_START;
             }
@@ -369,3 +885,488 @@ DynArray_T LexAnalyzer_lexLine(const char *pcLine)
    }
 }
 
+/*--------------------------------------------------------------------*/
+
+/* The shortest line that is split across threads. */
+
+enum {PARALLEL_MIN_LENGTH = 1024 * 1024};
+
+/* The shortest part of a line that a thread lexes. */
+
+enum {PARALLEL_MIN_CHUNK = 256 * 1024};
+
+/* The largest number of chunks into which a line is split. */
+
+enum {PARALLEL_MAX_THREADS = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* A part of a line that one thread lexes. */
+
+struct LexChunk
+{
+   /* The whole line. */
+   const char *pcLine;
+
+   /* The index of the first character of the chunk.  At first it is
+      the nominal start of the chunk; the boundary phase moves it
+      forward to a point at which the DFA is in its START state. */
+   size_t uStart;
+
+   /* The index one past the last character of the chunk. */
+   size_t uEnd;
+
+   /* The number of quote characters in the chunk, and then whether
+      its nominal start lies within quotes. */
+   size_t uQuotes;
+
+   /* The tokens of the chunk. */
+   DynArray_T oTokens;
+
+   /* The memory in which oTokens resides. */
+   DynArray_Storage sTokensStorage;
+
+   /* 1 (TRUE) iff the chunk was lexed successfully. */
+   int iSuccessful;
+
+   /* A description of the lexical error in the chunk, or NULL. */
+   const char *pcError;
+};
+
+/* A phase of lexing a line in parallel: the chunks, and the function
+   that processes each of them. */
+
+struct LexPhase
+{
+   /* The chunks. */
+   struct LexChunk *psChunks;
+
+   /* The function that processes one chunk. */
+   void (*pfPhase)(struct LexChunk *psChunk);
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Count the quote characters in the chunk psChunk. */
+
+static void LexAnalyzer_countQuotes(struct LexChunk *psChunk)
+{
+   const char *pcChar = psChunk->pcLine + psChunk->uStart;
+   const char *pcEnd = psChunk->pcLine + psChunk->uEnd;
+   size_t uQuotes = 0;
+
+   while ((pcChar = memchr(pcChar, '\"', (size_t)(pcEnd - pcChar)))
+          != NULL)
+   {
+      uQuotes++;
+      pcChar++;
+   }
+   psChunk->uQuotes = uQuotes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the start of the chunk psChunk forward to its first
+   white-space character outside quotes.  White space outside quotes
+   always returns the DFA to its START state, so the line can be cut
+   there without changing its tokens. */
+
+static void LexAnalyzer_findBoundary(struct LexChunk *psChunk)
+{
+   const char *pcLine = psChunk->pcLine;
+   size_t uIndex = psChunk->uStart;
+   int iInQuote = (int)psChunk->uQuotes;
+   char c;
+
+   /* The search may run past the nominal end of the chunk. */
+   while ((c = pcLine[uIndex]) != '\0')
+   {
+      if (c == '\"')
+         iInQuote = ! iInQuote;
+      else if (! iInQuote && IS_SPACE(c))
+         break;
+      uIndex++;
+   }
+   psChunk->uStart = uIndex;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex the chunk psChunk. */
+
+static void LexAnalyzer_lexChunk(struct LexChunk *psChunk)
+{
+   size_t uBufferSize = psChunk->uEnd - psChunk->uStart + 1;
+   char *pcBuffer;
+
+   psChunk->oTokens = DynArray_init(&psChunk->sTokensStorage);
+   pcBuffer = (char*)malloc(uBufferSize);
+   if (pcBuffer == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   psChunk->iSuccessful =
+      LexAnalyzer_lexRange(psChunk->pcLine, psChunk->uStart,
+                           psChunk->uEnd, &pcBuffer, &uBufferSize,
+                           psChunk->oTokens, &psChunk->pcError);
+   free(pcBuffer);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the LexPhase pvPhase to its chunks uLo to uHi - 1. */
+
+static void LexAnalyzer_runPhaseRange(size_t uLo, size_t uHi,
+                                      void *pvPhase)
+{
+   struct LexPhase *psPhase = (struct LexPhase*)pvPhase;
+   size_t u;
+
+   for (u = uLo; u < uHi; u++)
+      (*psPhase->pfPhase)(&psPhase->psChunks[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run *pfPhase on each of the uChunks chunks at psChunks on the
+   threads of oThreadPool, and wait for all of them to finish. */
+
+static void LexAnalyzer_runPhase(ThreadPool_T oThreadPool,
+                                 struct LexChunk *psChunks,
+                                 size_t uChunks,
+                                 void (*pfPhase)(struct LexChunk *))
+{
+   struct LexPhase sPhase;
+
+   sPhase.psChunks = psChunks;
+   sPhase.pfPhase = pfPhase;
+   ThreadPool_run(oThreadPool, uChunks, 1, LexAnalyzer_runPhaseRange,
+                  &sPhase);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine, whose length is uLength, by
+   splitting it into uChunks chunks that the threads of oThreadPool
+   lex, and add its tokens to oTokens.  Produce the same tokens, or
+   the same error, as the serial DFA. */
+
+static int LexAnalyzer_lexLineInParallel(ThreadPool_T oThreadPool,
+                                         const char *pcLine,
+                                         size_t uLength,
+                                         size_t uChunks,
+                                         DynArray_T oTokens,
+                                         const char **ppcError)
+{
+   struct LexChunk asChunks[PARALLEL_MAX_THREADS];
+   size_t u;
+   size_t uTotalTokens = 0;
+   int iInQuote = 0;
+   int iSuccessful = 1;
+
+   assert(uChunks > 1 && uChunks <= PARALLEL_MAX_THREADS);
+
+   for (u = 0; u < uChunks; u++)
+   {
+      asChunks[u].pcLine = pcLine;
+      asChunks[u].uStart = uLength / uChunks * u;
+      asChunks[u].uEnd = (u == uChunks - 1) ?
+         uLength : uLength / uChunks * (u + 1);
+   }
+
+   /* Count the quotes in each chunk, and use a prefix sum of their
+      parities to learn whether each chunk starts within quotes. */
+   LexAnalyzer_runPhase(oThreadPool, asChunks, uChunks,
+                        LexAnalyzer_countQuotes);
+   for (u = 0; u < uChunks; u++)
+   {
+      size_t uQuotes = asChunks[u].uQuotes;
+      asChunks[u].uQuotes = (size_t)iInQuote;
+      iInQuote ^= (int)(uQuotes & 1);
+   }
+
+   /* Move each chunk boundary to a place where the DFA restarts. */
+   LexAnalyzer_runPhase(oThreadPool, asChunks + 1, uChunks - 1,
+                        LexAnalyzer_findBoundary);
+   for (u = 0; u < uChunks - 1; u++)
+      asChunks[u].uEnd = asChunks[u + 1].uStart;
+
+   LexAnalyzer_runPhase(oThreadPool, asChunks, uChunks,
+                        LexAnalyzer_lexChunk);
+
+   /* Stitch the tokens of the chunks together in order. */
+   for (u = 0; u < uChunks; u++)
+      uTotalTokens += DynArray_getLength(asChunks[u].oTokens);
+   if (! DynArray_reserve(oTokens, uTotalTokens))
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   for (u = 0; u < uChunks; u++)
+   {
+      if (iSuccessful && ! asChunks[u].iSuccessful)
+      {
+         iSuccessful = 0;
+         *ppcError = asChunks[u].pcError;
+      }
+      DynArray_addAll(oTokens, asChunks[u].oTokens);
+      DynArray_destroy(asChunks[u].oTokens);
+   }
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine without writing to stderr, adding
+   its tokens to oTokens, which must be empty.  If pcLine contains a
+   lexical error, then assign a description of the error to *ppcError,
+   free the tokens, leave oTokens empty, and return 0 (FALSE).
+   Otherwise return 1 (TRUE); the caller owns the tokens.  Very long
+   lines are split across threads, unless they need expansion. */
+
+int LexAnalyzer_lexLineInto(const char *pcLine, DynArray_T oTokens,
+                            const char **ppcError)
+{
+   size_t uLength;
+   size_t uChunks;
+   size_t uMaxChunks;
+   ThreadPool_T oThreadPool = NULL;
+   int iSuccessful;
+
+   /* Pointer to a buffer in which the characters comprising each
+      token are accumulated, and its size. */
+   char *pcBuffer;
+   size_t uBufferSize;
+
+   assert(pcLine != NULL);
+   assert(oTokens != NULL);
+   assert(DynArray_getLength(oTokens) == 0);
+   assert(ppcError != NULL);
+
+   uLength = strlen(pcLine);
+
+   if (iValidateUtf8 && ! Utf8_isValid(pcLine, uLength))
+   {
+      *ppcError = "invalid UTF-8";
+      return 0;
+   }
+
+   /* Variables and patterns are expanded only in the calling
+      thread. */
+   uChunks = 1;
+   if (uLength >= PARALLEL_MIN_LENGTH &&
+       ! LexAnalyzer_needsExpansion(pcLine) &&
+       (oThreadPool = ThreadPool_getShared()) != NULL)
+   {
+      uChunks = uLength / PARALLEL_MIN_CHUNK;
+      uMaxChunks = uMaxLineChunks;
+      if (uMaxChunks == 0)
+         uMaxChunks = ThreadPool_getThreads(oThreadPool);
+      if (uChunks > uMaxChunks)
+         uChunks = uMaxChunks;
+      if (uChunks > PARALLEL_MAX_THREADS)
+         uChunks = PARALLEL_MAX_THREADS;
+   }
+
+   if (uChunks > 1)
+      iSuccessful = LexAnalyzer_lexLineInParallel(oThreadPool, pcLine,
+                                                  uLength, uChunks,
+                                                  oTokens, ppcError);
+   else
+   {
+      /* Allocate memory for a buffer that is large enough to store
+         the largest token that might appear within pcLine. */
+      uBufferSize = uLength + 1;
+      pcBuffer = (char*)malloc(uBufferSize);
+      if (pcBuffer == NULL)
+         {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+      iSuccessful = LexAnalyzer_lexRange(pcLine, 0, uLength, &pcBuffer,
+                                         &uBufferSize, oTokens,
+                                         ppcError);
+      free(pcBuffer);
+   }
+
+   if (! iSuccessful)
+   {
+      LexAnalyzer_freeTokens(oTokens);
+      DynArray_clear(oTokens);
+   }
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine without writing to stderr.  If
+   pcLine contains a lexical error, then assign a description of the
+   error to *ppcError and return NULL.  Otherwise return a DynArray
+   object containing the tokens in pcLine.  The caller owns the
+   DynArray object and the tokens that it contains. */
+
+DynArray_T LexAnalyzer_lexLineQuietly(const char *pcLine,
+                                      const char **ppcError)
+{
+   DynArray_T oTokens;
+
+   assert(pcLine != NULL);
+   assert(ppcError != NULL);
+
+   /* Create an empty token DynArray object. */
+   oTokens = DynArray_new(0);
+   if (oTokens == NULL)
+   {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   if (! LexAnalyzer_lexLineInto(pcLine, oTokens, ppcError))
+   {
+      DynArray_free(oTokens);
+      return NULL;
+   }
+   return oTokens;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If iValidate is 1 (TRUE), then treat lines that are not well-formed
+   UTF-8 as lexical errors.  By default lines are not validated. */
+
+void LexAnalyzer_setValidateUtf8(int iValidate)
+{
+   iValidateUtf8 = iValidate;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Split each very long line into at most uMaxChunks chunks, which
+   the threads of the shared ThreadPool lex in parallel.  If uMaxChunks
+   is 0, as it is by default, then a line has at most one chunk per
+   thread.  If it is 1, then every line is lexed serially. */
+
+void LexAnalyzer_setMaxChunks(size_t uMaxChunks)
+{
+   uMaxLineChunks = uMaxChunks;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Expand the variable references $NAME, ${NAME} and $? in later lines,
+   outside quotes and within them, to the values that
+   (*pfNewLookUp)(pcName, uLength, pvExtra) returns for the uLength
+   characters of each name pcName, or to nothing if it returns NULL.
+   If pfNewLookUp is NULL, then '$' is an ordinary character, as it
+   is by default. */
+
+void LexAnalyzer_setLookUp(const char *(*pfNewLookUp)
+                              (const char *pcName, size_t uLength,
+                               void *pvExtra),
+                           void *pvExtra)
+{
+   pfLookUp = pfNewLookUp;
+   pvLookUpExtra = pvExtra;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Replace each command substitution $(...) in later lines by the
+   output that (*pfNewSubstitute)(pcCommand, uLength, puLength,
+   pvExtra) returns for the uLength characters of its command
+   pcCommand, assigning the length of the output to *puLength.  The
+   output, which the lexical analyzer frees, loses its trailing
+   newlines, and outside quotes is split into words at white space.
+   If pfNewSubstitute is NULL, then commands are not substituted, as
+   by default. */
+
+void LexAnalyzer_setSubstitute(char *(*pfNewSubstitute)
+                                  (const char *pcCommand,
+                                   size_t uLength, size_t *puLength,
+                                   void *pvExtra),
+                               void *pvExtra)
+{
+   pfSubstitute = pfNewSubstitute;
+   pvSubstituteExtra = pvExtra;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If iGlob is 1 (TRUE), then replace each word of later lines that is
+   a pattern, with wildcards outside quotes, by the paths that it
+   matches, sorted, unless it follows a redirection operator.  A word
+   that matches no path is kept as it is.  By default words are not
+   expanded. */
+
+void LexAnalyzer_setGlobbing(int iGlob)
+{
+   iGlobbing = iGlob;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index in string pcLine of the first ";", "&&" or "||"
+   that joins its first command to the next, outside quotes and
+   command substitutions, and assign the length of that operator to
+   *puJoinLength.  If there is none, then return the length of pcLine,
+   and assign 0 to *puJoinLength. */
+
+size_t LexAnalyzer_findJoin(const char *pcLine, size_t *puJoinLength)
+{
+   size_t uEnd;
+   size_t uIndex = 0;
+   size_t uJoinLength;
+   int iInQuote = 0;
+
+   assert(pcLine != NULL);
+   assert(puJoinLength != NULL);
+
+   uEnd = strlen(pcLine);
+   while (uIndex < uEnd)
+   {
+      if (pcLine[uIndex] == '\"')
+         iInQuote = ! iInQuote;
+
+      /* A command substitution is substituted within quotes, too, and
+         its quotes are its own. */
+      else if (pcLine[uIndex] == '$' && pfSubstitute != NULL &&
+               uIndex + 1 < uEnd && pcLine[uIndex + 1] == '(')
+         uIndex = LexAnalyzer_findClose(pcLine, uIndex + 2, uEnd);
+      else if (! iInQuote &&
+               (uJoinLength = LexAnalyzer_getJoinLength(pcLine, uIndex,
+                                                        uEnd)) > 0)
+      {
+         *puJoinLength = uJoinLength;
+         return uIndex;
+      }
+      uIndex++;
+   }
+   *puJoinLength = 0;
+   return uEnd;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if analyzing string pcLine may expand variables,
+   commands or patterns, or 0 (FALSE) otherwise. */
+
+int LexAnalyzer_needsExpansion(const char *pcLine)
+{
+   assert(pcLine != NULL);
+
+   return ((pfLookUp != NULL || pfSubstitute != NULL) &&
+           strchr(pcLine, '$') != NULL) ||
+      (iGlobbing && strpbrk(pcLine, "*?[") != NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine.  If pcLine contains a lexical
+   error, then write a description of it to stderr and return NULL.
+   Otherwise return a DynArray object containing the tokens in pcLine.
+   The caller owns the DynArray object and the tokens that it
+   contains. */
+
+DynArray_T LexAnalyzer_lexLine(const char *pcLine)
+{
+   DynArray_T oTokens;
+   const char *pcError;
+
+   assert(pcLine != NULL);
+
+   oTokens = LexAnalyzer_lexLineQuietly(pcLine, &pcError);
+   if (oTokens == NULL)
+      fprintf(stderr, "%s: %s\n", getPgmName(), pcError);
+   return oTokens;
+}
@@ -31,10 +31,113 @@ void LexAnalyzer_freeTokens(DynArray_T oTokens);
 /*--------------------------------------------------------------------*/
 
 /* Lexically analyze string pcLine.  If pcLine contains a lexical
-   error, then return NULL.  Otherwise return a DynArray object
+   error, then write a description of it to stderr and return NULL.  Otherwise return a DynArray object
    containing the tokens in pcLine.  The caller owns the DynArray
    object and the tokens that it contains. */
 
 DynArray_T LexAnalyzer_lexLine(const char *pcLine);
 
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine without writing to stderr.  If
+   pcLine contains a lexical error, then assign a description of the
+   error to *ppcError and return NULL.  Otherwise return a DynArray
+   object containing the tokens in pcLine.  The caller owns the
+   DynArray object and the tokens that it contains. */
+
+DynArray_T LexAnalyzer_lexLineQuietly(const char *pcLine,
+                                      const char **ppcError);
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine without writing to stderr, adding
+   its tokens to oTokens, which must be empty.  If pcLine contains a
+   lexical error, then assign a description of the error to *ppcError,
+   leave oTokens empty, and return 0 (FALSE).  Otherwise return
+   1 (TRUE); the caller owns the tokens.  Reusing oTokens across lines
+   avoids allocating a new DynArray object for each. */
+
+int LexAnalyzer_lexLineInto(const char *pcLine, DynArray_T oTokens,
+                            const char **ppcError);
+
+/*--------------------------------------------------------------------*/
+
+/* If iValidate is 1 (TRUE), then treat lines that are not well-formed
+   UTF-8 as lexical errors.  By default lines are not validated. */
+
+void LexAnalyzer_setValidateUtf8(int iValidate);
+
+/*--------------------------------------------------------------------*/
+
+/* Split each very long line into at most uMaxChunks chunks, which
+   the threads of the shared ThreadPool lex in parallel.  If uMaxChunks
+   is 0, as it is by default, then a line has at most one chunk per
+   thread.  If it is 1, then every line is lexed serially. */
+
+void LexAnalyzer_setMaxChunks(size_t uMaxChunks);
+
+/*--------------------------------------------------------------------*/
+
+/* Expand the variable references $NAME, ${NAME} and $? in later lines,
+   outside quotes and within them, to the values that
+   (*pfLookUp)(pcName, uLength, pvExtra) returns for the uLength
+   characters of each name pcName, or to nothing if it returns NULL.
+   The value is copied into the token, and must stay valid only until
+   the next call.  A NAME consists of letters, digits and underscores,
+   and does not start with a digit.  If pfLookUp is NULL, then '$' is
+   an ordinary character, as it is by default. */
+
+void LexAnalyzer_setLookUp(const char *(*pfLookUp)(const char *pcName,
+                                                   size_t uLength,
+                                                   void *pvExtra),
+                           void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Replace each command substitution $(...) in later lines by the
+   output that (*pfSubstitute)(pcCommand, uLength, puLength, pvExtra)
+   returns for the uLength characters of its command pcCommand,
+   assigning the length of the output to *puLength.  The output is in
+   its own memory chunk, which the lexical analyzer frees.  It loses
+   its trailing newlines, and outside quotes is split into words at
+   white space; its characters do not redirect, expand or match files.
+   If pfSubstitute is NULL, then commands are not substituted, as by
+   default. */
+
+void LexAnalyzer_setSubstitute(char *(*pfSubstitute)
+                                  (const char *pcCommand,
+                                   size_t uLength, size_t *puLength,
+                                   void *pvExtra),
+                               void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* If iGlob is 1 (TRUE), then replace each word of later lines that is
+   a pattern (see wildcard.h), with wildcards outside quotes, by the
+   paths that it matches, sorted, unless it follows a redirection
+   operator.  A word that matches no path is kept as it is.  By
+   default words are not expanded. */
+
+void LexAnalyzer_setGlobbing(int iGlob);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index in string pcLine of the first ";", "&&" or "||"
+   that joins its first command to the next, outside quotes and
+   command substitutions, and assign the length of that operator to
+   *puJoinLength.  If there is none, then return the length of pcLine,
+   and assign 0 to *puJoinLength.  Splitting a line that expands
+   variables, commands or patterns at its operators lets each command
+   be analyzed only when the commands before it have run. */
+
+size_t LexAnalyzer_findJoin(const char *pcLine, size_t *puJoinLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if analyzing string pcLine may expand variables,
+   commands or patterns, and so depends on the effects of earlier
+   commands, or 0 (FALSE) otherwise. */
+
+int LexAnalyzer_needsExpansion(const char *pcLine);
+
 #endif
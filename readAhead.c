@@ -0,0 +1,409 @@
+/*--------------------------------------------------------------------*/
+/* readAhead.c                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "readAhead.h"
+#include "lexAnalyzer.h"
+#include "synAnalyzer.h"
+#include "ish.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A line together with the result of analyzing it. */
+
+struct ReadAheadItem
+{
+   /* The line, without its terminating newline character. */
+   char *pcLine;
+
+   /* The tokens of the line, or NULL if it has a lexical error. */
+   DynArray_T oTokens;
+
+   /* The command of the line, or NULL if there is none. */
+   Command_T oCommand;
+
+   /* A description of the error in the line, or NULL. */
+   const char *pcError;
+
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A ReadAhead consists of the file being read and a bounded circular
+   queue of analyzed lines, filled by a producer thread and emptied by
+   the caller. */
+
+struct ReadAhead
+{
+   /* The file from which lines are read. */
+   FILE *psFile;
+
+   /* The capacity of the queue, or 0 if there is no producer
+      thread. */
+   size_t uDepth;
+
+   /* The circular queue of analyzed lines. */
+   struct ReadAheadItem *psItems;
+
+   /* The index of the oldest item in the queue. */
+   size_t uHead;
+
+   /* The number of items in the queue. */
+   size_t uCount;
+
+   /* 1 (TRUE) iff the producer has reached end-of-file. */
+   int iEof;
+
+   /* Protects uHead, uCount and iEof. */
+   pthread_mutex_t sMutex;
+
+   /* Signaled when an item is added or end-of-file is reached. */
+   pthread_cond_t sNotEmpty;
+
+   /* Signaled when an item is removed. */
+   pthread_cond_t sNotFull;
+
+   /* An eventfd that is ready for reading iff the queue is not empty
+      or the producer has reached end-of-file.  Protected by sMutex. */
+   int iReadyFd;
+
+   /* The producer thread. */
+   pthread_t sProducer;
+
+   /* Emptied token DynArray objects that the caller gave back, for
+      reuse by later lines.  Protected by sMutex. */
+   DynArray_T oSpareTokens;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The most token DynArray objects to keep for reuse beyond uDepth,
+   and the longest one to keep without shrinking it. */
+
+enum {MAX_SPARE_TOKENS = 2, MAX_SPARE_LENGTH = 1024};
+
+/*--------------------------------------------------------------------*/
+
+/* Return an empty token DynArray object, reusing one that the caller
+   gave back to oReadAhead if possible. */
+
+static DynArray_T ReadAhead_takeTokens(ReadAhead_T oReadAhead)
+{
+   DynArray_T oTokens = NULL;
+   size_t uSpares;
+
+   assert(oReadAhead != NULL);
+
+   if (oReadAhead->uDepth > 0)
+      pthread_mutex_lock(&oReadAhead->sMutex);
+   uSpares = DynArray_getLength(oReadAhead->oSpareTokens);
+   if (uSpares > 0)
+      oTokens = DynArray_removeAt(oReadAhead->oSpareTokens,
+                                  uSpares - 1);
+   if (oReadAhead->uDepth > 0)
+      pthread_mutex_unlock(&oReadAhead->sMutex);
+
+   if (oTokens == NULL)
+   {
+      oTokens = DynArray_new(0);
+      if (oTokens == NULL)
+         {perror(getPgmName()); exit(EXIT_FAILURE);}
+   }
+   return oTokens;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Analyze the line of *psItem, for oReadAhead. */
+
+static void ReadAhead_analyze(ReadAhead_T oReadAhead,
+                              struct ReadAheadItem *psItem)
+{
+   assert(oReadAhead != NULL);
+   assert(psItem != NULL);
+
+   psItem->oCommand = NULL;
+   psItem->oTokens = ReadAhead_takeTokens(oReadAhead);
+   if (LexAnalyzer_lexLineInto(psItem->pcLine, psItem->oTokens,
+                               &psItem->pcError))
+      psItem->oCommand =
+         SynAnalyzer_synTokensQuietly(psItem->oTokens,
+                                      &psItem->pcError);
+   else
+   {
+      ReadAhead_recycle(oReadAhead, psItem->oTokens);
+      psItem->oTokens = NULL;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read a line from the file of oReadAhead into *psItem, and analyze it
+   unless the analysis depends on the effects of earlier commands, so
+   that it is left to the caller.  Return 0 (FALSE) if no lines
+   remain, and 1 (TRUE) otherwise. */
+
+static int ReadAhead_readItem(ReadAhead_T oReadAhead,
+                              struct ReadAheadItem *psItem)
+{
+   assert(oReadAhead != NULL);
+   assert(psItem != NULL);
+
+   psItem->pcLine = LexAnalyzer_readLine(oReadAhead->psFile);
+   if (psItem->pcLine == NULL)
+      return 0;
+
+   if (LexAnalyzer_needsExpansion(psItem->pcLine))
+   {
+      psItem->oTokens = NULL;
+      psItem->oCommand = NULL;
+      psItem->pcError = NULL;
+   }
+   else
+      ReadAhead_analyze(oReadAhead, psItem);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make the eventfd of oReadAhead ready for reading if iReady is 1
+   (TRUE), and not ready otherwise.  The caller must hold the mutex of
+   oReadAhead. */
+
+static void ReadAhead_setReady(ReadAhead_T oReadAhead, int iReady)
+{
+   uint64_t uiValue = 1;
+   ssize_t lRet;
+
+   if (iReady)
+      lRet = write(oReadAhead->iReadyFd, &uiValue, sizeof(uiValue));
+   else
+      lRet = read(oReadAhead->iReadyFd, &uiValue, sizeof(uiValue));
+
+   /* The eventfd is already in the requested state. */
+   if (lRet == -1 && errno != EAGAIN)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The body of the producer thread of the ReadAhead pvReadAhead. */
+
+static void *ReadAhead_produce(void *pvReadAhead)
+{
+   ReadAhead_T oReadAhead = (ReadAhead_T)pvReadAhead;
+   struct ReadAheadItem sItem;
+   int iMore;
+
+   assert(oReadAhead != NULL);
+
+   do
+   {
+      /* Parsing does not depend on the effects of earlier commands,
+         so it may run ahead of execution, except where variables,
+         commands or patterns are expanded. */
+      iMore = ReadAhead_readItem(oReadAhead, &sItem);
+
+      pthread_mutex_lock(&oReadAhead->sMutex);
+      if (iMore)
+      {
+         while (oReadAhead->uCount == oReadAhead->uDepth)
+            pthread_cond_wait(&oReadAhead->sNotFull,
+                              &oReadAhead->sMutex);
+         oReadAhead->psItems[(oReadAhead->uHead + oReadAhead->uCount)
+                             % oReadAhead->uDepth] = sItem;
+         oReadAhead->uCount++;
+      }
+      else
+         oReadAhead->iEof = 1;
+      if (oReadAhead->uCount == 1 || oReadAhead->iEof)
+         ReadAhead_setReady(oReadAhead, 1);
+      pthread_cond_signal(&oReadAhead->sNotEmpty);
+      pthread_mutex_unlock(&oReadAhead->sMutex);
+   } while (iMore);
+
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+ReadAhead_T ReadAhead_new(FILE *psFile, size_t uDepth)
+{
+   ReadAhead_T oReadAhead;
+   sigset_t sAllSignals;
+   sigset_t sOldMask;
+   int iRet;
+
+   assert(psFile != NULL);
+
+   oReadAhead = (struct ReadAhead*)malloc(sizeof(struct ReadAhead));
+   if (oReadAhead == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   oReadAhead->psFile = psFile;
+   oReadAhead->uDepth = uDepth;
+   oReadAhead->psItems = NULL;
+   oReadAhead->uHead = 0;
+   oReadAhead->uCount = 0;
+   oReadAhead->iEof = 0;
+   oReadAhead->oSpareTokens = DynArray_new(0);
+   if (oReadAhead->oSpareTokens == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   if (uDepth == 0)
+      return oReadAhead;
+
+   oReadAhead->psItems = (struct ReadAheadItem*)
+      calloc(uDepth, sizeof(struct ReadAheadItem));
+   if (oReadAhead->psItems == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   pthread_mutex_init(&oReadAhead->sMutex, NULL);
+   pthread_cond_init(&oReadAhead->sNotEmpty, NULL);
+   pthread_cond_init(&oReadAhead->sNotFull, NULL);
+   oReadAhead->iReadyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (oReadAhead->iReadyFd == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   /* Signals must be delivered to the caller's thread, so the producer
+      starts with all of them blocked. */
+   sigfillset(&sAllSignals);
+   pthread_sigmask(SIG_SETMASK, &sAllSignals, &sOldMask);
+   iRet = pthread_create(&oReadAhead->sProducer, NULL,
+                         ReadAhead_produce, oReadAhead);
+   pthread_sigmask(SIG_SETMASK, &sOldMask, NULL);
+   if (iRet != 0)
+      {errno = iRet; perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   return oReadAhead;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pvTokens, an empty token DynArray object.  pvExtra is
+   unused. */
+
+static void ReadAhead_freeTokens(void *pvTokens, void *pvExtra)
+{
+   assert(pvTokens != NULL);
+
+   DynArray_free((DynArray_T)pvTokens);
+}
+
+/*--------------------------------------------------------------------*/
+
+void ReadAhead_free(ReadAhead_T oReadAhead)
+{
+   assert(oReadAhead != NULL);
+
+   if (oReadAhead->uDepth > 0)
+   {
+      pthread_join(oReadAhead->sProducer, NULL);
+      assert(oReadAhead->uCount == 0);
+      pthread_mutex_destroy(&oReadAhead->sMutex);
+      pthread_cond_destroy(&oReadAhead->sNotEmpty);
+      pthread_cond_destroy(&oReadAhead->sNotFull);
+      close(oReadAhead->iReadyFd);
+      free(oReadAhead->psItems);
+   }
+   DynArray_map(oReadAhead->oSpareTokens, ReadAhead_freeTokens, NULL);
+   DynArray_free(oReadAhead->oSpareTokens);
+   free(oReadAhead);
+}
+
+/*--------------------------------------------------------------------*/
+
+int ReadAhead_next(ReadAhead_T oReadAhead, char **ppcLine,
+                   DynArray_T *poTokens, Command_T *poCommand,
+                   const char **ppcError)
+{
+   struct ReadAheadItem sItem;
+
+   assert(oReadAhead != NULL);
+   assert(ppcLine != NULL);
+   assert(poTokens != NULL);
+   assert(poCommand != NULL);
+   assert(ppcError != NULL);
+
+   if (oReadAhead->uDepth == 0)
+   {
+      if (! ReadAhead_readItem(oReadAhead, &sItem))
+         return 0;
+   }
+   else
+   {
+      pthread_mutex_lock(&oReadAhead->sMutex);
+      while (oReadAhead->uCount == 0 && ! oReadAhead->iEof)
+         pthread_cond_wait(&oReadAhead->sNotEmpty,
+                           &oReadAhead->sMutex);
+      if (oReadAhead->uCount == 0)
+      {
+         pthread_mutex_unlock(&oReadAhead->sMutex);
+         return 0;
+      }
+      sItem = oReadAhead->psItems[oReadAhead->uHead];
+      oReadAhead->uHead = (oReadAhead->uHead + 1) % oReadAhead->uDepth;
+      oReadAhead->uCount--;
+      if (oReadAhead->uCount == 0 && ! oReadAhead->iEof)
+         ReadAhead_setReady(oReadAhead, 0);
+      pthread_cond_signal(&oReadAhead->sNotFull);
+      pthread_mutex_unlock(&oReadAhead->sMutex);
+   }
+
+   *ppcLine = sItem.pcLine;
+   *poTokens = sItem.oTokens;
+   *poCommand = sItem.oCommand;
+   *ppcError = sItem.pcError;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int ReadAhead_getFd(ReadAhead_T oReadAhead)
+{
+   assert(oReadAhead != NULL);
+
+   if (oReadAhead->uDepth == 0)
+      return fileno(oReadAhead->psFile);
+   return oReadAhead->iReadyFd;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ReadAhead_recycle(ReadAhead_T oReadAhead, DynArray_T oTokens)
+{
+   int iKept = 0;
+
+   assert(oReadAhead != NULL);
+   assert(oTokens != NULL);
+
+   /* Let a DynArray object that held an unusually long line give back
+      its memory. */
+   if (DynArray_getLength(oTokens) > MAX_SPARE_LENGTH)
+   {
+      DynArray_clear(oTokens);
+      DynArray_shrinkToFit(oTokens);
+   }
+   else DynArray_clear(oTokens);
+
+   if (oReadAhead->uDepth > 0)
+      pthread_mutex_lock(&oReadAhead->sMutex);
+   if (DynArray_getLength(oReadAhead->oSpareTokens) <
+       oReadAhead->uDepth + MAX_SPARE_TOKENS)
+      iKept = DynArray_add(oReadAhead->oSpareTokens, oTokens);
+   if (oReadAhead->uDepth > 0)
+      pthread_mutex_unlock(&oReadAhead->sMutex);
+
+   if (! iKept)
+      DynArray_free(oTokens);
+}
@@ -0,0 +1,71 @@
+/*--------------------------------------------------------------------*/
+/* readAhead.h                                                        */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef READAHEAD_INCLUDED
+#define READAHEAD_INCLUDED
+
+#include <stdio.h>
+#include "dynarray.h"
+#include "command.h"
+
+/* A ReadAhead_T object reads lines from a file and lexically and
+   syntactically analyzes them, possibly ahead of the caller's
+   requests. */
+
+typedef struct ReadAhead *ReadAhead_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new ReadAhead_T object that reads lines from psFile.  If
+   uDepth is 0, then each line is read and analyzed only when it is
+   requested.  Otherwise a producer thread reads and analyzes up to
+   uDepth lines ahead of the caller.  Lines that expand variables,
+   commands or patterns (see LexAnalyzer_needsExpansion) are left to
+   the caller to analyze, one command at a time, so that each command
+   sees the effects of the commands before it.  Analysis never writes
+   to stderr; errors are reported through ReadAhead_next instead. */
+
+ReadAhead_T ReadAhead_new(FILE *psFile, size_t uDepth);
+
+/*--------------------------------------------------------------------*/
+
+/* Wait for the producer of oReadAhead to reach end-of-file, and free
+   oReadAhead. */
+
+void ReadAhead_free(ReadAhead_T oReadAhead);
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in oReadAhead, then return 0 (FALSE).  Otherwise
+   assign the next line to *ppcLine, its tokens (or NULL) to *poTokens,
+   its command (or NULL) to *poCommand, and a description of its
+   lexical or syntactic error (or NULL) to *ppcError, and return
+   1 (TRUE).  If the line is left to the caller to analyze, then the
+   tokens, the command and the error are all NULL.  The caller owns
+   the line, the tokens, and the command. */
+
+int ReadAhead_next(ReadAhead_T oReadAhead, char **ppcLine,
+                   DynArray_T *poTokens, Command_T *poCommand,
+                   const char **ppcError);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a file descriptor that is ready for reading when the next
+   call of ReadAhead_next for oReadAhead will not wait for a producer
+   thread: the eventfd of the producer, or if there is none, the file
+   descriptor of the file, which must then deliver at most one line
+   per read, as a terminal does. */
+
+int ReadAhead_getFd(ReadAhead_T oReadAhead);
+
+/*--------------------------------------------------------------------*/
+
+/* Give oTokens, which ReadAhead_next returned and whose tokens the
+   caller has freed, back to oReadAhead, which reuses it for a later
+   line rather than allocating another. */
+
+void ReadAhead_recycle(ReadAhead_T oReadAhead, DynArray_T oTokens);
+
+#endif
@@ -0,0 +1,145 @@
+/*--------------------------------------------------------------------*/
+/* signals.c                                                          */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "signals.h"
+#include "ish.h"
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of seconds within which a second SIGINT tells the user
+   how to exit the shell. */
+
+enum {EXIT_HINT_SECONDS = 5};
+
+/*--------------------------------------------------------------------*/
+
+/* The signals that the module handles. */
+
+static sigset_t sSignals;
+
+/* The signalfd, or -1 before Signals_install and after
+   Signals_resetInChild. */
+
+static int iSignalFd = -1;
+
+/* The state of the shell. */
+
+static enum SignalsState eShellState = SIGNALS_IDLE;
+
+/*--------------------------------------------------------------------*/
+
+/* Handle signal iSig. */
+
+static void Signals_handle(int iSig)
+{
+   switch (iSig)
+   {
+      case SIGINT:
+         if (eShellState == SIGNALS_BUSY)
+            break;
+         /* If within 5 seconds, print message. */
+         if (alarm(0) > 0)
+         {
+            printf("To exit the shell, issue an 'exit' command\n");
+            fflush(stdout);
+         }
+         alarm(EXIT_HINT_SECONDS);
+         break;
+
+      case SIGALRM:
+         printf("Alarm handler triggered!\n");
+         fflush(stdout);
+         break;
+
+      default:
+         /* Child processes are watched through their pidfds. */
+         break;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void Signals_install(void)
+{
+   struct sigaction sAction;
+
+   /* Signals that the shell inherited as ignored would be discarded
+      rather than queued, and ignoring SIGCHLD would reap children
+      behind the shell's back, so restore the default actions. */
+   sAction.sa_handler = SIG_DFL;
+   sigemptyset(&sAction.sa_mask);
+   sAction.sa_flags = 0;
+   if (sigaction(SIGINT, &sAction, NULL) == -1 ||
+       sigaction(SIGALRM, &sAction, NULL) == -1 ||
+       sigaction(SIGCHLD, &sAction, NULL) == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   sigemptyset(&sSignals);
+   sigaddset(&sSignals, SIGINT);
+   sigaddset(&sSignals, SIGALRM);
+   sigaddset(&sSignals, SIGCHLD);
+   if (sigprocmask(SIG_BLOCK, &sSignals, NULL) == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   iSignalFd = signalfd(-1, &sSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+   if (iSignalFd == -1)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+int Signals_getFd(void)
+{
+   assert(iSignalFd != -1);
+
+   return iSignalFd;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Signals_setState(enum SignalsState eState)
+{
+   assert(eState == SIGNALS_IDLE || eState == SIGNALS_BUSY);
+
+   eShellState = eState;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Signals_dispatch(void)
+{
+   enum {MAX_SIGNALS = 8};
+   struct signalfd_siginfo asInfo[MAX_SIGNALS];
+   ssize_t lBytes;
+   size_t uCount;
+   size_t u;
+
+   assert(iSignalFd != -1);
+
+   while ((lBytes = read(iSignalFd, asInfo, sizeof(asInfo))) > 0)
+   {
+      uCount = (size_t)lBytes / sizeof(asInfo[0]);
+      for (u = 0; u < uCount; u++)
+         Signals_handle((int)asInfo[u].ssi_signo);
+   }
+   if (lBytes == -1 && errno != EAGAIN && errno != EINTR)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+void Signals_resetInChild(void)
+{
+   sigprocmask(SIG_UNBLOCK, &sSignals, NULL);
+   close(iSignalFd);
+   iSignalFd = -1;
+}
@@ -0,0 +1,58 @@
+/*--------------------------------------------------------------------*/
+/* signals.h                                                          */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef SIGNALS_INCLUDED
+#define SIGNALS_INCLUDED
+
+/* The Signals module blocks SIGINT, SIGALRM and SIGCHLD, and accepts
+   them instead through a signalfd, which the shell's event loop
+   watches.  The signals are thus handled outside of signal context,
+   one at a time, like any other event. */
+
+/*--------------------------------------------------------------------*/
+
+/* The states of the shell, which determine how SIGINT is handled. */
+
+enum SignalsState {SIGNALS_IDLE, SIGNALS_BUSY};
+
+/*--------------------------------------------------------------------*/
+
+/* Block the signals and create the signalfd.  The shell starts in
+   state SIGNALS_IDLE.  Signals_install must be called before the
+   program creates any threads. */
+
+void Signals_install(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the signalfd, which is ready for reading when signals have
+   arrived. */
+
+int Signals_getFd(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Set the state of the shell to eState.  In state SIGNALS_IDLE, a
+   SIGINT tells the user how to exit the shell if it comes within 5
+   seconds of the one before.  In state SIGNALS_BUSY, in which the
+   shell runs a command, SIGINT is ignored. */
+
+void Signals_setState(enum SignalsState eState);
+
+/*--------------------------------------------------------------------*/
+
+/* Handle the signals that have arrived since the last call, without
+   waiting for more. */
+
+void Signals_dispatch(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Unblock the signals and close the signalfd.  A child process calls
+   it before it executes a command. */
+
+void Signals_resetInChild(void);
+
+#endif
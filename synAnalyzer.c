@@ -12,11 +12,28 @@
 
 /*--------------------------------------------------------------------*/
 
-/* Syntactically analyze dynamic array oTokens. If oTokens contains a 
-   syntactic error, then return NULL.  Otherwise return a Command 
-   object. */
+/* Return 1 (TRUE) iff oToken joins commands into a list. */
 
-Command_T SynAnalyzer_synTokens(DynArray_T oTokens)
+static int SynAnalyzer_isJoin(Token_T oToken)
+{
+   enum TokenOp eOp = Token_getOp(oToken);
+
+   return eOp == TOKEN_OP_SEQUENCE || eOp == TOKEN_OP_AND ||
+      eOp == TOKEN_OP_OR;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Syntactically analyze the command that starts at index *pulInd of
+   dynamic array oTokens, and ends before the next token that joins
+   commands, or at the end of oTokens.  If the command contains a
+   syntactic error, then assign a description of the error to
+   *ppcError and return NULL.  Otherwise assign the index of the token
+   that ends the command to *pulInd, and return a Command object. */
+
+static Command_T SynAnalyzer_synCommand(DynArray_T oTokens,
+                                        size_t *pulInd,
+                                        const char **ppcError)
 {
    size_t ulInd; /* Index iterator. */
    size_t ulLen; /* Length of oTokens. */
@@ -28,50 +45,52 @@ Command_T SynAnalyzer_synTokens(DynArray_T oTokens)
    char* pcStdIn = NULL;
    char* pcStdOut = NULL;
    DynArray_T oArgs = NULL;
+   DynArray_Storage sArgsStorage; /* Keeps short oArgs off the heap. */
    
    assert(oTokens != NULL);
+   assert(pulInd != NULL);
+   assert(ppcError != NULL);
 
-   /* Handle empty input. */
-   if (DynArray_getLength(oTokens) == 0) return NULL;
-
-
-   /* Ensures oTokens must begin with an ordinary token. */
+   /* Ensures the command must begin with an ordinary token. */
    ulLen = DynArray_getLength(oTokens);
-   oToken = DynArray_get(oTokens, 0);
-   if (Token_getType(oToken) != TOKEN_ORDINARY)
+   ulInd = *pulInd;
+   if (ulInd == ulLen ||
+       Token_getType(DynArray_get(oTokens, ulInd)) != TOKEN_ORDINARY)
    {
-      fprintf(stderr, "%s: missing command name\n", getPgmName());
+      *ppcError = "missing command name";
       return NULL;
    }
-   pcName = Token_getString(oToken);
+   pcName = Token_getString(DynArray_get(oTokens, ulInd));
    
-   for (ulInd = 1; ulInd < ulLen; ulInd++)
+   for (ulInd++; ulInd < ulLen; ulInd++)
    {
       oToken = DynArray_get(oTokens, ulInd);
 
-      /* Handle special tokens. */
-      if (Token_getType(oToken) == TOKEN_SPECIAL)
+      /* A token that joins commands ends this one. */
+      if (SynAnalyzer_isJoin(oToken))
+         break;
+
+      /* Handle each token by the operator that it denotes. */
+      switch (Token_getOp(oToken))
       {
          /* If the token is '<', increment stdin counter. */
-         if (Token_isStdIn(oToken))
+         case TOKEN_OP_REDIRECT_IN:
          {
             ulStdInCount++;
             /* Check for multiple stdin-redirection. */
             if (ulStdInCount > 1)
             {
-               fprintf(stderr,
-                       "%s: multiple redirection of standard input\n",
-                       getPgmName());
-               if (oArgs != NULL) DynArray_free(oArgs);
+               *ppcError = "multiple redirection of standard input";
+               if (oArgs != NULL) DynArray_destroy(oArgs);
                return NULL;
             }
             /* Check if there is still a subsequent file name. */
-            if ( ulInd == (ulLen - 1) )
+            if ( ulInd == (ulLen - 1) ||
+                 SynAnalyzer_isJoin(DynArray_get(oTokens, ulInd + 1)) )
             {
-               fprintf(stderr,
-                       "%s: standard input redirection without file name\n",
-                       getPgmName());
-               if (oArgs != NULL) DynArray_free(oArgs);
+               *ppcError =
+                  "standard input redirection without file name";
+               if (oArgs != NULL) DynArray_destroy(oArgs);
                return NULL;
             }
             /* Get stdin file name. */
@@ -79,27 +98,26 @@ Command_T SynAnalyzer_synTokens(DynArray_T oTokens)
             oToken = DynArray_get(oTokens, ulInd);
             if (Token_getType(oToken) == TOKEN_ORDINARY)
             pcStdIn = Token_getString(oToken);
+            break;
          }
          /* If the token is '>', increment counter. */
-         else if (Token_isStdOut(oToken))
-         {  
+         case TOKEN_OP_REDIRECT_OUT:
+         {
             ulStdOutCount++;
             /* Check for multiple stdout-redirection. */
             if (ulStdOutCount > 1)
             {
-               fprintf(stderr,
-                       "%s: multiple redirection of standard output\n",
-                       getPgmName());
-               if (oArgs != NULL) DynArray_free(oArgs);
+               *ppcError = "multiple redirection of standard output";
+               if (oArgs != NULL) DynArray_destroy(oArgs);
                return NULL;
             }
             /* Check if there is still a subsequent file name. */
-            if ( ulInd == (ulLen - 1) )
+            if ( ulInd == (ulLen - 1) ||
+                 SynAnalyzer_isJoin(DynArray_get(oTokens, ulInd + 1)) )
             {
-               fprintf(stderr,
-                 "%s: standard output redirection without file name\n",
-                       getPgmName());
-               if (oArgs != NULL) DynArray_free(oArgs);
+               *ppcError =
+                  "standard output redirection without file name";
+               if (oArgs != NULL) DynArray_destroy(oArgs);
                return NULL;           
             }
             /* Get stdout file name. */
@@ -107,22 +125,27 @@ Command_T SynAnalyzer_synTokens(DynArray_T oTokens)
             oToken = DynArray_get(oTokens, ulInd);
             if (Token_getType(oToken) == TOKEN_ORDINARY)
                pcStdOut = Token_getString(oToken);
+            break;
          }
-         
-      }
-      /* Handle ordinary tokens. */
-      else if (Token_getType(oToken) == TOKEN_ORDINARY)
-      {
-         /* Initialise dynamic array for arguments. */
-         if (oArgs == NULL)
+         /* Reject special tokens such as "<<>". */
+         case TOKEN_OP_INVALID:
+         default:
+            *ppcError = "invalid special token";
+            if (oArgs != NULL) DynArray_destroy(oArgs);
+            return NULL;
+
+         /* Handle ordinary tokens. */
+         case TOKEN_OP_NONE:
          {
-            oArgs = DynArray_new(0);
+            /* Initialise dynamic array for arguments. */
             if (oArgs == NULL)
+               oArgs = DynArray_init(&sArgsStorage);
+
+            /* Add to oArgs. */
+            if (! DynArray_add(oArgs, Token_getString(oToken)))
             {perror(getPgmName()); exit(EXIT_FAILURE);}
+            break;
          }
-         
-         /* Add to oArgs. */
-         DynArray_add(oArgs, Token_getString(oToken));
       }
    }
 
@@ -131,7 +154,83 @@ Command_T SynAnalyzer_synTokens(DynArray_T oTokens)
    if (oCommand == NULL)
    {perror(getPgmName()); exit(EXIT_FAILURE);}
 
-   if (oArgs != NULL) DynArray_free(oArgs);
-      
+   if (oArgs != NULL) DynArray_destroy(oArgs);
+
+   *pulInd = ulInd;
+   return oCommand;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Syntactically analyze dynamic array oTokens without writing to
+   stderr.  If oTokens contains a syntactic error, then assign a
+   description of the error to *ppcError and return NULL.  If oTokens
+   is empty, then assign NULL to *ppcError and return NULL.  Otherwise
+   return the first Command object of the list of commands that
+   oTokens joins with ";", "&&" and "||".  The list may end with
+   ";". */
+
+Command_T SynAnalyzer_synTokensQuietly(DynArray_T oTokens,
+                                       const char **ppcError)
+{
+   size_t ulInd = 0; /* Index iterator. */
+   size_t ulLen; /* Length of oTokens. */
+   Command_T oFirst = NULL;
+   Command_T oLast = NULL;
+   Command_T oCommand;
+   enum CommandJoin eJoin = COMMAND_JOIN_NONE;
+
+   assert(oTokens != NULL);
+   assert(ppcError != NULL);
+
+   *ppcError = NULL;
+
+   /* Handle empty input. */
+   ulLen = DynArray_getLength(oTokens);
+   if (ulLen == 0) return NULL;
+
+   for (;;)
+   {
+      oCommand = SynAnalyzer_synCommand(oTokens, &ulInd, ppcError);
+      if (oCommand == NULL)
+      {
+         Command_free(oFirst);
+         return NULL;
+      }
+      if (oLast == NULL) oFirst = oCommand;
+      else Command_setNext(oLast, eJoin, oCommand);
+      oLast = oCommand;
+
+      /* Find how the next command, if any, is joined. */
+      if (ulInd == ulLen) break;
+      switch (Token_getOp(DynArray_get(oTokens, ulInd)))
+      {
+         case TOKEN_OP_AND: eJoin = COMMAND_JOIN_AND; break;
+         case TOKEN_OP_OR: eJoin = COMMAND_JOIN_OR; break;
+         default: eJoin = COMMAND_JOIN_SEQUENCE; break;
+      }
+      ulInd++;
+      if (ulInd == ulLen && eJoin == COMMAND_JOIN_SEQUENCE) break;
+   }
+   return oFirst;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Syntactically analyze dynamic array oTokens. If oTokens contains a 
+   syntactic error, then write a description of it to stderr and
+   return NULL.  Otherwise return the first Command object of the list
+   of commands that oTokens joins with ";", "&&" and "||". */
+
+Command_T SynAnalyzer_synTokens(DynArray_T oTokens)
+{
+   Command_T oCommand;
+   const char *pcError;
+
+   assert(oTokens != NULL);
+
+   oCommand = SynAnalyzer_synTokensQuietly(oTokens, &pcError);
+   if (pcError != NULL)
+      fprintf(stderr, "%s: %s\n", getPgmName(), pcError);
    return oCommand;
 }
@@ -18,9 +18,23 @@ void SynAnalyzer_freeElements(DynArray_T oTokens);
 /*--------------------------------------------------------------------*/
 
 /* Syntactically analyze dynamic array oTokens. If oTokens contains a 
-   syntactic error, then return NULL.  Otherwise return a Command 
-   object. */
+   syntactic error, then write a description of it to stderr and
+   return NULL.  Otherwise return the first Command object of the list
+   of commands that oTokens joins with ";", "&&" and "||". */
 
 Command_T SynAnalyzer_synTokens(DynArray_T oTokens);
 
+/*--------------------------------------------------------------------*/
+
+/* Syntactically analyze dynamic array oTokens without writing to
+   stderr.  If oTokens contains a syntactic error, then assign a
+   description of the error to *ppcError and return NULL.  If oTokens
+   is empty, then assign NULL to *ppcError and return NULL.  Otherwise
+   return the first Command object of the list of commands that
+   oTokens joins with ";", "&&" and "||" (see command.h).  The list
+   may end with ";". */
+
+Command_T SynAnalyzer_synTokensQuietly(DynArray_T oTokens,
+                                       const char **ppcError);
+
 #endif
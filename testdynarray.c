@@ -0,0 +1,662 @@
+/*--------------------------------------------------------------------*/
+/* testdynarray.c                                                     */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "dynarray.h"
+#include "dynarrayt.h"
+#include "concArray.h"
+#include "threadPool.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* These tests count the calls to the memory allocator, which they
+   intercept by defining malloc, calloc, realloc and free themselves on
+   top of the entry points of the GNU C library. */
+
+extern void *__libc_malloc(size_t uSize);
+extern void *__libc_calloc(size_t uCount, size_t uSize);
+extern void *__libc_realloc(void *pv, size_t uSize);
+extern void __libc_free(void *pv);
+
+/*--------------------------------------------------------------------*/
+
+/* The number of calls to malloc, calloc and realloc, and to free.
+   Worker threads allocate too, so the counters are atomic. */
+
+static atomic_ulong ulAllocs = 0;
+static atomic_ulong ulFrees = 0;
+
+/* 1 (TRUE) iff malloc is to fail. */
+
+static int iFailMalloc = 0;
+
+/* The name of the executable binary file. */
+
+static const char *pcPgmName;
+
+/* The number of failed checks. */
+
+static int iFailures = 0;
+
+/*--------------------------------------------------------------------*/
+
+void *malloc(size_t uSize)
+{
+   if (iFailMalloc)
+      return NULL;
+   atomic_fetch_add_explicit(&ulAllocs, 1, memory_order_relaxed);
+   return __libc_malloc(uSize);
+}
+
+void *calloc(size_t uCount, size_t uSize)
+{
+   atomic_fetch_add_explicit(&ulAllocs, 1, memory_order_relaxed);
+   return __libc_calloc(uCount, uSize);
+}
+
+void *realloc(void *pv, size_t uSize)
+{
+   atomic_fetch_add_explicit(&ulAllocs, 1, memory_order_relaxed);
+   return __libc_realloc(pv, uSize);
+}
+
+void free(void *pv)
+{
+   if (pv != NULL)
+      atomic_fetch_add_explicit(&ulFrees, 1, memory_order_relaxed);
+   __libc_free(pv);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If iCondition is 0 (FALSE), then report that the check described by
+   pcCheck, on line iLine, failed. */
+
+static void check(int iCondition, const char *pcCheck, int iLine)
+{
+   if (! iCondition)
+   {
+      fprintf(stderr, "%s: line %d: check failed: %s\n", pcPgmName,
+              iLine, pcCheck);
+      iFailures++;
+   }
+}
+
+#define CHECK(iCondition) check((iCondition), #iCondition, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a DynArray_T object in client storage allocates nothing
+   until it outgrows its inline elements. */
+
+static void testInline(void)
+{
+   DynArray_Storage sStorage;
+   DynArray_T oDynArray;
+   unsigned long ulBefore = ulAllocs;
+   size_t u;
+
+   oDynArray = DynArray_init(&sStorage);
+   for (u = 0; u < DYNARRAY_INLINE_LENGTH; u++)
+      DynArray_add(oDynArray, &sStorage);
+   CHECK(ulAllocs == ulBefore);
+
+   DynArray_add(oDynArray, &sStorage);
+   CHECK(ulAllocs == ulBefore + 1);
+   DynArray_destroy(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that adding up to the reserved number of elements, also after
+   DynArray_clear, allocates nothing. */
+
+static void testReserveAndClear(void)
+{
+   enum {LENGTH = 1000};
+   DynArray_T oDynArray;
+   unsigned long ulBefore;
+   size_t u;
+
+   oDynArray = DynArray_new(0);
+   ulBefore = ulAllocs;
+   CHECK(DynArray_reserve(oDynArray, LENGTH));
+   CHECK(ulAllocs == ulBefore + 1);
+
+   ulBefore = ulAllocs;
+   for (u = 0; u < LENGTH; u++)
+      DynArray_add(oDynArray, oDynArray);
+   CHECK(ulAllocs == ulBefore);
+
+   DynArray_clear(oDynArray);
+   CHECK(DynArray_getLength(oDynArray) == 0);
+   for (u = 0; u < LENGTH; u++)
+      DynArray_add(oDynArray, oDynArray);
+   CHECK(ulAllocs == ulBefore);
+   CHECK(DynArray_getLength(oDynArray) == LENGTH);
+
+   /* Reserving less than there is room for does nothing. */
+   CHECK(DynArray_reserve(oDynArray, LENGTH / 2));
+   CHECK(ulAllocs == ulBefore);
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that DynArray_addAll allocates at most once and keeps the
+   order of the elements. */
+
+static void testAddAll(void)
+{
+   enum {LENGTH = 1000};
+   DynArray_T oDynArray;
+   DynArray_T oOther;
+   unsigned long ulBefore;
+   size_t u;
+   int iInOrder = 1;
+
+   oDynArray = DynArray_new(0);
+   oOther = DynArray_new(0);
+   DynArray_add(oDynArray, (void*)1);
+   for (u = 0; u < LENGTH; u++)
+      DynArray_add(oOther, (void*)(u + 2));
+
+   ulBefore = ulAllocs;
+   CHECK(DynArray_addAll(oDynArray, oOther));
+   CHECK(ulAllocs == ulBefore + 1);
+   CHECK(DynArray_getLength(oDynArray) == LENGTH + 1);
+   for (u = 0; u < LENGTH + 1; u++)
+      if (DynArray_get(oDynArray, u) != (void*)(u + 1))
+         iInOrder = 0;
+   CHECK(iInOrder);
+
+   DynArray_free(oOther);
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that DynArray_shrinkToFit gives memory back, and returns short
+   arrays to their inline elements. */
+
+static void testShrinkToFit(void)
+{
+   enum {LENGTH = 1000};
+   DynArray_T oDynArray;
+   unsigned long ulBefore;
+   size_t u;
+
+   oDynArray = DynArray_new(0);
+   for (u = 0; u < LENGTH; u++)
+      DynArray_add(oDynArray, (void*)u);
+   while (DynArray_getLength(oDynArray) > 2)
+      DynArray_removeAt(oDynArray, 0);
+
+   ulBefore = ulFrees;
+   DynArray_shrinkToFit(oDynArray);
+   CHECK(ulFrees == ulBefore + 1);
+   CHECK(DynArray_getLength(oDynArray) == 2);
+   CHECK(DynArray_get(oDynArray, 0) == (void*)(LENGTH - 2));
+   CHECK(DynArray_get(oDynArray, 1) == (void*)(LENGTH - 1));
+
+   ulBefore = ulAllocs;
+   for (u = 2; u < DYNARRAY_INLINE_LENGTH; u++)
+      DynArray_add(oDynArray, (void*)u);
+   CHECK(ulAllocs == ulBefore);
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that growth is geometric, and that a queue that adds at one end
+   and removes at the other reuses its memory. */
+
+static void testGrowth(void)
+{
+   enum {LENGTH = 100000, MAX_ALLOCS = 16};
+   DynArray_T oDynArray;
+   unsigned long ulBefore;
+   size_t u;
+
+   oDynArray = DynArray_new(0);
+   ulBefore = ulAllocs;
+   for (u = 0; u < LENGTH; u++)
+      DynArray_add(oDynArray, (void*)u);
+   CHECK(ulAllocs - ulBefore <= MAX_ALLOCS);
+
+   ulBefore = ulAllocs;
+   for (u = 0; u < LENGTH; u++)
+   {
+      DynArray_add(oDynArray, (void*)u);
+      DynArray_removeAt(oDynArray, 0);
+   }
+   CHECK(ulAllocs - ulBefore <= 1);
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The number of calls to compareInts. */
+
+static unsigned long ulIntComparisons = 0;
+
+/* Compare the ints at pvElement1 and pvElement2. */
+
+static int compareInts(const void *pvElement1, const void *pvElement2)
+{
+   int i1 = *(const int*)pvElement1;
+   int i2 = *(const int*)pvElement2;
+
+   ulIntComparisons++;
+   return (i1 > i2) - (i1 < i2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the ints that oDynArray points to are in
+   order. */
+
+static int isSortedInts(DynArray_T oDynArray)
+{
+   size_t u;
+
+   for (u = 1; u < DynArray_getLength(oDynArray); u++)
+      if (compareInts(DynArray_get(oDynArray, u - 1),
+                      DynArray_get(oDynArray, u)) > 0)
+         return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that DynArray_sort sorts runs in order and in reverse order,
+   patterns of them and random input with duplicates, taking
+   advantage of the runs, and that it still sorts when it cannot
+   allocate memory. */
+
+static void testSort(void)
+{
+   enum {LENGTH = 10000, PATTERNS = 4};
+   static int aiValues[LENGTH];
+   DynArray_T oDynArray;
+   int iPattern;
+   size_t u;
+
+   oDynArray = DynArray_new(LENGTH);
+   for (iPattern = 0; iPattern < PATTERNS; iPattern++)
+   {
+      DynArray_clear(oDynArray);
+      for (u = 0; u < LENGTH; u++)
+      {
+         switch (iPattern)
+         {
+            case 0: aiValues[u] = (int)u; break;
+            case 1: aiValues[u] = LENGTH - (int)u; break;
+            case 2: aiValues[u] = (int)(u < LENGTH / 2 ? u :
+                                        LENGTH - u); break;
+            default: aiValues[u] = rand() % 100; break;
+         }
+         DynArray_add(oDynArray, &aiValues[u]);
+      }
+      DynArray_sort(oDynArray, compareInts);
+      CHECK(isSortedInts(oDynArray));
+   }
+
+   /* Organ-pipe input is two runs, so sorting it compares each
+      element about twice. */
+   for (u = 0; u < LENGTH; u++)
+   {
+      aiValues[u] = (int)(u < LENGTH / 2 ? u : LENGTH - u);
+      DynArray_set(oDynArray, u, &aiValues[u]);
+   }
+   ulIntComparisons = 0;
+   DynArray_sort(oDynArray, compareInts);
+   CHECK(ulIntComparisons <= 3 * LENGTH);
+
+   for (u = 0; u < LENGTH; u++)
+      DynArray_set(oDynArray, u, &aiValues[(u * 7919) % LENGTH]);
+   iFailMalloc = 1;
+   DynArray_sort(oDynArray, compareInts);
+   iFailMalloc = 0;
+   CHECK(isSortedInts(oDynArray));
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the number that the string pvKey spells with the int at
+   pvElement, as DynArray_bsearch calls it: key first.  Called the
+   other way around, it would read an int as a string. */
+
+static int compareKeyFirst(const void *pvKey, const void *pvElement)
+{
+   return atoi((const char*)pvKey) - *(const int*)pvElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that DynArray_bsearch, DynArray_lowerBound and
+   DynArray_bsearchBatch find elements and pass the sought element to
+   the comparison function first. */
+
+static void testSearch(void)
+{
+   enum {LENGTH = 1000};
+   static int aiEvens[LENGTH];
+   char *apcKeys[] = {"0", "5", "998", "1998", "1999", "-1"};
+   size_t auIndices[sizeof(apcKeys) / sizeof(apcKeys[0])];
+   DynArray_T oDynArray;
+   size_t uIndex;
+   size_t u;
+
+   oDynArray = DynArray_new(0);
+   for (u = 0; u < LENGTH; u++)
+   {
+      aiEvens[u] = 2 * (int)u;
+      DynArray_add(oDynArray, &aiEvens[u]);
+   }
+
+   CHECK(DynArray_bsearch(oDynArray, "998", &uIndex,
+                          compareKeyFirst) && uIndex == 499);
+   CHECK(! DynArray_bsearch(oDynArray, "5", &uIndex, compareKeyFirst));
+   CHECK(DynArray_lowerBound(oDynArray, "5", compareKeyFirst) == 3);
+   CHECK(DynArray_lowerBound(oDynArray, "1999", compareKeyFirst) ==
+         LENGTH);
+
+   CHECK(DynArray_bsearchBatch(oDynArray, (void**)apcKeys,
+                               sizeof(apcKeys) / sizeof(apcKeys[0]),
+                               auIndices, compareKeyFirst) == 3);
+   CHECK(auIndices[0] == 0 && auIndices[1] == DYNARRAY_NOT_FOUND &&
+         auIndices[2] == 499 && auIndices[3] == LENGTH - 1 &&
+         auIndices[4] == DYNARRAY_NOT_FOUND &&
+         auIndices[5] == DYNARRAY_NOT_FOUND);
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A span of a line, which SpanArray stores by value. */
+
+struct Span
+{
+   size_t uStart;
+   size_t uLength;
+};
+
+/* Compare the spans at psSpan1 and psSpan2 by start, and then by
+   length. */
+
+static inline int compareSpans(const struct Span *psSpan1,
+                               const struct Span *psSpan2)
+{
+   if (psSpan1->uStart != psSpan2->uStart)
+      return (psSpan1->uStart > psSpan2->uStart) ? 1 : -1;
+   return (psSpan1->uLength > psSpan2->uLength) -
+      (psSpan1->uLength < psSpan2->uLength);
+}
+
+#define SPAN_COMPARE(psSpan1, psSpan2, iUnused) \
+   ((void)(iUnused), compareSpans((psSpan1), (psSpan2)))
+
+DYNARRAY_DEFINE(SpanArray, struct Span, 4)
+DYNARRAY_DEFINE_SORT(SpanArray, struct Span, int, SPAN_COMPARE)
+
+/*--------------------------------------------------------------------*/
+
+/* Test that an array generated by DYNARRAY_DEFINE for a structure
+   type stores its elements by value, grows past its inline elements,
+   adds and removes at either end, and sorts and searches with an
+   inlined comparison. */
+
+static void testByValue(void)
+{
+   enum {LENGTH = 1000};
+   SpanArray sSpans;
+   struct Span sSpan;
+   struct Span asSought[3];
+   size_t auIndices[3];
+   size_t uIndex;
+   int iInOrder = 1;
+   size_t u;
+
+   SpanArray_init(&sSpans);
+   for (u = 0; u < LENGTH; u++)
+   {
+      /* Starts 0, 2, 4, ... in a shuffled order. */
+      sSpan.uStart = 2 * ((u * 7919) % LENGTH);
+      sSpan.uLength = u;
+      CHECK(SpanArray_add(&sSpans, sSpan));
+   }
+   sSpan.uLength = 0;
+   CHECK(SpanArray_getLength(&sSpans) == LENGTH);
+   CHECK(SpanArray_get(&sSpans, 1).uStart == 2 * 7919 % (2 * LENGTH));
+
+   /* The array holds copies, not the variable that was added. */
+   sSpan.uStart = 1;
+   CHECK(SpanArray_addAt(&sSpans, 0, sSpan));
+   sSpan.uStart = 3;
+   CHECK(SpanArray_get(&sSpans, 0).uStart == 1);
+   CHECK(SpanArray_removeAt(&sSpans, 0).uStart == 1);
+   CHECK(SpanArray_isValid(&sSpans));
+
+   SpanArray_sort(&sSpans, 0);
+   for (u = 0; u < LENGTH; u++)
+      if (SpanArray_get(&sSpans, u).uStart != 2 * u)
+         iInOrder = 0;
+   CHECK(iInOrder);
+
+   sSpan = SpanArray_get(&sSpans, 500);
+   CHECK(SpanArray_bsearch(&sSpans, &sSpan, &uIndex, 0) &&
+         uIndex == 500);
+   CHECK(SpanArray_search(&sSpans, &sSpan, &uIndex, 0) &&
+         uIndex == 500);
+   sSpan.uStart = 3;
+   CHECK(! SpanArray_bsearch(&sSpans, &sSpan, &uIndex, 0));
+   CHECK(SpanArray_lowerBound(sSpans.pxArray, LENGTH, &sSpan, 0) == 2);
+
+   asSought[0] = SpanArray_get(&sSpans, 0);
+   asSought[1] = sSpan;
+   asSought[2].uStart = 2 * LENGTH;
+   asSought[2].uLength = 0;
+   SpanArray_lowerBoundBatch(sSpans.pxArray, LENGTH, asSought, 3,
+                             auIndices, 0);
+   CHECK(auIndices[0] == 0 && auIndices[1] == 2 &&
+         auIndices[2] == LENGTH);
+   SpanArray_destroy(&sSpans);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increment each of the counters pvCounters[uLo...uHi-1]. */
+
+static void countRange(size_t uLo, size_t uHi, void *pvCounters)
+{
+   size_t u;
+
+   for (u = uLo; u < uHi; u++)
+      __atomic_fetch_add(&((int*)pvCounters)[u], 1, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the integer at pvElement.  pvExtra is unused. */
+
+static void increment(void *pvElement, void *pvExtra)
+{
+   (*(int*)pvElement)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the sum of the accumulator pvSum and the integer at
+   pvElement.  pvExtra is unused. */
+
+static void *addElement(void *pvSum, void *pvElement, void *pvExtra)
+{
+   return (void*)((size_t)pvSum + (size_t)*(int*)pvElement);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the sum of pvLeft and pvRight.  pvExtra is unused. */
+
+static void *addSums(void *pvLeft, void *pvRight, void *pvExtra)
+{
+   return (void*)((size_t)pvLeft + (size_t)pvRight);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return pvFirst unless it is NULL, and pvElement otherwise, which
+   keeps the first element of a reduction.  pvExtra is unused. */
+
+static void *keepFirst(void *pvFirst, void *pvElement, void *pvExtra)
+{
+   return (pvFirst != NULL) ? pvFirst : pvElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a ThreadPool with workers runs every iteration exactly
+   once, and that DynArray_parallelMap and DynArray_parallelReduce
+   agree with their serial counterparts and keep the order of the
+   elements. */
+
+static void testParallel(void)
+{
+   enum {LENGTH = 100000, WORKERS = 4, GRAIN = 100};
+   ThreadPool_T oThreadPool;
+   DynArray_T oDynArray;
+   int *piCounters;
+   int iAllOnce = 1;
+   size_t uExpected = 0;
+   size_t u;
+
+   piCounters = (int*)calloc(LENGTH, sizeof(int));
+   oThreadPool = ThreadPool_new(WORKERS);
+   CHECK(oThreadPool != NULL);
+   CHECK(ThreadPool_getThreads(oThreadPool) == WORKERS + 1);
+   ThreadPool_run(oThreadPool, LENGTH, 7, countRange, piCounters);
+   ThreadPool_run(oThreadPool, LENGTH, 1, countRange, piCounters);
+   for (u = 0; u < LENGTH; u++)
+      if (piCounters[u] != 2)
+         iAllOnce = 0;
+   CHECK(iAllOnce);
+   ThreadPool_free(oThreadPool);
+
+   oDynArray = DynArray_new(0);
+   for (u = 0; u < LENGTH; u++)
+   {
+      piCounters[u] = (int)u;
+      DynArray_add(oDynArray, &piCounters[u]);
+      uExpected += u + 1;
+   }
+   DynArray_parallelMap(oDynArray, increment, NULL, GRAIN);
+   CHECK(DynArray_parallelReduce(oDynArray, NULL, addElement, addSums,
+                                 NULL, GRAIN) == (void*)uExpected);
+   CHECK(DynArray_parallelReduce(oDynArray, NULL, keepFirst, keepFirst,
+                                 NULL, GRAIN) == &piCounters[0]);
+   CHECK(DynArray_parallelReduce(oDynArray, NULL, keepFirst, keepFirst,
+                                 NULL, 0) == &piCounters[0]);
+
+   DynArray_clear(oDynArray);
+   CHECK(DynArray_parallelReduce(oDynArray, &iFailures, addElement,
+                                 addSums, NULL, GRAIN) == &iFailures);
+   DynArray_free(oDynArray);
+   free(piCounters);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The elements that testConcurrentAdd adds: the addresses of the
+   bytes of acSlots. */
+
+enum {SLOTS = 100000};
+static char acSlots[SLOTS];
+
+/*--------------------------------------------------------------------*/
+
+/* Add &acSlots[uLo] ... &acSlots[uHi-1] to the ConcArray_T object
+   pvConcArray. */
+
+static void addRange(size_t uLo, size_t uHi, void *pvConcArray)
+{
+   size_t u;
+
+   for (u = uLo; u < uHi; u++)
+      if (! ConcArray_add((ConcArray_T)pvConcArray, &acSlots[u]))
+         iFailures++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that threads adding to a ConcArray_T object at the same time
+   each get their own slot, and that ConcArray_freeze keeps every
+   element. */
+
+static void testConcurrentAdd(void)
+{
+   enum {WORKERS = 4};
+   ThreadPool_T oThreadPool;
+   ConcArray_T oConcArray;
+   DynArray_T oDynArray;
+   char *pcSeen;
+   int iAllOnce = 1;
+   size_t u;
+
+   pcSeen = (char*)calloc(SLOTS, 1);
+   oThreadPool = ThreadPool_new(WORKERS);
+   oConcArray = ConcArray_new();
+   CHECK(oConcArray != NULL);
+   ThreadPool_run(oThreadPool, SLOTS, 1, addRange, oConcArray);
+   CHECK(ConcArray_getLength(oConcArray) == SLOTS);
+   ThreadPool_free(oThreadPool);
+
+   oDynArray = ConcArray_freeze(oConcArray);
+   CHECK(oDynArray != NULL);
+   CHECK(DynArray_getLength(oDynArray) == SLOTS);
+   for (u = 0; u < SLOTS; u++)
+      pcSeen[(char*)DynArray_get(oDynArray, u) - acSlots]++;
+   for (u = 0; u < SLOTS; u++)
+      if (pcSeen[u] != 1)
+         iAllOnce = 0;
+   CHECK(iAllOnce);
+   DynArray_free(oDynArray);
+   free(pcSeen);
+
+   oDynArray = ConcArray_freeze(ConcArray_new());
+   CHECK(DynArray_getLength(oDynArray) == 0);
+   DynArray_free(oDynArray);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the tests, and write to stderr the checks that fail.  Return 0
+   iff all succeed. */
+
+int main(int argc, char *argv[])
+{
+   pcPgmName = argv[0];
+
+   testInline();
+   testReserveAndClear();
+   testAddAll();
+   testShrinkToFit();
+   testGrowth();
+   testSort();
+   testSearch();
+   testByValue();
+   testParallel();
+   testConcurrentAdd();
+
+   if (iFailures > 0)
+   {
+      fprintf(stderr, "%s: %d checks failed\n", pcPgmName, iFailures);
+      return EXIT_FAILURE;
+   }
+   printf("%s: all checks passed\n", pcPgmName);
+   return 0;
+}
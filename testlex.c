@@ -0,0 +1,506 @@
+/*--------------------------------------------------------------------*/
+/* testlex.c                                                          */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "dynarray.h"
+#include "command.h"
+#include "lexAnalyzer.h"
+#include "synAnalyzer.h"
+#include "token.h"
+#include "wildcard.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* These tests of the lexical, syntactic and wildcard modules count
+   the calls to the memory allocator, which they intercept by defining
+   malloc, calloc and realloc themselves on top of the entry points of
+   the GNU C library. */
+
+extern void *__libc_malloc(size_t uSize);
+extern void *__libc_calloc(size_t uCount, size_t uSize);
+extern void *__libc_realloc(void *pv, size_t uSize);
+
+/*--------------------------------------------------------------------*/
+
+/* The number of calls to malloc, calloc and realloc.  Worker
+   threads allocate too, so the counter is atomic. */
+
+static atomic_ulong ulAllocs = 0;
+
+/* The name of the executable binary file. */
+
+static const char *pcPgmName;
+
+/* The number of failed checks. */
+
+static int iFailures = 0;
+
+/*--------------------------------------------------------------------*/
+
+void *malloc(size_t uSize)
+{
+   atomic_fetch_add_explicit(&ulAllocs, 1, memory_order_relaxed);
+   return __libc_malloc(uSize);
+}
+
+void *calloc(size_t uCount, size_t uSize)
+{
+   atomic_fetch_add_explicit(&ulAllocs, 1, memory_order_relaxed);
+   return __libc_calloc(uCount, uSize);
+}
+
+void *realloc(void *pv, size_t uSize)
+{
+   atomic_fetch_add_explicit(&ulAllocs, 1, memory_order_relaxed);
+   return __libc_realloc(pv, uSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of the program. */
+
+const char *getPgmName(void)
+{
+   return pcPgmName;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If iCondition is 0 (FALSE), then report that the check described by
+   pcCheck, on line iLine, failed. */
+
+static void check(int iCondition, const char *pcCheck, int iLine)
+{
+   if (! iCondition)
+   {
+      fprintf(stderr, "%s: line %d: check failed: %s\n", pcPgmName,
+              iLine, pcCheck);
+      iFailures++;
+   }
+}
+
+#define CHECK(iCondition) check((iCondition), #iCondition, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Test that lexing into a reused token DynArray_T object allocates
+   only the tokens and a work buffer. */
+
+static void testLexInto(void)
+{
+   DynArray_T oTokens;
+   const char *pcError;
+   unsigned long ulBefore;
+   int i;
+
+   oTokens = DynArray_new(0);
+   for (i = 0; i < 2; i++)
+   {
+      ulBefore = ulAllocs;
+      CHECK(LexAnalyzer_lexLineInto("cat < in > out", oTokens,
+                                    &pcError));
+      CHECK(DynArray_getLength(oTokens) == 5);
+
+      /* Each token allocates itself, and holds its short string. */
+      CHECK(ulAllocs == ulBefore + 1 + 5);
+      LexAnalyzer_freeTokens(oTokens);
+      DynArray_clear(oTokens);
+   }
+
+   /* A long token allocates its string as well. */
+   ulBefore = ulAllocs;
+   CHECK(LexAnalyzer_lexLineInto("cat averyverylongfilename", oTokens,
+                                 &pcError));
+   CHECK(ulAllocs == ulBefore + 1 + 2 + 1);
+   LexAnalyzer_freeTokens(oTokens);
+   DynArray_clear(oTokens);
+
+   CHECK(! LexAnalyzer_lexLineInto("echo \"oops", oTokens, &pcError));
+   CHECK(DynArray_getLength(oTokens) == 0);
+   DynArray_free(oTokens);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return "value" for the variable V, whose name is the uLength
+   characters at pcName, and NULL for any other.  pvExtra is unused. */
+
+static const char *lookUpTest(const char *pcName, size_t uLength,
+                              void *pvExtra)
+{
+   if (uLength == 1 && pcName[0] == 'V')
+      return "value";
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that variables expand within tokens and quotes, and that lines
+   without them cost no more to lex than before. */
+
+static void testExpand(void)
+{
+   DynArray_T oTokens;
+   const char *pcError;
+   unsigned long ulBefore;
+
+   oTokens = DynArray_new(0);
+   LexAnalyzer_setLookUp(lookUpTest, NULL);
+
+   /* Warm up oTokens, then lex a line without variables. */
+   CHECK(LexAnalyzer_lexLineInto("cat < in > out", oTokens, &pcError));
+   LexAnalyzer_freeTokens(oTokens);
+   DynArray_clear(oTokens);
+   ulBefore = ulAllocs;
+   CHECK(LexAnalyzer_lexLineInto("cat < in > out", oTokens, &pcError));
+   CHECK(ulAllocs == ulBefore + 1 + 5);
+   LexAnalyzer_freeTokens(oTokens);
+   DynArray_clear(oTokens);
+
+   /* An unset variable alone outside quotes leaves no token. */
+   CHECK(LexAnalyzer_lexLineInto("x$V ${V}y \"$NOPE\" $NOPE a$",
+                                 oTokens, &pcError));
+   CHECK(DynArray_getLength(oTokens) == 4);
+   if (DynArray_getLength(oTokens) == 4)
+   {
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 0)),
+                   "xvalue") == 0);
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 1)),
+                   "valuey") == 0);
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 2)),
+                   "") == 0);
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 3)),
+                   "a$") == 0);
+   }
+   LexAnalyzer_freeTokens(oTokens);
+   DynArray_clear(oTokens);
+
+   CHECK(! LexAnalyzer_lexLineInto("echo ${V", oTokens, &pcError));
+   CHECK(! LexAnalyzer_lexLineInto("echo ${}", oTokens, &pcError));
+
+   LexAnalyzer_setLookUp(NULL, NULL);
+   DynArray_free(oTokens);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the output "a  b" and two newlines for any command, with
+   its length in *puLength.  pcCommand, uLength and pvExtra are
+   unused. */
+
+static char *substituteTest(const char *pcCommand, size_t uLength,
+                            size_t *puLength, void *pvExtra)
+{
+   static const char acOutput[] = "a  b\n\n";
+   char *pcOutput;
+
+   pcOutput = (char*)malloc(sizeof(acOutput));
+   if (pcOutput == NULL) {perror(pcPgmName); exit(EXIT_FAILURE);}
+   memcpy(pcOutput, acOutput, sizeof(acOutput));
+   *puLength = sizeof(acOutput) - 1;
+   return pcOutput;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that command substitutions lose their trailing newlines, and
+   are split into words outside quotes only. */
+
+static void testSubstitute(void)
+{
+   DynArray_T oTokens;
+   const char *pcError;
+   size_t uJoinLength;
+
+   oTokens = DynArray_new(0);
+   LexAnalyzer_setSubstitute(substituteTest, NULL);
+
+   CHECK(LexAnalyzer_lexLineInto("x$(cmd (arg))y \"$(cmd)\"",
+                                 oTokens, &pcError));
+   CHECK(DynArray_getLength(oTokens) == 3);
+   if (DynArray_getLength(oTokens) == 3)
+   {
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 0)),
+                   "xa") == 0);
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 1)),
+                   "by") == 0);
+      CHECK(strcmp(Token_getString(DynArray_get(oTokens, 2)),
+                   "a  b") == 0);
+   }
+   LexAnalyzer_freeTokens(oTokens);
+   DynArray_clear(oTokens);
+
+   CHECK(! LexAnalyzer_lexLineInto("echo $(cmd", oTokens, &pcError));
+
+   /* A line does not split within a command substitution. */
+   CHECK(LexAnalyzer_findJoin("x $(a; \")\") ; y", &uJoinLength) == 12);
+   CHECK(uJoinLength == 1);
+
+   LexAnalyzer_setSubstitute(NULL, NULL);
+   DynArray_free(oTokens);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that ";", "&&" and "||" join the commands of a line into a
+   list, which may end with ";" but not with the other two. */
+
+static void testList(void)
+{
+   static const char *apcNames[] = {"a", "b", "c", "d"};
+   static const enum CommandJoin aeJoins[] =
+      {COMMAND_JOIN_AND, COMMAND_JOIN_OR, COMMAND_JOIN_SEQUENCE,
+       COMMAND_JOIN_NONE};
+   DynArray_T oTokens;
+   Command_T oFirst;
+   Command_T oCommand;
+   const char *pcError;
+   size_t uJoinLength;
+   size_t u = 0;
+
+   oTokens = DynArray_new(0);
+
+   CHECK(LexAnalyzer_lexLineInto("a > out&&b || c;d;", oTokens,
+                                 &pcError));
+   oFirst = SynAnalyzer_synTokensQuietly(oTokens, &pcError);
+   CHECK(oFirst != NULL);
+   for (oCommand = oFirst; oCommand != NULL && u < 4;
+        oCommand = Command_getNext(oCommand), u++)
+   {
+      CHECK(strcmp(Command_getName(oCommand), apcNames[u]) == 0);
+      CHECK(Command_getJoin(oCommand) == aeJoins[u]);
+   }
+   CHECK(u == 4 && oCommand == NULL);
+   Command_free(oFirst);
+   LexAnalyzer_freeTokens(oTokens);
+   DynArray_clear(oTokens);
+
+   CHECK(LexAnalyzer_lexLineInto("a &&", oTokens, &pcError));
+   CHECK(SynAnalyzer_synTokensQuietly(oTokens, &pcError) == NULL);
+   CHECK(pcError != NULL);
+   LexAnalyzer_freeTokens(oTokens);
+
+   /* A line splits at operators outside quotes only. */
+   CHECK(LexAnalyzer_findJoin("a \"x;y\" b&c || d", &uJoinLength)
+         == 12);
+   CHECK(uJoinLength == 2);
+   CHECK(LexAnalyzer_findJoin("a|b", &uJoinLength) == 3);
+   CHECK(uJoinLength == 0);
+
+   DynArray_free(oTokens);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that patterns match the right files in a new directory, in
+   sorted order, and that escaped wildcards match themselves. */
+
+static void testWildcard(void)
+{
+   static const char *apcFiles[] = {"b.c", "a.c", "c.h", ".d.c", "e*"};
+   char acDir[] = "/tmp/testlexXXXXXX";
+   char acPath[64];
+   DynArray_Storage sMatchesStorage;
+   DynArray_T oMatches;
+   char acEscaped[] = "e\\*";
+   size_t u;
+
+   if (mkdtemp(acDir) == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   for (u = 0; u < sizeof(apcFiles) / sizeof(apcFiles[0]); u++)
+   {
+      sprintf(acPath, "%s/%s", acDir, apcFiles[u]);
+      fclose(fopen(acPath, "w"));
+   }
+   oMatches = DynArray_init(&sMatchesStorage);
+
+   sprintf(acPath, "%s/*.c", acDir);
+   CHECK(Wildcard_isPattern(acPath));
+   CHECK(Wildcard_expand(acPath, oMatches) == 2);
+   if (DynArray_getLength(oMatches) == 2)
+   {
+      sprintf(acPath, "%s/a.c", acDir);
+      CHECK(strcmp(DynArray_get(oMatches, 0), acPath) == 0);
+      sprintf(acPath, "%s/b.c", acDir);
+      CHECK(strcmp(DynArray_get(oMatches, 1), acPath) == 0);
+   }
+   for (u = 0; u < DynArray_getLength(oMatches); u++)
+      free(DynArray_get(oMatches, u));
+   DynArray_clear(oMatches);
+
+   /* Sets and ? match one character each. */
+   sprintf(acPath, "%s/[!a]?[a-c]", acDir);
+   CHECK(Wildcard_expand(acPath, oMatches) == 1);
+   for (u = 0; u < DynArray_getLength(oMatches); u++)
+      free(DynArray_get(oMatches, u));
+   DynArray_clear(oMatches);
+
+   sprintf(acPath, "%s/%s", acDir, acEscaped);
+   CHECK(! Wildcard_isPattern(acPath));
+   CHECK(Wildcard_expand(acPath, oMatches) == 1);
+   for (u = 0; u < DynArray_getLength(oMatches); u++)
+      free(DynArray_get(oMatches, u));
+   DynArray_destroy(oMatches);
+
+   Wildcard_unescape(acEscaped);
+   CHECK(strcmp(acEscaped, "e*") == 0);
+
+   for (u = 0; u < sizeof(apcFiles) / sizeof(apcFiles[0]); u++)
+   {
+      sprintf(acPath, "%s/%s", acDir, apcFiles[u]);
+      unlink(acPath);
+   }
+   rmdir(acDir);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a line of exactly uLength characters, with uChunks - 1
+   quoted strings that contain spaces and straddle the points at which
+   the lexer nominally splits the line into uChunks chunks.  The
+   caller owns the line. */
+
+static char *makeLongLine(size_t uLength, size_t uChunks)
+{
+   static const char *apcWords[] =
+      {"word", "x\"y z\"w", "<", "in", "|", "\"\"", ">", "out"};
+   enum {QUOTED_LENGTH = 4000};
+   char *pcLine;
+   size_t uUsed = 0;
+   size_t uChunk = 1;
+   size_t uWord = 0;
+   size_t uWordLength;
+   size_t u;
+
+   pcLine = (char*)malloc(uLength + 1);
+   if (pcLine == NULL) {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   while (uUsed + QUOTED_LENGTH + 16 < uLength)
+   {
+      if (uChunk < uChunks &&
+          uUsed + QUOTED_LENGTH / 2 >= uLength / uChunks * uChunk)
+      {
+         pcLine[uUsed++] = '\"';
+         for (u = 0; u < QUOTED_LENGTH; u++)
+            pcLine[uUsed++] = (u % 3 == 0) ? ' ' : 'q';
+         pcLine[uUsed++] = '\"';
+         uChunk++;
+      }
+      else
+      {
+         uWordLength = strlen(apcWords[uWord]);
+         memcpy(pcLine + uUsed, apcWords[uWord], uWordLength);
+         uUsed += uWordLength;
+         uWord = (uWord + 1) % (sizeof(apcWords) / sizeof(apcWords[0]));
+      }
+      pcLine[uUsed++] = ' ';
+   }
+   memset(pcLine + uUsed, ' ', uLength - uUsed);
+   pcLine[uLength] = '\0';
+   return pcLine;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff lexing pcLine in uChunks chunks gives the same
+   tokens, or the same error, as lexing it serially. */
+
+static int isSameAsSerial(const char *pcLine, size_t uChunks)
+{
+   DynArray_T oSerial;
+   DynArray_T oParallel;
+   const char *pcSerialError = NULL;
+   const char *pcParallelError = NULL;
+   int iSerial;
+   int iParallel;
+   int iSame;
+   size_t u;
+   Token_T oToken1;
+   Token_T oToken2;
+
+   oSerial = DynArray_new(0);
+   oParallel = DynArray_new(0);
+   LexAnalyzer_setMaxChunks(1);
+   iSerial = LexAnalyzer_lexLineInto(pcLine, oSerial, &pcSerialError);
+   LexAnalyzer_setMaxChunks(uChunks);
+   iParallel = LexAnalyzer_lexLineInto(pcLine, oParallel,
+                                       &pcParallelError);
+   LexAnalyzer_setMaxChunks(0);
+
+   iSame = iSerial == iParallel &&
+      DynArray_getLength(oSerial) == DynArray_getLength(oParallel);
+   if (iSame && ! iSerial)
+      iSame = strcmp(pcSerialError, pcParallelError) == 0;
+   for (u = 0; iSame && u < DynArray_getLength(oSerial); u++)
+   {
+      oToken1 = DynArray_get(oSerial, u);
+      oToken2 = DynArray_get(oParallel, u);
+      iSame = Token_getType(oToken1) == Token_getType(oToken2) &&
+         Token_getOp(oToken1) == Token_getOp(oToken2) &&
+         strcmp(Token_getString(oToken1),
+                Token_getString(oToken2)) == 0;
+   }
+
+   LexAnalyzer_freeTokens(oSerial);
+   LexAnalyzer_freeTokens(oParallel);
+   DynArray_free(oSerial);
+   DynArray_free(oParallel);
+   return iSame;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a line long enough to be lexed in parallel gives the same
+   tokens, or the same error, as when it is lexed serially, also when
+   quotes straddle the chunk boundaries or are left unterminated. */
+
+static void testParallelLex(void)
+{
+   enum {LENGTH = 2 * 1024 * 1024, CHUNKS = 8};
+   char *pcLine;
+
+   pcLine = makeLongLine(LENGTH, CHUNKS);
+   CHECK(isSameAsSerial(pcLine, CHUNKS));
+   CHECK(isSameAsSerial(pcLine, 3));
+
+   /* An unterminated quote at the end of the line. */
+   pcLine[LENGTH - 2] = '\"';
+   CHECK(isSameAsSerial(pcLine, CHUNKS));
+
+   /* A stray quote in the middle pairs every later quote with a
+      different partner. */
+   pcLine[LENGTH - 2] = ' ';
+   pcLine[LENGTH / 2 + 1] = '\"';
+   CHECK(isSameAsSerial(pcLine, CHUNKS));
+
+   free(pcLine);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the tests, and write to stderr the checks that fail.  Return 0
+   iff all succeed. */
+
+int main(int argc, char *argv[])
+{
+   pcPgmName = argv[0];
+
+   testLexInto();
+   testExpand();
+   testSubstitute();
+   testList();
+   testWildcard();
+   testParallelLex();
+
+   if (iFailures > 0)
+   {
+      fprintf(stderr, "%s: %d checks failed\n", pcPgmName, iFailures);
+      return EXIT_FAILURE;
+   }
+   printf("%s: all checks passed\n", pcPgmName);
+   return 0;
+}
@@ -0,0 +1,401 @@
+/*--------------------------------------------------------------------*/
+/* threadPool.c                                                       */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "threadPool.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The most workers that the shared ThreadPool has, and the size of a
+   cache line, which keeps the shares of the threads apart. */
+
+enum {MAX_SHARED_WORKERS = 63, CACHE_LINE = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* The iterations [uLo, uHi) of the current loop that one thread has
+   yet to run.  The thread takes iterations from the low end, and other
+   threads steal from the high end. */
+
+struct Share
+{
+   /* Protects uLo and uHi. */
+   pthread_mutex_t sMutex;
+
+   /* The first iteration. */
+   size_t uLo;
+
+   /* One past the last iteration. */
+   size_t uHi;
+
+   /* Keeps the shares of different threads in different cache
+      lines. */
+   char acPad[CACHE_LINE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The identity of one worker thread. */
+
+struct Worker
+{
+   /* The ThreadPool to which the worker belongs. */
+   ThreadPool_T oThreadPool;
+
+   /* The index of the worker's share; the caller's is 0. */
+   size_t uIndex;
+
+   /* The thread. */
+   pthread_t sThread;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A ThreadPool consists of its workers, one share of the current loop
+   per thread, and the loop itself. */
+
+struct ThreadPool
+{
+   /* The number of workers. */
+   size_t uWorkers;
+
+   /* The workers. */
+   struct Worker *psWorkers;
+
+   /* The shares of the caller and the workers, in that order. */
+   struct Share *psShares;
+
+   /* The current loop. */
+   void (*pfRun)(size_t uLo, size_t uHi, void *pvExtra);
+   void *pvExtra;
+   size_t uGrain;
+
+   /* Incremented when a loop starts. */
+   unsigned long ulGeneration;
+
+   /* The number of workers that have yet to finish the current
+      loop. */
+   size_t uRunning;
+
+   /* 1 (TRUE) iff the workers should exit. */
+   int iStopping;
+
+   /* Protects ulGeneration, uRunning and iStopping. */
+   pthread_mutex_t sMutex;
+
+   /* Signaled when a loop starts or the workers should exit. */
+   pthread_cond_t sStart;
+
+   /* Signaled when the last worker finishes a loop. */
+   pthread_cond_t sFinish;
+
+   /* Makes concurrent callers of ThreadPool_run take turns. */
+   pthread_mutex_t sCallerMutex;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* 1 (TRUE) iff the current thread is running a loop, in which case
+   nested loops run serially. */
+
+static _Thread_local int iInLoop = 0;
+
+/* The ThreadPool that ThreadPool_getShared returns. */
+
+static ThreadPool_T oSharedPool = NULL;
+
+/* Makes sure that the shared ThreadPool is created once. */
+
+static pthread_once_t sSharedOnce = PTHREAD_ONCE_INIT;
+
+/*--------------------------------------------------------------------*/
+
+/* Take up to uGrain iterations from the low end of *psShare, and
+   assign them to *puLo and *puHi.  Return 0 (FALSE) iff *psShare is
+   empty. */
+
+static int ThreadPool_take(struct Share *psShare, size_t uGrain,
+                           size_t *puLo, size_t *puHi)
+{
+   int iTaken = 0;
+
+   pthread_mutex_lock(&psShare->sMutex);
+   if (psShare->uLo < psShare->uHi)
+   {
+      *puLo = psShare->uLo;
+      *puHi = (psShare->uHi - psShare->uLo > uGrain) ?
+         psShare->uLo + uGrain : psShare->uHi;
+      psShare->uLo = *puHi;
+      iTaken = 1;
+   }
+   pthread_mutex_unlock(&psShare->sMutex);
+   return iTaken;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the high half of the first nonempty share of another thread
+   into the share of thread uSelf of oThreadPool.  Return 0 (FALSE)
+   iff all other shares are empty. */
+
+static int ThreadPool_steal(ThreadPool_T oThreadPool, size_t uSelf)
+{
+   size_t uThreads = oThreadPool->uWorkers + 1;
+   struct Share *psVictim;
+   struct Share *psSelf = &oThreadPool->psShares[uSelf];
+   size_t uLo, uHi;
+   size_t u;
+
+   for (u = 1; u < uThreads; u++)
+   {
+      psVictim = &oThreadPool->psShares[(uSelf + u) % uThreads];
+      pthread_mutex_lock(&psVictim->sMutex);
+      if (psVictim->uLo < psVictim->uHi)
+      {
+         uHi = psVictim->uHi;
+         uLo = uHi - (uHi - psVictim->uLo + 1) / 2;
+         psVictim->uHi = uLo;
+         pthread_mutex_unlock(&psVictim->sMutex);
+
+         pthread_mutex_lock(&psSelf->sMutex);
+         psSelf->uLo = uLo;
+         psSelf->uHi = uHi;
+         pthread_mutex_unlock(&psSelf->sMutex);
+         return 1;
+      }
+      pthread_mutex_unlock(&psVictim->sMutex);
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run iterations of the current loop of oThreadPool as thread uSelf
+   until none remain in any share. */
+
+static void ThreadPool_participate(ThreadPool_T oThreadPool,
+                                   size_t uSelf)
+{
+   struct Share *psSelf = &oThreadPool->psShares[uSelf];
+   size_t uLo, uHi;
+
+   iInLoop = 1;
+   for (;;)
+   {
+      if (ThreadPool_take(psSelf, oThreadPool->uGrain, &uLo, &uHi))
+         (*oThreadPool->pfRun)(uLo, uHi, oThreadPool->pvExtra);
+      else if (! ThreadPool_steal(oThreadPool, uSelf))
+         break;
+   }
+   iInLoop = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The body of the worker thread pvWorker, a struct Worker. */
+
+static void *ThreadPool_work(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   ThreadPool_T oThreadPool = psWorker->oThreadPool;
+   unsigned long ulSeen = 0;
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   for (;;)
+   {
+      while (oThreadPool->ulGeneration == ulSeen &&
+             ! oThreadPool->iStopping)
+         pthread_cond_wait(&oThreadPool->sStart, &oThreadPool->sMutex);
+      if (oThreadPool->iStopping)
+         break;
+      ulSeen = oThreadPool->ulGeneration;
+      pthread_mutex_unlock(&oThreadPool->sMutex);
+
+      ThreadPool_participate(oThreadPool, psWorker->uIndex);
+
+      pthread_mutex_lock(&oThreadPool->sMutex);
+      if (--oThreadPool->uRunning == 0)
+         pthread_cond_signal(&oThreadPool->sFinish);
+   }
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+ThreadPool_T ThreadPool_new(size_t uWorkers)
+{
+   ThreadPool_T oThreadPool;
+   sigset_t sAllSignals;
+   sigset_t sOldMask;
+   size_t u;
+
+   oThreadPool = (struct ThreadPool*)malloc(sizeof(struct ThreadPool));
+   if (oThreadPool == NULL)
+      return NULL;
+   oThreadPool->psWorkers =
+      (struct Worker*)calloc(uWorkers + 1, sizeof(struct Worker));
+   oThreadPool->psShares =
+      (struct Share*)calloc(uWorkers + 1, sizeof(struct Share));
+   if (oThreadPool->psWorkers == NULL || oThreadPool->psShares == NULL)
+   {
+      free(oThreadPool->psWorkers);
+      free(oThreadPool->psShares);
+      free(oThreadPool);
+      return NULL;
+   }
+
+   oThreadPool->uWorkers = 0;
+   oThreadPool->ulGeneration = 0;
+   oThreadPool->uRunning = 0;
+   oThreadPool->iStopping = 0;
+   pthread_mutex_init(&oThreadPool->sMutex, NULL);
+   pthread_cond_init(&oThreadPool->sStart, NULL);
+   pthread_cond_init(&oThreadPool->sFinish, NULL);
+   pthread_mutex_init(&oThreadPool->sCallerMutex, NULL);
+   for (u = 0; u <= uWorkers; u++)
+      pthread_mutex_init(&oThreadPool->psShares[u].sMutex, NULL);
+
+   /* Signals must be delivered to the threads of the program, not to
+      the workers. */
+   sigfillset(&sAllSignals);
+   pthread_sigmask(SIG_SETMASK, &sAllSignals, &sOldMask);
+   for (u = 1; u <= uWorkers; u++)
+   {
+      oThreadPool->psWorkers[u].oThreadPool = oThreadPool;
+      oThreadPool->psWorkers[u].uIndex = u;
+      if (pthread_create(&oThreadPool->psWorkers[u].sThread, NULL,
+                         ThreadPool_work,
+                         &oThreadPool->psWorkers[u]) != 0)
+         break;
+      oThreadPool->uWorkers++;
+   }
+   pthread_sigmask(SIG_SETMASK, &sOldMask, NULL);
+
+   if (oThreadPool->uWorkers < uWorkers)
+   {
+      ThreadPool_free(oThreadPool);
+      return NULL;
+   }
+   return oThreadPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ThreadPool_free(ThreadPool_T oThreadPool)
+{
+   size_t u;
+
+   assert(oThreadPool != NULL);
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   oThreadPool->iStopping = 1;
+   pthread_cond_broadcast(&oThreadPool->sStart);
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+   for (u = 1; u <= oThreadPool->uWorkers; u++)
+      pthread_join(oThreadPool->psWorkers[u].sThread, NULL);
+
+   for (u = 0; u <= oThreadPool->uWorkers; u++)
+      pthread_mutex_destroy(&oThreadPool->psShares[u].sMutex);
+   pthread_mutex_destroy(&oThreadPool->sMutex);
+   pthread_cond_destroy(&oThreadPool->sStart);
+   pthread_cond_destroy(&oThreadPool->sFinish);
+   pthread_mutex_destroy(&oThreadPool->sCallerMutex);
+   free(oThreadPool->psWorkers);
+   free(oThreadPool->psShares);
+   free(oThreadPool);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Create the shared ThreadPool. */
+
+static void ThreadPool_createShared(void)
+{
+   long lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+   if (lProcessors < 1)
+      lProcessors = 1;
+   if (lProcessors > MAX_SHARED_WORKERS + 1)
+      lProcessors = MAX_SHARED_WORKERS + 1;
+   oSharedPool = ThreadPool_new((size_t)lProcessors - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+ThreadPool_T ThreadPool_getShared(void)
+{
+   pthread_once(&sSharedOnce, ThreadPool_createShared);
+   return oSharedPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t ThreadPool_getThreads(ThreadPool_T oThreadPool)
+{
+   assert(oThreadPool != NULL);
+
+   return oThreadPool->uWorkers + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ThreadPool_run(ThreadPool_T oThreadPool, size_t uCount,
+                    size_t uGrain,
+                    void (*pfRun)(size_t uLo, size_t uHi,
+                                  void *pvExtra),
+                    void *pvExtra)
+{
+   size_t uThreads;
+   size_t u;
+
+   assert(oThreadPool != NULL);
+   assert(pfRun != NULL);
+
+   if (uGrain == 0)
+      uGrain = 1;
+
+   /* Run short and nested loops, and loops without workers, here. */
+   if (uCount <= uGrain || iInLoop || oThreadPool->uWorkers == 0)
+   {
+      for (u = 0; u < uCount; u += uGrain)
+         (*pfRun)(u, (uCount - u > uGrain) ? u + uGrain : uCount,
+                  pvExtra);
+      return;
+   }
+
+   pthread_mutex_lock(&oThreadPool->sCallerMutex);
+
+   /* Give each thread an equal share of the iterations. */
+   uThreads = oThreadPool->uWorkers + 1;
+   oThreadPool->pfRun = pfRun;
+   oThreadPool->pvExtra = pvExtra;
+   oThreadPool->uGrain = uGrain;
+   for (u = 0; u < uThreads; u++)
+   {
+      oThreadPool->psShares[u].uLo = uCount / uThreads * u;
+      oThreadPool->psShares[u].uHi = (u == uThreads - 1) ?
+         uCount : uCount / uThreads * (u + 1);
+   }
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   oThreadPool->uRunning = oThreadPool->uWorkers;
+   oThreadPool->ulGeneration++;
+   pthread_cond_broadcast(&oThreadPool->sStart);
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+
+   ThreadPool_participate(oThreadPool, 0);
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   while (oThreadPool->uRunning > 0)
+      pthread_cond_wait(&oThreadPool->sFinish, &oThreadPool->sMutex);
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+
+   pthread_mutex_unlock(&oThreadPool->sCallerMutex);
+}
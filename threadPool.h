@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/* threadPool.h                                                       */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <stddef.h>
+
+/* A ThreadPool_T object is a set of worker threads that, together
+   with the calling thread, run loops in parallel.  Each thread works
+   through its own share of a loop's iterations and, once that runs
+   out, steals half of what remains of another thread's share. */
+
+typedef struct ThreadPool *ThreadPool_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new ThreadPool_T object with uWorkers worker threads, or
+   NULL if insufficient memory is available or a thread cannot be
+   created.  The workers start with all signals blocked. */
+
+ThreadPool_T ThreadPool_new(size_t uWorkers);
+
+/*--------------------------------------------------------------------*/
+
+/* Stop the workers of oThreadPool and free it. */
+
+void ThreadPool_free(ThreadPool_T oThreadPool);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a ThreadPool_T object that is shared by the whole program,
+   with one worker fewer than there are processors, creating it on the
+   first call.  Return NULL if it cannot be created.  The caller must
+   not free it. */
+
+ThreadPool_T ThreadPool_getShared(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of threads, including the caller's, that run the
+   loops of oThreadPool. */
+
+size_t ThreadPool_getThreads(ThreadPool_T oThreadPool);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfRun)(uLo, uHi, pvExtra) for ranges [uLo, uHi) that together
+   cover [0, uCount) exactly once, each at most uGrain long (uGrain 0 is
+   treated as 1), on the threads of oThreadPool, and return when all
+   calls have returned.  The calls may run concurrently and in any
+   order.  Calls to ThreadPool_run with the same oThreadPool from
+   several threads run one after the other; a call from within *pfRun
+   runs all of its ranges in the calling thread. */
+
+void ThreadPool_run(ThreadPool_T oThreadPool, size_t uCount,
+                    size_t uGrain,
+                    void (*pfRun)(size_t uLo, size_t uHi,
+                                  void *pvExtra),
+                    void *pvExtra);
+
+#endif
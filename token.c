@@ -12,18 +12,54 @@
 
 /*--------------------------------------------------------------------*/
 
+/* The length of the buffer within each Token that holds short values,
+   including the terminating null character. */
+
+enum {INLINE_LENGTH = 16};
+
+/*--------------------------------------------------------------------*/
+
 /* A- Token is either a number or a word, expressed as a string. */
 struct Token
 {
    /* The type of the token. */
    enum TokenType eType;
 
-   /* The string which is the token's value. */
+   /* The operator that the token denotes. */
+   enum TokenOp eOp;
+
+   /* The string which is the token's value.  It is acInline if it
+      fits there, and is in its own memory chunk otherwise. */
    char *pcValue;
+
+   /* The characters of a short value. */
+   char acInline[INLINE_LENGTH];
 };
 
 /*--------------------------------------------------------------------*/
 
+/* Return the operator that a token whose type is eType and whose value
+   is pcValue denotes. */
+
+static enum TokenOp Token_findOp(enum TokenType eType,
+                                 const char *pcValue)
+{
+   if (eType != TOKEN_SPECIAL) return TOKEN_OP_NONE;
+   if (strcmp(pcValue, "&&") == 0) return TOKEN_OP_AND;
+   if (strcmp(pcValue, "||") == 0) return TOKEN_OP_OR;
+   if (pcValue[0] == '\0' || pcValue[1] != '\0')
+      return TOKEN_OP_INVALID;
+   switch (pcValue[0])
+   {
+      case '<': return TOKEN_OP_REDIRECT_IN;
+      case '>': return TOKEN_OP_REDIRECT_OUT;
+      case ';': return TOKEN_OP_SEQUENCE;
+      default: return TOKEN_OP_INVALID;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 #ifndef NDEBUG
 
 /* Check the invariants of oToken. Return 1 (TRUE) iff oToken is valid 
@@ -34,6 +70,8 @@ static int Token_isValid(Token_T oToken)
    if (oToken->eType != TOKEN_SPECIAL &&
        oToken->eType != TOKEN_ORDINARY) return 0;
    if (oToken->pcValue == NULL) return 0;
+   if ((oToken->eType == TOKEN_ORDINARY) !=
+       (oToken->eOp == TOKEN_OP_NONE)) return 0;
    return 1;
 }
 
@@ -53,6 +91,18 @@ enum TokenType Token_getType(Token_T oToken)
 
 /*--------------------------------------------------------------------*/
 
+/* Return the operator that oToken denotes. */
+
+enum TokenOp Token_getOp(Token_T oToken)
+{
+   assert(oToken != NULL);
+   assert(Token_isValid(oToken));
+
+   return oToken->eOp;
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Return the value of oToken, which is a string. */
 
 char* Token_getString(Token_T oToken)
@@ -65,7 +115,8 @@ char* Token_getString(Token_T oToken)
 
 /*--------------------------------------------------------------------*/
 
-/* Set the type of oToken to eNewType. */
+/* Set the type of oToken to eNewType, and work out its operator
+   again. */
 
 void Token_setType(Token_T oToken, enum TokenType eNewType)
 {
@@ -74,6 +125,7 @@ void Token_setType(Token_T oToken, enum TokenType eNewType)
    assert(eNewType == TOKEN_SPECIAL || eNewType == TOKEN_ORDINARY);
    
    oToken->eType = eNewType;
+   oToken->eOp = Token_findOp(eNewType, oToken->pcValue);
    assert(Token_isValid(oToken));
 }
 
@@ -97,12 +149,31 @@ void Token_print(Token_T oToken)
 /*--------------------------------------------------------------------*/
 
 /* Create and return a token whose type is eTokenType and whose
-   value consists of string pcValue.  The caller owns the token. */
+   value consists of string pcValue.  If the token is special, then
+   work out the operator that pcValue denotes.  The caller owns the
+   token. */
 
 Token_T Token_new(enum TokenType eTokenType,
    char *pcValue)
+{
+   assert(pcValue != NULL);
+
+   return Token_newOp(eTokenType, Token_findOp(eTokenType, pcValue),
+                      pcValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Create and return a token like Token_new, but one that denotes the
+   operator eOp, which the caller has already worked out: TOKEN_OP_NONE
+   for an ordinary token, and any other operator for a special one.
+   The caller owns the token. */
+
+Token_T Token_newOp(enum TokenType eTokenType, enum TokenOp eOp,
+                    char *pcValue)
 {
    Token_T oToken;
+   size_t uLength;
 
    assert(pcValue != NULL);
    assert(eTokenType == TOKEN_SPECIAL || eTokenType == TOKEN_ORDINARY);
@@ -112,11 +183,17 @@ Token_T Token_new(enum TokenType eTokenType,
    {perror(getPgmName()); exit(EXIT_FAILURE);}
    
    oToken->eType = eTokenType;
-   oToken->pcValue =
-      (char*)malloc(sizeof(char) * (strlen(pcValue)+1));
-   if (oToken->pcValue == NULL)
-      {perror(getPgmName()); exit(EXIT_FAILURE);}
-   strcpy(oToken->pcValue, pcValue);
+   uLength = strlen(pcValue);
+   if (uLength < INLINE_LENGTH)
+      oToken->pcValue = oToken->acInline;
+   else
+   {
+      oToken->pcValue = (char*)malloc(sizeof(char) * (uLength+1));
+      if (oToken->pcValue == NULL)
+         {perror(getPgmName()); exit(EXIT_FAILURE);}
+   }
+   memcpy(oToken->pcValue, pcValue, uLength+1);
+   oToken->eOp = eOp;
 
    assert(Token_isValid(oToken));
    return oToken;
@@ -131,7 +208,8 @@ void Token_free(Token_T oToken)
    assert(oToken != NULL);
    assert(Token_isValid(oToken));
    
-   free(oToken->pcValue);
+   if (oToken->pcValue != oToken->acInline)
+      free(oToken->pcValue);
    free(oToken);
 }
 
@@ -144,8 +222,7 @@ int Token_isStdIn(Token_T oToken)
    assert(oToken != NULL);
    assert(Token_isValid(oToken));
       
-   if (strcmp(oToken->pcValue, "<") == 0) return 1;
-   return 0;
+   return oToken->eOp == TOKEN_OP_REDIRECT_IN;
 }
 
 /*--------------------------------------------------------------------*/
@@ -157,6 +234,5 @@ int Token_isStdOut(Token_T oToken)
    assert(oToken != NULL);
    assert(Token_isValid(oToken));
       
-   if (strcmp(oToken->pcValue, ">") == 0) return 1;
-   return 0;
+   return oToken->eOp == TOKEN_OP_REDIRECT_OUT;
 }
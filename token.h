@@ -14,6 +14,15 @@ typedef struct Token* Token_T;
 
 enum TokenType {TOKEN_ORDINARY, TOKEN_SPECIAL};
 
+/* Define the operators that special tokens denote: "<", ">", and the
+   ";", "&&" and "||" that join commands into a list.  Ordinary tokens
+   denote TOKEN_OP_NONE, and special tokens that denote no known
+   operator, such as "<<>", denote TOKEN_OP_INVALID. */
+
+enum TokenOp {TOKEN_OP_NONE, TOKEN_OP_REDIRECT_IN,
+              TOKEN_OP_REDIRECT_OUT, TOKEN_OP_SEQUENCE, TOKEN_OP_AND,
+              TOKEN_OP_OR, TOKEN_OP_INVALID};
+
 /*--------------------------------------------------------------------*/
 
 /* Return the token type of oToken. */
@@ -22,13 +31,20 @@ enum TokenType Token_getType(Token_T oToken);
 
 /*--------------------------------------------------------------------*/
 
+/* Return the operator that oToken denotes. */
+
+enum TokenOp Token_getOp(Token_T oToken);
+
+/*--------------------------------------------------------------------*/
+
 /* Return the value of oToken, which is a string. */
 
 char* Token_getString(Token_T oToken);
 
 /*--------------------------------------------------------------------*/
 
-/* Set the type of oToken to eNewType. */
+/* Set the type of oToken to eNewType, and work out its operator
+   again. */
 
 void Token_setType(Token_T oToken, enum TokenType eNewType);
 
@@ -41,13 +57,25 @@ void Token_print(Token_T oToken);
 /*--------------------------------------------------------------------*/
 
 /* Create and return a token whose type is eTokenType and whose
-   value consists of string pcValue.  The caller owns the token. */
+   value consists of string pcValue.  If the token is special, then
+   work out the operator that pcValue denotes.  The caller owns the
+   token. */
 
 Token_T Token_new(enum TokenType eTokenType,
                   char *pcValue);
 
 /*--------------------------------------------------------------------*/
 
+/* Create and return a token like Token_new, but one that denotes the
+   operator eOp, which the caller has already worked out: TOKEN_OP_NONE
+   for an ordinary token, and any other operator for a special one.
+   The caller owns the token. */
+
+Token_T Token_newOp(enum TokenType eTokenType, enum TokenOp eOp,
+                    char *pcValue);
+
+/*--------------------------------------------------------------------*/
+
 /* Free oToken. */
 
 void Token_free(Token_T oToken);
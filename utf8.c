@@ -0,0 +1,114 @@
+/*--------------------------------------------------------------------*/
+/* utf8.c                                                             */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "utf8.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of leading bytes at pucBytes...pucBytes+uLength-1
+   that are ASCII.  Most text is ASCII, so whole vectors of it are
+   skipped at once. */
+
+static size_t Utf8_asciiPrefix(const unsigned char *pucBytes,
+                               size_t uLength)
+{
+   size_t u = 0;
+   uint64_t uWord;
+
+#ifdef __SSE2__
+   /* _mm_movemask_epi8 gathers the high bit of each of 16 bytes. */
+   while (uLength - u >= 16)
+   {
+      __m128i sVector = _mm_loadu_si128((const __m128i*)(pucBytes + u));
+      if (_mm_movemask_epi8(sVector) != 0)
+         break;
+      u += 16;
+   }
+#endif
+
+   while (uLength - u >= 8)
+   {
+      memcpy(&uWord, pucBytes + u, 8);
+      if ((uWord & 0x8080808080808080ull) != 0)
+         break;
+      u += 8;
+   }
+
+   while (u < uLength && pucBytes[u] < 0x80)
+      u++;
+   return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the well-formed multibyte sequence at
+   pucBytes...pucBytes+uLength-1, whose first byte is not ASCII, or 0
+   if there is none. */
+
+static size_t Utf8_sequenceLength(const unsigned char *pucBytes,
+                                  size_t uLength)
+{
+   unsigned char ucLead = pucBytes[0];
+   unsigned char ucMin = 0x80; /* The smallest valid second byte. */
+   unsigned char ucMax = 0xBF; /* The largest valid second byte. */
+   size_t uSequence;
+   size_t u;
+
+   assert(uLength > 0 && ucLead >= 0x80);
+
+   if (ucLead >= 0xC2 && ucLead <= 0xDF)
+      uSequence = 2;
+   else if (ucLead >= 0xE0 && ucLead <= 0xEF)
+   {
+      uSequence = 3;
+      if (ucLead == 0xE0) ucMin = 0xA0; /* Overlong. */
+      if (ucLead == 0xED) ucMax = 0x9F; /* Surrogates. */
+   }
+   else if (ucLead >= 0xF0 && ucLead <= 0xF4)
+   {
+      uSequence = 4;
+      if (ucLead == 0xF0) ucMin = 0x90; /* Overlong. */
+      if (ucLead == 0xF4) ucMax = 0x8F; /* Above U+10FFFF. */
+   }
+   else
+      return 0;
+
+   if (uLength < uSequence)
+      return 0;
+   if (pucBytes[1] < ucMin || pucBytes[1] > ucMax)
+      return 0;
+   for (u = 2; u < uSequence; u++)
+      if ((pucBytes[u] & 0xC0) != 0x80)
+         return 0;
+   return uSequence;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Utf8_isValid(const char *pcBytes, size_t uLength)
+{
+   const unsigned char *pucBytes = (const unsigned char*)pcBytes;
+   size_t u = 0;
+   size_t uSequence;
+
+   assert(pcBytes != NULL || uLength == 0);
+
+   for (;;)
+   {
+      u += Utf8_asciiPrefix(pucBytes + u, uLength - u);
+      if (u == uLength)
+         return 1;
+      uSequence = Utf8_sequenceLength(pucBytes + u, uLength - u);
+      if (uSequence == 0)
+         return 0;
+      u += uSequence;
+   }
+}
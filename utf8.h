@@ -0,0 +1,17 @@
+/*--------------------------------------------------------------------*/
+/* utf8.h                                                             */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef UTF8_INCLUDED
+#define UTF8_INCLUDED
+
+#include <stddef.h>
+
+/* Return 1 (TRUE) iff the uLength bytes at pcBytes are well-formed
+   UTF-8, that is, contain no invalid bytes, truncated or overlong
+   sequences, surrogates, or code points above U+10FFFF. */
+
+int Utf8_isValid(const char *pcBytes, size_t uLength);
+
+#endif
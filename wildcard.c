@@ -0,0 +1,597 @@
+/*--------------------------------------------------------------------*/
+/* wildcard.c                                                         */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#include "wildcard.h"
+#include "ish.h"
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of directories that are remembered, and the number of
+   bytes of directory entries read at a time. */
+
+enum {CACHE_LENGTH = 16, READ_SIZE = 32768};
+
+/* The kinds of steps of a compiled pattern: a byte that matches
+   itself, ? (any character), * (any string), and [...] (a set). */
+
+enum OpKind {OP_BYTE, OP_ANY, OP_STAR, OP_SET};
+
+/* A step of a compiled pattern. */
+
+struct Op
+{
+   enum OpKind eKind;
+
+   /* The byte of an OP_BYTE step. */
+   unsigned char ucByte;
+
+   /* The bytes that an OP_SET step matches, one bit each.  A
+      multibyte character matches if its first byte does. */
+   unsigned char aucSet[32];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A directory entry as the getdents64 system call returns it. */
+
+struct LinuxDirent64
+{
+   uint64_t d_ino;
+   int64_t d_off;
+   unsigned short d_reclen;
+   unsigned char d_type;
+   char d_name[];
+};
+
+/* The entries of a directory, as read at one time. */
+
+struct Listing
+{
+   /* The device and inode of the directory, and its modification time
+      when it was read. */
+   dev_t uDev;
+   ino_t uIno;
+   struct timespec sMtime;
+
+   /* The entries, each a type byte (a d_type value) followed by the
+      name and a null character, uSize bytes in all. */
+   char *pcEntries;
+   size_t uSize;
+
+   /* When the listing was last used, on the scale of ulUses, or 0 if
+      the slot is empty. */
+   unsigned long ulLastUse;
+};
+
+/* The directories that were read recently, and the number of times
+   that the cache has been used. */
+
+static struct Listing asCache[CACHE_LENGTH];
+static unsigned long ulUses = 0;
+
+/*--------------------------------------------------------------------*/
+
+int Wildcard_isPattern(const char *pcPattern)
+{
+   assert(pcPattern != NULL);
+
+   for (; *pcPattern != '\0'; pcPattern++)
+   {
+      if (*pcPattern == '\\' && pcPattern[1] != '\0')
+         pcPattern++;
+      else if (*pcPattern == '*' || *pcPattern == '?' ||
+               *pcPattern == '[')
+         return 1;
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Wildcard_unescape(char *pcPattern)
+{
+   char *pcTo = pcPattern;
+
+   assert(pcPattern != NULL);
+
+   for (; *pcPattern != '\0'; pcPattern++)
+   {
+      if (*pcPattern == '\\' && pcPattern[1] != '\0')
+         pcPattern++;
+      *pcTo++ = *pcPattern;
+   }
+   *pcTo = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compile the set that starts with the '[' at pcPattern[uIndex], where
+   pcPattern is uLength bytes long, into *psOp.  Return the index just
+   past the set, or 0 if the set has no closing ']'. */
+
+static size_t Wildcard_compileSet(const char *pcPattern, size_t uIndex,
+                                  size_t uLength, struct Op *psOp)
+{
+   int iNegated = 0;
+   int iFirst = 1;
+   unsigned char ucLow, ucHigh;
+   unsigned u;
+
+   memset(psOp->aucSet, 0, sizeof(psOp->aucSet));
+   psOp->eKind = OP_SET;
+   uIndex++;
+   if (uIndex < uLength &&
+       (pcPattern[uIndex] == '!' || pcPattern[uIndex] == '^'))
+   {
+      iNegated = 1;
+      uIndex++;
+   }
+
+   /* A ']' that comes first is a member. */
+   for (; uIndex < uLength && (iFirst || pcPattern[uIndex] != ']');
+        iFirst = 0)
+   {
+      if (pcPattern[uIndex] == '\\' && uIndex + 1 < uLength)
+         uIndex++;
+      ucLow = ucHigh = (unsigned char)pcPattern[uIndex++];
+
+      if (uIndex + 1 < uLength && pcPattern[uIndex] == '-' &&
+          pcPattern[uIndex + 1] != ']')
+      {
+         uIndex++;
+         if (pcPattern[uIndex] == '\\' && uIndex + 1 < uLength)
+            uIndex++;
+         ucHigh = (unsigned char)pcPattern[uIndex++];
+      }
+      for (u = ucLow; u <= ucHigh; u++)
+         psOp->aucSet[u / 8] |= (unsigned char)(1 << (u % 8));
+   }
+   if (uIndex >= uLength)
+      return 0;
+
+   if (iNegated)
+      for (u = 0; u < sizeof(psOp->aucSet); u++)
+         psOp->aucSet[u] = (unsigned char)~psOp->aucSet[u];
+   return uIndex + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compile the uLength bytes of the pattern component pcComponent into
+   the steps psOps, which must have room for uLength of them.  Assign
+   the number of steps to *puOps.  Return 1 (TRUE) if the component
+   contains a wildcard, or 0 (FALSE) otherwise. */
+
+static int Wildcard_compile(const char *pcComponent, size_t uLength,
+                            struct Op *psOps, size_t *puOps)
+{
+   size_t uIndex = 0;
+   size_t uOps = 0;
+   size_t uNext;
+   int iWild = 0;
+   char c;
+
+   while (uIndex < uLength)
+   {
+      c = pcComponent[uIndex];
+      if (c == '\\' && uIndex + 1 < uLength)
+      {
+         psOps[uOps].eKind = OP_BYTE;
+         psOps[uOps++].ucByte = (unsigned char)pcComponent[uIndex + 1];
+         uIndex += 2;
+         continue;
+      }
+
+      uIndex++;
+      if (c == '*')
+      {
+         /* Several stars in a row match what one does. */
+         if (uOps == 0 || psOps[uOps - 1].eKind != OP_STAR)
+            psOps[uOps++].eKind = OP_STAR;
+         iWild = 1;
+      }
+      else if (c == '?')
+      {
+         psOps[uOps++].eKind = OP_ANY;
+         iWild = 1;
+      }
+      else if (c == '[' &&
+               (uNext = Wildcard_compileSet(pcComponent, uIndex - 1,
+                                            uLength, &psOps[uOps]))
+               != 0)
+      {
+         uOps++;
+         uIndex = uNext;
+         iWild = 1;
+      }
+      else
+      {
+         psOps[uOps].eKind = OP_BYTE;
+         psOps[uOps++].ucByte = (unsigned char)c;
+      }
+   }
+   *puOps = uOps;
+   return iWild;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address just past the character that starts at pcName,
+   with any UTF-8 continuation bytes that follow its first byte. */
+
+static const char *Wildcard_skipChar(const char *pcName)
+{
+   pcName++;
+   while (((unsigned char)*pcName & 0xC0) == 0x80)
+      pcName++;
+   return pcName;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the uOps steps psOps match all of pcName.  A
+   failed match resumes just after the last star, one character
+   further on, so the time is at most proportional to the product of
+   the lengths. */
+
+static int Wildcard_match(const struct Op *psOps, size_t uOps,
+                          const char *pcName)
+{
+   size_t uOp = 0;
+   size_t uStarOp = 0;
+   const char *pcStar = NULL;
+   const struct Op *psOp;
+   unsigned char uc;
+
+   while (*pcName != '\0')
+   {
+      if (uOp < uOps)
+      {
+         psOp = &psOps[uOp];
+         uc = (unsigned char)*pcName;
+         if (psOp->eKind == OP_STAR)
+         {
+            uStarOp = uOp++;
+            pcStar = pcName;
+            continue;
+         }
+         if (psOp->eKind == OP_BYTE && psOp->ucByte == uc)
+         {
+            uOp++;
+            pcName++;
+            continue;
+         }
+         if (psOp->eKind == OP_ANY ||
+             (psOp->eKind == OP_SET &&
+              (psOp->aucSet[uc / 8] & (1 << (uc % 8)))))
+         {
+            uOp++;
+            pcName = Wildcard_skipChar(pcName);
+            continue;
+         }
+      }
+
+      /* Let the last star match one more character. */
+      if (pcStar == NULL)
+         return 0;
+      uOp = uStarOp + 1;
+      pcStar = Wildcard_skipChar(pcStar);
+      pcName = pcStar;
+   }
+
+   while (uOp < uOps && psOps[uOp].eKind == OP_STAR)
+      uOp++;
+   return uOp == uOps;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the entries of the directory open as iFd into *psListing,
+   replacing any that it held. */
+
+static void Wildcard_read(int iFd, struct Listing *psListing)
+{
+   char acBuffer[READ_SIZE];
+   struct LinuxDirent64 *psDirent;
+   size_t uPhysSize = READ_SIZE;
+   size_t uNameLength;
+   long lRead;
+   long lOffset;
+
+   free(psListing->pcEntries);
+   psListing->uSize = 0;
+   psListing->pcEntries = (char*)malloc(uPhysSize);
+   if (psListing->pcEntries == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   /* Read many entries with each system call. */
+   while ((lRead = syscall(SYS_getdents64, iFd, acBuffer,
+                           sizeof(acBuffer))) > 0)
+      for (lOffset = 0; lOffset < lRead;
+           lOffset += psDirent->d_reclen)
+      {
+         psDirent = (struct LinuxDirent64*)(acBuffer + lOffset);
+         uNameLength = strlen(psDirent->d_name);
+         if (psListing->uSize + uNameLength + 2 > uPhysSize)
+         {
+            uPhysSize = 2 * uPhysSize + uNameLength + 2;
+            psListing->pcEntries =
+               (char*)realloc(psListing->pcEntries, uPhysSize);
+            if (psListing->pcEntries == NULL)
+               {perror(getPgmName()); exit(EXIT_FAILURE);}
+         }
+         psListing->pcEntries[psListing->uSize++] =
+            (char)psDirent->d_type;
+         memcpy(psListing->pcEntries + psListing->uSize,
+                psDirent->d_name, uNameLength + 1);
+         psListing->uSize += uNameLength + 1;
+      }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the listing of the directory pcDir, reading the directory
+   only if the cache does not hold it as it is now, or NULL if it
+   cannot be read.  The listing stays valid until the next call. */
+
+static const struct Listing *Wildcard_list(const char *pcDir)
+{
+   struct Listing *psListing = NULL;
+   struct stat sStat;
+   struct timespec sNow;
+   int iFd;
+   size_t u;
+
+   iFd = open(pcDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (iFd == -1)
+      return NULL;
+   if (fstat(iFd, &sStat) == -1)
+   {
+      close(iFd);
+      return NULL;
+   }
+
+   /* Find the directory in the cache, or else the least recently used
+      slot. */
+   for (u = 0; u < CACHE_LENGTH; u++)
+   {
+      if (asCache[u].ulLastUse != 0 &&
+          asCache[u].uDev == sStat.st_dev &&
+          asCache[u].uIno == sStat.st_ino)
+      {
+         psListing = &asCache[u];
+         break;
+      }
+      if (psListing == NULL ||
+          asCache[u].ulLastUse < psListing->ulLastUse)
+         psListing = &asCache[u];
+   }
+
+   if (psListing->ulLastUse == 0 ||
+       psListing->uDev != sStat.st_dev ||
+       psListing->uIno != sStat.st_ino ||
+       psListing->sMtime.tv_sec != sStat.st_mtim.tv_sec ||
+       psListing->sMtime.tv_nsec != sStat.st_mtim.tv_nsec)
+   {
+      clock_gettime(CLOCK_REALTIME, &sNow);
+      Wildcard_read(iFd, psListing);
+      psListing->uDev = sStat.st_dev;
+      psListing->uIno = sStat.st_ino;
+      psListing->sMtime = sStat.st_mtim;
+
+      /* A change within the granularity of the clock may leave the
+         modification time as it is, so trust the listing only if the
+         directory had not changed for a second before it was read.
+         Otherwise an impossible time forces the next call to read it
+         again. */
+      if (sNow.tv_sec - sStat.st_mtim.tv_sec < 2)
+         psListing->sMtime.tv_nsec = -1;
+   }
+   close(iFd);
+
+   psListing->ulLastUse = ++ulUses;
+   return psListing;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a copy of the path pcPath to oMatches. */
+
+static void Wildcard_add(const char *pcPath, DynArray_T oMatches)
+{
+   char *pcCopy;
+
+   pcCopy = (char*)malloc(strlen(pcPath) + 1);
+   if (pcCopy == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+   strcpy(pcCopy, pcPath);
+   if (! DynArray_add(oMatches, pcCopy))
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the entry of type cType (a d_type value) whose
+   path is pcPath is a directory or a link to one. */
+
+static int Wildcard_isDirectory(char cType, const char *pcPath)
+{
+   struct stat sStat;
+
+   if (cType == DT_DIR)
+      return 1;
+   if (cType != DT_LNK && cType != DT_UNKNOWN)
+      return 0;
+   return stat(pcPath, &sStat) == 0 && S_ISDIR(sStat.st_mode);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oMatches the paths that consist of pcPath[0...uPathLength-1],
+   which is empty or ends with a slash, followed by what the rest of a
+   pattern, pcRest, matches.  pcPath has room for PATH_MAX bytes. */
+
+static void Wildcard_expandFrom(char *pcPath, size_t uPathLength,
+                                const char *pcRest,
+                                DynArray_T oMatches)
+{
+   const char *pcEnd = pcRest;
+   const struct Listing *psListing;
+   const char *pcEntry;
+   const char *pcName;
+   struct Op *psOps;
+   size_t uOps;
+   size_t uNameLength;
+   struct stat sStat;
+   DynArray_Storage sDirsStorage;
+   DynArray_T oDirs;
+   char *pcDir;
+   size_t u;
+
+   /* Find the end of the first component of pcRest. */
+   while (*pcEnd != '\0' && *pcEnd != '/')
+      if (*pcEnd++ == '\\' && *pcEnd != '\0')
+         pcEnd++;
+
+   psOps = (struct Op*)malloc(sizeof(struct Op) *
+                              ((size_t)(pcEnd - pcRest) + 1));
+   if (psOps == NULL)
+      {perror(getPgmName()); exit(EXIT_FAILURE);}
+
+   /* A component without wildcards is a name to look up. */
+   if (! Wildcard_compile(pcRest, (size_t)(pcEnd - pcRest), psOps,
+                          &uOps))
+   {
+      free(psOps);
+      if (uPathLength + (size_t)(pcEnd - pcRest) + 2 > PATH_MAX)
+         return;
+      memcpy(pcPath + uPathLength, pcRest, (size_t)(pcEnd - pcRest));
+      pcPath[uPathLength + (size_t)(pcEnd - pcRest)] = '\0';
+      Wildcard_unescape(pcPath + uPathLength);
+      uPathLength += strlen(pcPath + uPathLength);
+
+      if (*pcEnd == '\0')
+      {
+         if (lstat(pcPath, &sStat) == 0)
+            Wildcard_add(pcPath, oMatches);
+         return;
+      }
+      pcPath[uPathLength++] = '/';
+      pcPath[uPathLength] = '\0';
+      while (*pcEnd == '/')
+         pcEnd++;
+      if (*pcEnd == '\0')
+      {
+         if (stat(pcPath, &sStat) == 0 && S_ISDIR(sStat.st_mode))
+            Wildcard_add(pcPath, oMatches);
+      }
+      else
+         Wildcard_expandFrom(pcPath, uPathLength, pcEnd, oMatches);
+      return;
+   }
+
+   pcPath[uPathLength] = '\0';
+   psListing = Wildcard_list(uPathLength == 0 ? "." : pcPath);
+   if (psListing == NULL)
+   {
+      free(psOps);
+      return;
+   }
+
+   /* Collect the matching directories first, since reading them may
+      reuse the memory of psListing. */
+   oDirs = DynArray_init(&sDirsStorage);
+   for (pcEntry = psListing->pcEntries;
+        pcEntry < psListing->pcEntries + psListing->uSize;
+        pcEntry = pcName + uNameLength + 1)
+   {
+      pcName = pcEntry + 1;
+      uNameLength = strlen(pcName);
+
+      /* Only a period matches a leading period. */
+      if (strcmp(pcName, ".") == 0 || strcmp(pcName, "..") == 0 ||
+          (pcName[0] == '.' &&
+           (uOps == 0 || psOps[0].eKind != OP_BYTE ||
+            psOps[0].ucByte != '.')))
+         continue;
+      if (! Wildcard_match(psOps, uOps, pcName) ||
+          uPathLength + uNameLength + 2 > PATH_MAX)
+         continue;
+
+      strcpy(pcPath + uPathLength, pcName);
+      if (*pcEnd == '\0')
+         Wildcard_add(pcPath, oMatches);
+      else if (Wildcard_isDirectory(*pcEntry, pcPath))
+      {
+         pcDir = (char*)malloc(uNameLength + 1);
+         if (pcDir == NULL || ! DynArray_add(oDirs, pcDir))
+            {perror(getPgmName()); exit(EXIT_FAILURE);}
+         strcpy(pcDir, pcName);
+      }
+   }
+   free(psOps);
+
+   while (*pcEnd == '/')
+      pcEnd++;
+   for (u = 0; u < DynArray_getLength(oDirs); u++)
+   {
+      pcDir = (char*)DynArray_get(oDirs, u);
+      strcpy(pcPath + uPathLength, pcDir);
+      strcat(pcPath + uPathLength, "/");
+      if (*pcEnd == '\0')
+         Wildcard_add(pcPath, oMatches);
+      else
+         Wildcard_expandFrom(pcPath, uPathLength + strlen(pcDir) + 1,
+                             pcEnd, oMatches);
+      free(pcDir);
+   }
+   DynArray_destroy(oDirs);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the paths pvPath1 and pvPath2 by strcmp. */
+
+static int Wildcard_compare(const void *pvPath1, const void *pvPath2)
+{
+   return strcmp((const char*)pvPath1, (const char*)pvPath2);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Wildcard_expand(const char *pcPattern, DynArray_T oMatches)
+{
+   char acPath[PATH_MAX];
+   size_t uPathLength = 0;
+
+   assert(pcPattern != NULL);
+   assert(oMatches != NULL);
+   assert(DynArray_getLength(oMatches) == 0);
+
+   if (*pcPattern == '/')
+   {
+      acPath[uPathLength++] = '/';
+      while (*pcPattern == '/')
+         pcPattern++;
+   }
+   if (*pcPattern == '\0')
+      return 0;
+
+   Wildcard_expandFrom(acPath, uPathLength, pcPattern, oMatches);
+   DynArray_sort(oMatches, Wildcard_compare);
+   return DynArray_getLength(oMatches);
+}
@@ -0,0 +1,43 @@
+/*--------------------------------------------------------------------*/
+/* wildcard.h                                                         */
+/* Author: Jingran Zhou                                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef WILDCARD_INCLUDED
+#define WILDCARD_INCLUDED
+
+#include "dynarray.h"
+#include <stddef.h>
+
+/* A pattern is a path whose components may contain the wildcards *
+   (any string), ? (any one character) and [...] (any one character in
+   the set, such as [a-z_], or not in it, such as [!0-9] or [^0-9]).
+   A backslash makes the character that follows it match itself.
+   Wildcards do not match a slash, nor a leading period, and patterns
+   never match the entries . and .. of a directory. */
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff pcPattern contains a wildcard that is not made
+   to match itself by a backslash. */
+
+int Wildcard_isPattern(const char *pcPattern);
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oMatches, which must be empty, the paths that pcPattern
+   matches, sorted by strcmp.  Each path is in its own memory chunk,
+   which the caller owns.  Return the number of paths.  Recently read
+   directories are remembered, and read again only once they change. */
+
+size_t Wildcard_expand(const char *pcPattern, DynArray_T oMatches);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove from pcPattern the backslashes that make the characters that
+   follow them match themselves, so that it is the string that it
+   matches when it contains no wildcards. */
+
+void Wildcard_unescape(char *pcPattern);
+
+#endif